@@ -0,0 +1,147 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// AIMD limit on the number of entries an extraction keeps in flight. The
+// right level depends on the device: an NVMe drive wants dozens of requests
+// queued, a spinning disk thrashes with more than a few, a network share
+// needs enough to hide its latency.
+//
+// Completions are grouped into windows of at least WINDOW that turned the
+// whole limit over twice. Each window's throughput is compared with the
+// previous window's, and the limit climbs towards the better side:
+//   - throughput up: keep going the way the last step went;
+//   - throughput down: turn around;
+//   - flat: if the last step was up and latency grew, the extra requests
+//     only queued at the device, so step down; otherwise probe one higher
+//     when the limit was actually reached.
+// Steps up add one (doubling until the first step down), steps down cut a
+// quarter.
+class AdaptiveConcurrency {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    AdaptiveConcurrency(size_t initial, size_t maximum, size_t minimum = 1)
+        : minimum(std::max<size_t>(1, minimum)), maximum(std::max(maximum, this->minimum)),
+          limit(std::clamp(initial, this->minimum, this->maximum)) {
+        peak = lowest = limit.load();
+    }
+
+    size_t Limit() const { return limit.load(std::memory_order_relaxed); }
+
+    // Takes an in-flight slot if the limit allows another entry.
+    bool TryAcquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inFlight >= limit.load()) return false;
+        if (++inFlight >= limit.load()) window.saturated = true;
+        return true;
+    }
+
+    // Frees the slot of an entry that moved `bytes` in `latency`.
+    void Release(uint64_t bytes, Clock::duration latency) {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight--;
+
+        Clock::time_point now = Clock::now();
+        if (window.completions == 0 && window.start == Clock::time_point()) window.start = now - latency;
+        window.completions++;
+        window.bytes += bytes;
+        window.latency += latency;
+        totalLatency += latency;
+        totalEntries++;
+
+        if (now - window.start < WINDOW || window.completions < 2 * limit.load()) return;
+        Adjust(now);
+    }
+
+    // Frees the slot of an entry that was dropped without doing any I/O.
+    void Release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight--;
+    }
+
+    // "level 6 (2..12), 143.2 MB/s best, 4.1 ms mean latency"
+    std::string Summary() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        char text[128];
+        snprintf(text, sizeof(text), "level %zu (%zu..%zu), %.1f MB/s best, %.1f ms mean latency", limit.load(), lowest, peak,
+                 bestThroughput / (1024.0 * 1024.0),
+                 totalEntries ? std::chrono::duration<double, std::milli>(totalLatency).count() / totalEntries : 0.0);
+        return text;
+    }
+
+private:
+    static constexpr Clock::duration WINDOW = std::chrono::milliseconds(250);
+
+    // Counted per entry on top of its bytes, so a window of small files
+    // (bound by operations, not bandwidth) does not look idle.
+    static constexpr uint64_t ENTRY_COST = 64 * 1024;
+
+    struct Window {
+        Clock::time_point start;
+        size_t completions = 0;
+        uint64_t bytes = 0;
+        Clock::duration latency{};
+        bool saturated = false;
+    };
+
+    void Adjust(Clock::time_point now) {
+        double seconds = std::chrono::duration<double>(now - window.start).count();
+        double throughput = (window.bytes + window.completions * ENTRY_COST) / seconds;
+        double latency = std::chrono::duration<double>(window.latency).count() / window.completions;
+        bestThroughput = std::max(bestThroughput, window.bytes / seconds);
+
+        int step = 0;
+        if (previousThroughput == 0) {
+            step = window.saturated ? 1 : 0;
+        } else if (throughput > previousThroughput * 1.1) {
+            step = lastStep < 0 ? -1 : 1;
+        } else if (throughput < previousThroughput * 0.9) {
+            step = lastStep < 0 ? 1 : -1;
+        } else if (lastStep > 0 && latency > previousLatency * 1.1) {
+            step = -1;
+        } else if (window.saturated) {
+            step = 1;
+        }
+
+        size_t level = limit.load();
+        if (step > 0) level = slowStart ? level * 2 : level + 1;
+        if (step < 0) {
+            slowStart = false;
+            level -= std::max<size_t>(1, level / 4);
+        }
+        level = std::clamp(level, minimum, maximum);
+        limit.store(level);
+        peak = std::max(peak, level);
+        lowest = std::min(lowest, level);
+
+        lastStep = step;
+        previousThroughput = throughput;
+        previousLatency = latency;
+        window = Window();
+        window.start = now;
+        window.saturated = inFlight >= level;
+    }
+
+    const size_t minimum;
+    const size_t maximum;
+    std::atomic<size_t> limit;
+
+    mutable std::mutex mutex;
+    size_t inFlight = 0;
+    Window window;
+    bool slowStart = true;
+    int lastStep = 0;
+    double previousThroughput = 0;
+    double previousLatency = 0;
+
+    size_t peak = 0, lowest = 0;
+    double bestThroughput = 0;
+    uint64_t totalEntries = 0;
+    Clock::duration totalLatency{};
+};
@@ -1,2644 +1,5321 @@
-#define NOMINMAX
-#define _CRT_SECURE_NO_WARNINGS
-#ifndef TCM_GETITEMCOUNT
-#define TCM_GETITEMCOUNT (TCM_FIRST + 4)
-#endif
-#include "wcxhead.h"
-#include "resource.h"
-// EDDS és DDS konverterek eltávolítva
-#include "ThreadPool.h"
-
-#include <windows.h>
-#include <commctrl.h>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <algorithm>
-#include <stdexcept>
-#include <zlib.h>
-#include <memory>
-#include <map>
-#include <ctime>
-#include <assert.h>
-#include <filesystem>
-#include <cstdint>
-#include <cstring>
-#include <sstream>
-#include <iomanip>
-#include <cctype>
-#include <unordered_set>
-#include <mutex>
-#include <span>
-#include <queue>
-#include <atomic>
-#include <unordered_map>
-#include <thread>
-#include <condition_variable>
-#include <functional>
-#include <future>
-#include <type_traits>
-#include <tlhelp32.h>
-
-namespace fs = std::filesystem;
-
-// EddsTargetFormat enum és hivatkozás eltávolítva
-
-const char* PLUGIN_VERSION_STRING = "1.2.0";
-
-extern std::unique_ptr<ThreadPool> g_ThreadPool;
-
-class PakArchive;
-class PakIndex;
-
-class PakEntry {
-public:
-	enum class CompressionType : uint32_t {
-		None = 0,
-		Zlib = 0x106
-	};
-
-	uint32_t timestamp = 0;
-	std::string name = "";
-	uint32_t offset = 0;
-	uint32_t size = 0;
-	uint32_t originalSize = 0;
-	CompressionType compression = CompressionType::None;
-	bool isDirectory = false;
-	std::vector<std::shared_ptr<PakEntry>> children;
-};
-
-#include "SmartExtractor.h"
-#include "pak_index.h"
-
-void LogError(const std::string& message);
-void LogInfo(const std::string& message);
-
-static std::ofstream debugLog;
-static bool logInitialized = false;
-static std::mutex g_LogMutex;
-std::mutex g_CallbackMutex;
-static std::mutex g_SearchTextMutex;
-
-std::vector<PakArchive*> g_OpenedArchives;
-std::mutex g_ArchivesMutex;
-
-// Konverziós kapcsolók eltávolítva
-bool g_EnableLogInfo = false;
-bool g_EnableSmartExtract = false;
-bool g_KeepDirectoryStructure = true;
-bool g_ShowExtractPrompt = true;
-static std::wstring SearchTextW;
-
-static std::unordered_map<std::string, std::unique_ptr<std::mutex>> g_FileWriteLocks;
-static std::mutex g_FileWriteLocksMutex;
-
-const char* const INI_KEY_SMART_EXTRACT = "EnableSmartExtract";
-const char* const INI_KEY_KEEP_STRUCT = "KeepDirectoryStructure";
-const char* const INI_FILE_NAME = "pak_plugin.ini";
-const char* const INI_SECTION_NAME = "Settings";
-// EDDS kulcsok eltávolítva az INI-ből
-const char* const INI_KEY_LOG_INFO = "EnableLogInfo";
-const char* const LOG_FILE_NAME = "pak_plugin.log";
-
-static HMODULE g_hModule = NULL;
-
-static std::string GetPluginPath() {
-	char path[MAX_PATH];
-	if (g_hModule != NULL) {
-		GetModuleFileNameA(g_hModule, path, MAX_PATH);
-	} else {
-		GetModuleFileNameA(NULL, path, MAX_PATH);
-	}
-	std::filesystem::path plugin_path(path);
-	return plugin_path.parent_path().string();
-}
-
-static std::string GetLogPath() {
-	return GetPluginPath() + "\\" + LOG_FILE_NAME;
-}
-
-static std::string GetIniPath() {
-	return GetPluginPath() + "\\" + INI_FILE_NAME;
-}
-
-static void CheckLogRotation() {
-	std::string path = GetLogPath();
-
-	std::error_code ec;
-	if (fs::exists(path, ec)) {
-		if (fs::file_size(path, ec) > 5 * 1024 * 1024) {
-			if (debugLog.is_open()) debugLog.close();
-
-			debugLog.open(path, std::ios::out | std::ios::trunc);
-
-			if (debugLog.is_open()) {
-				debugLog << "[INFO] Log file rotated (size limit reached, cleared).\n";
-				debugLog.flush();
-			}
-		}
-	}
-}
-
-void LogError(const std::string& message) {
-	std::lock_guard<std::mutex> lock(g_LogMutex);
-	CheckLogRotation();
-
-	if (logInitialized && debugLog.is_open()) {
-		debugLog << "[ERROR] " << message << "\n";
-		debugLog.flush();
-	}
-}
-
-void LogInfo(const std::string& message) {
-	if (!g_EnableLogInfo) return;
-	std::lock_guard<std::mutex> lock(g_LogMutex);
-	CheckLogRotation();
-
-	if (logInitialized && debugLog.is_open()) {
-		debugLog << "[INFO] " << message << "\n";
-		debugLog.flush();
-	}
-}
-
-static void LoadSettings() {
-	std::string iniPath = GetIniPath();
-	g_EnableLogInfo          = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_LOG_INFO, 0, iniPath.c_str()) != 0;
-	g_EnableSmartExtract    = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_SMART_EXTRACT, 1, iniPath.c_str()) != 0;
-	g_KeepDirectoryStructure = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_KEEP_STRUCT, 1, iniPath.c_str()) != 0;
-	g_ShowExtractPrompt      = GetPrivateProfileIntA(INI_SECTION_NAME, "ShowExtractPrompt", 1, iniPath.c_str()) != 0;
-}
-
-static void SaveSettings() {
-	std::string iniPath = GetIniPath();
-	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_LOG_INFO, g_EnableLogInfo ? "1" : "0", iniPath.c_str());
-	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SMART_EXTRACT, g_EnableSmartExtract ? "1" : "0", iniPath.c_str());
-	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_KEEP_STRUCT, g_KeepDirectoryStructure ? "1" : "0", iniPath.c_str());
-	WritePrivateProfileStringA(INI_SECTION_NAME, "ShowExtractPrompt", g_ShowExtractPrompt ? "1" : "0", iniPath.c_str());
-}
-
-static unsigned int SystemTimeToDosDateTime(const SYSTEMTIME& st) {
-	const unsigned int year   = static_cast<unsigned int>(st.wYear);
-	const unsigned int month  = static_cast<unsigned int>(st.wMonth);
-	const unsigned int day    = static_cast<unsigned int>(st.wDay);
-	const unsigned int hour   = static_cast<unsigned int>(st.wHour);
-	const unsigned int minute = static_cast<unsigned int>(st.wMinute);
-	const unsigned int second = static_cast<unsigned int>(st.wSecond);
-	unsigned int dosDate = ((year - 1980) << 9) | (month << 5) | day;
-	unsigned int dosTime = (hour << 11) | (minute << 5) | (second / 2);
-	return (dosDate << 16) | (dosTime & 0xFFFF);
-}
-
-static std::string WStringToUTF8(const wchar_t* ws) {
-	if (!ws || ws[0] == L'\0') return "";
-	int len = (int)wcslen(ws);
-	int size_needed = WideCharToMultiByte(CP_UTF8, 0, ws, len, nullptr, 0, nullptr, nullptr);
-	if (size_needed <= 0) return "";
-	std::string result(size_needed, 0);
-	WideCharToMultiByte(CP_UTF8, 0, ws, len, &result[0], size_needed, nullptr, nullptr);
-	return result;
-}
-
-static std::string WStringToUTF8(const std::wstring& ws) {
-	return WStringToUTF8(ws.c_str());
-}
-
-static std::string WCharToUTF8(const WCHAR* ws) {
-	return WStringToUTF8(ws);
-}
-
-static std::wstring UTF8ToWString(const std::string& str) {
-	if (str.empty()) return L"";
-	int size_needed = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), NULL, 0);
-	if (size_needed <= 0) return L"";
-	std::wstring wstrTo(size_needed, 0);
-	MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), &wstrTo[0], size_needed);
-	return wstrTo;
-}
-
-class PakArchive {
-private:
-	std::shared_ptr<PakEntry> root;
-	std::vector<std::shared_ptr<PakEntry>> flatEntries;
-	std::string filename;
-	bool initialized = false;
-	long long actualFileSize = 0;
-
-	HANDLE hFile = INVALID_HANDLE_VALUE;
-
-	std::atomic<int> m_CurrentIndex{0};
-	std::atomic<int> m_LastIndex{-1};
-	std::mutex indexMutex;
-	mutable std::mutex m_FileMutex;
-
-	std::unique_ptr<PakIndex> m_index;
-	tProcessDataProc m_pProcessDataProc = nullptr;
-
-	std::unordered_map<std::string, int> m_LookupTable;
-
-	struct IffChunk {
-		char id[4];
-		uint32_t size;
-		uint64_t dataStart;
-		uint64_t dataEnd;
-	};
-
-	bool InternalRead(void* buffer, DWORD size) {
-		DWORD bytesRead = 0;
-		return ReadFile(hFile, buffer, size, &bytesRead, NULL) && bytesRead == size;
-	}
-
-	uint32_t ReadU32BE() {
-		uint32_t val;
-		if (!InternalRead(&val, 4)) throw std::runtime_error("Read error (U32BE)");
-		return _byteswap_ulong(val);
-	}
-
-	uint32_t ReadU32LE() {
-		uint32_t val;
-		if (!InternalRead(&val, 4)) throw std::runtime_error("Read error (U32LE)");
-		return val;
-	}
-
-	uint8_t ReadU8() {
-		uint8_t val;
-		if (!InternalRead(&val, 1)) throw std::runtime_error("Read error (U8)");
-		return val;
-	}
-
-	std::string ReadString(uint8_t length) {
-		if (length == 0) return "";
-		std::string str(length, '\0');
-		if (!InternalRead(&str[0], length)) throw std::runtime_error("Read error (String)");
-		return str;
-	}
-
-	bool ReadNextChunk(IffChunk& chunk) {
-		LARGE_INTEGER currentPos;
-		currentPos.QuadPart = 0;
-		if (!SetFilePointerEx(hFile, currentPos, &currentPos, FILE_CURRENT)) return false;
-
-		if (currentPos.QuadPart + 8 > actualFileSize) return false;
-
-		if (!InternalRead(chunk.id, 4)) return false;
-		chunk.size = ReadU32BE();
-		chunk.dataStart = currentPos.QuadPart + 8;
-		chunk.dataEnd = chunk.dataStart + chunk.size;
-
-		if (chunk.dataEnd > (uint64_t)actualFileSize) {
-			LogError("Chunk '" + std::string(chunk.id, 4) + "' size exceeds file bounds.");
-			return false;
-		}
-		return true;
-	}
-
-	void ProcessHeadChunk(const IffChunk& chunk) {
-		LARGE_INTEGER li;
-		li.QuadPart = chunk.dataEnd;
-		SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
-	}
-
-	void ProcessFileChunk(const IffChunk& chunk) {
-		uint8_t entryType = ReadU8();
-		uint8_t nameLength = ReadU8();
-		std::string name = ReadString(nameLength);
-
-		if (entryType == 0) root->children.push_back(ReadDirectoryEntry(name));
-		else root->children.push_back(ReadFileEntry(name));
-
-		LARGE_INTEGER li;
-		li.QuadPart = chunk.dataEnd;
-		SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
-	}
-
-	std::shared_ptr<PakEntry> ReadDirectoryEntry(const std::string& name) {
-		auto entry = std::make_shared<PakEntry>();
-		entry->name = name;
-		entry->isDirectory = true;
-
-		uint32_t childCount = ReadU32LE();
-
-		entry->timestamp = static_cast<uint32_t>(time(nullptr));
-
-		for (uint32_t i = 0; i < childCount; i++) {
-			uint8_t childType = ReadU8();
-			uint8_t childNameLength = ReadU8();
-			std::string childName = ReadString(childNameLength);
-
-			if (childType == 0) {
-				entry->children.push_back(ReadDirectoryEntry(childName));
-			} else {
-				entry->children.push_back(ReadFileEntry(childName));
-			}
-		}
-		return entry;
-	}
-
-	std::shared_ptr<PakEntry> ReadFileEntry(const std::string& name) {
-		auto entry = std::make_shared<PakEntry>();
-		entry->name = name;
-		entry->isDirectory = false;
-		entry->offset = ReadU32LE();
-		entry->size = ReadU32LE();
-		entry->originalSize = ReadU32LE();
-
-		LARGE_INTEGER li; li.QuadPart = 4;
-		SetFilePointerEx(hFile, li, NULL, FILE_CURRENT);
-		entry->compression = static_cast<PakEntry::CompressionType>(ReadU32BE());
-		entry->timestamp = ReadU32LE();
-
-		return entry;
-	}
-
-	void FlattenEntries(const std::shared_ptr<PakEntry>& entry, const std::string& path = "") {
-		std::string fullPath = path;
-		if (entry.get() != root.get()) {
-			if (!fullPath.empty()) fullPath += "\\";
-			fullPath += entry->name;
-		}
-		if (entry.get() != root.get()) {
-			auto flatEntry = std::make_shared<PakEntry>(*entry);
-			flatEntry->name = fullPath;
-			flatEntries.push_back(flatEntry);
-		}
-		for (const auto& child : entry->children) FlattenEntries(child, fullPath);
-	}
-
-	std::string NormalizePath(const std::string& name) const {
-		std::string result = name;
-		std::replace(result.begin(), result.end(), '/', '\\');
-		std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-		return result;
-	}
-
-public:
-	void AddVirtualEntry(const std::string& name) {
-		auto entry = std::make_shared<PakEntry>();
-		entry->name = name;
-		entry->isDirectory = false;
-		entry->size = 1;
-		entry->originalSize = 1;
-		entry->offset = 0;
-		entry->compression = PakEntry::CompressionType::None;
-
-		entry->timestamp = static_cast<uint32_t>(time(nullptr));
-
-		flatEntries.push_back(entry);
-	}
-
-	void BuildIndex() {
-		m_LookupTable.clear();
-
-		for (size_t i = 0; i < flatEntries.size(); ++i) {
-			std::string normalizedName = NormalizePath(flatEntries[i]->name);
-			m_LookupTable[normalizedName] = (int)i;
-		}
-
-		if (m_index && !flatEntries.empty()) {
-			m_index->Build(flatEntries);
-		}
-	}
-
-	int FindIndexByName(const std::string& name) const {
-		auto it = m_LookupTable.find(NormalizePath(name));
-
-		if (it != m_LookupTable.end()) {
-			return it->second;
-		}
-		return -1;
-	}
-
-	std::string GetFilename() const { return filename; }
-
-	int GetEntryIndex(const PakEntry* entry) const {
-		if (!entry || flatEntries.empty()) return -1;
-
-		for (size_t i = 0; i < flatEntries.size(); ++i) {
-			if (flatEntries[i].get() == entry) return (int)i;
-		}
-
-		return -1;
-	}
-
-	const PakEntry* FindEntryByName(const std::string& name) const {
-		std::string norm = name;
-		std::replace(norm.begin(), norm.end(), '/', '\\');
-		std::transform(norm.begin(), norm.end(), norm.begin(), ::tolower);
-
-		LogInfo("[FindEntry] SEARCH: " + norm);
-
-		auto tryFindExact = [&](const std::string& p) -> const PakEntry* {
-			auto it = m_LookupTable.find(p);
-			if (it != m_LookupTable.end()) {
-				return flatEntries[it->second].get();
-			}
-
-			{
-				std::lock_guard<std::mutex> lock(g_ArchivesMutex);
-				for (auto* otherArchive : g_OpenedArchives) {
-					if (otherArchive == this) continue;
-
-					auto itOther = otherArchive->m_LookupTable.find(p);
-					if (itOther != otherArchive->m_LookupTable.end()) {
-						return otherArchive->flatEntries[itOther->second].get();
-					}
-
-					if (otherArchive->m_LookupTable.empty()) {
-						for (const auto& entry : otherArchive->flatEntries) {
-							std::string entryNorm = entry->name;
-							std::replace(entryNorm.begin(), entryNorm.end(), '/', '\\');
-							std::transform(entryNorm.begin(), entryNorm.end(), entryNorm.begin(), ::tolower);
-							if (entryNorm == p) return entry.get();
-						}
-					}
-				}
-			}
-			return nullptr;
-		};
-
-		if (auto* e = tryFindExact(norm)) {
-			LogInfo("[FindEntry] FULL MATCH: " + norm);
-			return e;
-		}
-
-		if (norm.find("assets\\") != 0 && norm.find("common\\") != 0) {
-			std::string fixed = "assets\\" + norm;
-			if (auto* e = tryFindExact(fixed)) {
-				LogInfo("[FindEntry] FIXED (assets\\ prefix): " + fixed);
-				return e;
-			}
-		}
-
-		if (norm.find("common\\") == std::string::npos) {
-			std::string fixed = "common\\" + norm;
-			if (auto* e = tryFindExact(fixed)) {
-				LogInfo("[FindEntry] FIXED (common\\ prefix): " + fixed);
-				return e;
-			}
-		}
-
-		LogInfo("[FindEntry] NOT FOUND: " + norm);
-		return nullptr;
-	}
-
-	std::vector<uint8_t> DecompressEntryData(const PakEntry* entry) {
-		if (!entry || entry->isDirectory) {
-			throw std::runtime_error("Invalid or directory entry for decompression.");
-		}
-
-		if (entry->size == 0) {
-			return {};
-		}
-
-		std::lock_guard<std::mutex> readLock(m_FileMutex);
-
-		LARGE_INTEGER li;
-		li.QuadPart = entry->offset;
-		if (!SetFilePointerEx(hFile, li, NULL, FILE_BEGIN)) {
-			throw std::runtime_error("Failed to seek to entry: " + entry->name);
-		}
-
-		uint64_t endPos = static_cast<uint64_t>(entry->offset) + entry->size;
-		if (endPos > static_cast<uint64_t>(actualFileSize)) {
-			LogError("[DecompressEntryData] Entry data goes beyond archive bounds: " + entry->name);
-			throw std::runtime_error("Entry data out of bounds.");
-		}
-
-		if (entry->size > 1024 * 1024 * 1024) {
-			LogError("[DecompressEntryData] Compressed entry too large (over 1GB): " + entry->name);
-			throw std::runtime_error("Compressed entry too large");
-		}
-
-		std::vector<uint8_t> rawBuffer(entry->size);
-		DWORD read = 0;
-		if (!ReadFile(hFile, rawBuffer.data(), entry->size, &read, NULL) || read != entry->size) {
-			LogError("[DecompressEntryData] Read failed for " + entry->name);
-			throw std::runtime_error("Read failed.");
-		}
-
-		if (entry->compression == PakEntry::CompressionType::Zlib) {
-			if (entry->originalSize == 0) {
-				LogError("[DecompressEntryData] originalSize is 0 for compressed entry: " + entry->name);
-				throw std::runtime_error("Invalid original size");
-			}
-
-			double ratio = (entry->size > 0) ? (static_cast<double>(entry->originalSize) / entry->size) : 0;
-
-			if (entry->originalSize > 1024 * 1024 * 1024 || ratio > 1000.0) {
-				LogError("[DecompressEntryData] Compression bomb detected (Ratio: " + std::to_string(ratio) + "): " + entry->name);
-				throw std::runtime_error("Uncompressed size too large or suspicious ratio");
-			}
-
-			std::vector<uint8_t> processedContent(entry->originalSize);
-			uLongf destLen = entry->originalSize;
-			int zResult = uncompress(
-				reinterpret_cast<Bytef*>(processedContent.data()), &destLen,
-				reinterpret_cast<const Bytef*>(rawBuffer.data()), entry->size);
-
-			if (zResult != Z_OK || destLen != entry->originalSize) {
-				LogError("[DecompressEntryData] Zlib error code: " + std::to_string(zResult) + " for " + entry->name);
-				throw std::runtime_error("Zlib decompression failed.");
-			}
-			return processedContent;
-		}
-
-		return rawBuffer;
-	}
-
-	PakArchive(const std::string& filename) : filename(filename) {
-		try {
-			hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-			if (hFile == INVALID_HANDLE_VALUE) {
-				LogError("Failed to open PAK file (WinAPI): " + filename);
-				throw std::runtime_error("Failed to open PAK file");
-			}
-
-			std::lock_guard<std::mutex> lock(m_FileMutex);
-
-			LARGE_INTEGER fileSize;
-			if (!GetFileSizeEx(hFile, &fileSize)) throw std::runtime_error("Failed to get file size");
-			actualFileSize = fileSize.QuadPart;
-
-			char formSig[4];
-			if (!InternalRead(formSig, 4) || memcmp(formSig, "FORM", 4) != 0) {
-				LogError("PAK file does not start with 'FORM' signature: " + filename);
-				throw std::runtime_error("Invalid PAK signature.");
-			}
-
-			uint32_t formSize = ReadU32BE();
-			uint64_t expectedTotalSize = 8 + (uint64_t)formSize;
-			if (actualFileSize != static_cast<long long>(expectedTotalSize)) {
-				LogError("Archive header size mismatch. Expected: " + std::to_string(expectedTotalSize));
-				throw std::runtime_error("Archive size mismatch.");
-			}
-
-			char pac1Sig[4];
-			if (!InternalRead(pac1Sig, 4) || memcmp(pac1Sig, "PAC1", 4) != 0) {
-				LogError("PAK file FORM chunk type is not 'PAC1'.");
-				throw std::runtime_error("Invalid PAK type.");
-			}
-
-			root = std::make_shared<PakEntry>();
-			root->name = "";
-			root->isDirectory = true;
-
-			while (true) {
-				LARGE_INTEGER cur; cur.QuadPart = 0;
-				SetFilePointerEx(hFile, cur, &cur, FILE_CURRENT);
-				if ((long long)cur.QuadPart >= actualFileSize) break;
-
-				IffChunk chunk;
-				if (!ReadNextChunk(chunk)) break;
-
-				if (strncmp(chunk.id, "HEAD", 4) == 0) ProcessHeadChunk(chunk);
-				else if (strncmp(chunk.id, "FILE", 4) == 0) ProcessFileChunk(chunk);
-				else if (strncmp(chunk.id, "DATA", 4) == 0) {
-					LARGE_INTEGER li; li.QuadPart = chunk.dataEnd;
-					SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
-				}
-				else {
-					LogInfo("Skipping unknown chunk: " + std::string(chunk.id, 4));
-					LARGE_INTEGER li; li.QuadPart = chunk.dataEnd;
-					SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
-				}
-			}
-			if (root) FlattenEntries(root);
-
-			m_index = std::make_unique<PakIndex>();
-			m_index->Build(flatEntries);
-
-			{
-				std::lock_guard<std::mutex> lock(g_ArchivesMutex);
-				g_OpenedArchives.push_back(this);
-			}
-
-			ResetIndex();
-
-			initialized = true;
-		} catch (const std::exception& ex) {
-			LogError("PakArchive construction EXCEPTION: " + std::string(ex.what()));
-			initialized = false;
-		}
-	}
-
-	~PakArchive() {
-		{
-			std::lock_guard<std::mutex> lock(g_ArchivesMutex);
-			auto it = std::find(g_OpenedArchives.begin(), g_OpenedArchives.end(), this);
-			if (it != g_OpenedArchives.end()) g_OpenedArchives.erase(it);
-		}
-
-		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
-	}
-
-	bool IsInitialized() const { return initialized; }
-	int GetEntryCount() const { return static_cast<int>(flatEntries.size()); }
-
-	const PakEntry* GetEntry(int index) const {
-		if (index < 0 || index >= static_cast<int>(flatEntries.size())) return nullptr;
-		return flatEntries[index].get();
-	}
-
-	int GetAndIncrementIndex() {
-		return m_CurrentIndex.fetch_add(1, std::memory_order_relaxed);
-	}
-
-	int GetLastProcessedIndex() {
-		return m_CurrentIndex.load(std::memory_order_relaxed) - 1;
-	}
-
-	void SetLastIndex(int idx) {
-		m_LastIndex.store(idx, std::memory_order_relaxed);
-	}
-
-	int GetLastIndex() const {
-		return m_LastIndex.load(std::memory_order_relaxed);
-	}
-
-	void ResetIndex() {
-		std::lock_guard<std::mutex> lock(indexMutex);
-		m_CurrentIndex.store(0, std::memory_order_relaxed);
-		m_LastIndex.store(-1, std::memory_order_relaxed);
-	}
-
-	// ConversionSnapshot hivatkozások eltávolítva
-
-	void SetProcessDataProc(tProcessDataProc p) { m_pProcessDataProc = p; }
-	tProcessDataProc GetProcessDataProc() const { return m_pProcessDataProc; }
-
-static fs::path BuildFinalPath(const std::string& base, const std::string& entryName) {
-		fs::path basePath = base.empty()
-			? fs::current_path()
-			: fs::absolute(fs::path(base));
-
-		if (basePath.has_filename() && basePath.extension() != "") {
-			basePath = basePath.parent_path();
-		}
-
-		std::string safePath = g_KeepDirectoryStructure
-			? entryName
-			: fs::path(entryName).filename().string();
-
-		size_t drivePos = safePath.find(':');
-		if (drivePos != std::string::npos) {
-			safePath = safePath.substr(drivePos + 1);
-		}
-
-		while (!safePath.empty() && (safePath[0] == '\\' || safePath[0] == '/')) {
-			safePath.erase(0, 1);
-		}
-
-		std::replace(safePath.begin(), safePath.end(), '/', '\\');
-
-		fs::path finalPath = basePath / fs::path(safePath);
-
-		return fs::absolute(finalPath).lexically_normal();
-	}
-
-	// ============================
-	// 🔹 PathToLog
-	// ============================
-	static inline std::string PathToLog(const fs::path& p) {
-		auto u8 = p.u8string();
-		return std::string(reinterpret_cast<const char*>(u8.data()), u8.size());
-	}
-
-	// ============================
-	// 🔹 Decompress
-	// ============================
-	static bool DecompressEntryFast(PakArchive* arc, const PakEntry* entry, std::vector<uint8_t>& out) {
-		static std::mutex g_DecompressMutex;
-		std::lock_guard<std::mutex> lock(g_DecompressMutex);
-
-		out = arc->DecompressEntryData(entry);
-
-		if (out.empty() && entry->originalSize > 0) {
-			LogError("[ExtractFile] Decompression failed: " + entry->name);
-			return false;
-		}
-		return true;
-	}
-
-	// ============================
-	// 🔹 Path resolve
-	// ============================
-	static fs::path ResolveTargetPath(const std::string& destPath, const PakEntry* entry, bool& isDirectFileTarget) {
-		fs::path input(destPath);
-		isDirectFileTarget = input.has_filename() && !input.extension().empty();
-
-		if (isDirectFileTarget) {
-			LogInfo("[ExtractFile][DEBUG] Direct Target: " + PathToLog(input));
-			return input;
-		}
-
-		fs::path result = PakArchive::BuildFinalPath(destPath, entry->name);
-		LogInfo("[ExtractFile][DEBUG] Directory Target: " + PathToLog(result));
-		return result;
-	}
-
-	// ============================
-	// 🔹 Ensure dir (FAST PATH)
-	// ============================
-	static inline bool EnsureDirFast(const fs::path& path) {
-		auto dir = path.parent_path();
-		if (dir.empty()) return true;
-
-		std::error_code ec;
-		if (!fs::exists(dir) && !fs::create_directories(dir, ec) && ec) {
-			LogError("[ExtractFile] Dir create failed: " + PathToLog(dir));
-			return false;
-		}
-		return true;
-	}
-
-	// ============================
-	// 🔹 Write RAW (BUFFERED LARGE WRITE + SEQ FLAG)
-	// ============================
-	static bool WriteRawFast(const fs::path& path, const uint8_t* data, size_t size) {
-		HANDLE hFile = CreateFileW(
-			path.wstring().c_str(),
-			GENERIC_WRITE,
-			FILE_SHARE_READ,
-			NULL,
-			CREATE_ALWAYS,
-			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
-			NULL
-		);
-
-		if (hFile == INVALID_HANDLE_VALUE) return false;
-
-		DWORD written = 0;
-		BOOL ok = WriteFile(hFile, data, (DWORD)size, &written, NULL);
-
-		CloseHandle(hFile);
-		return ok && (written == (DWORD)size);
-	}
-
-	// ============================
-	// 🔹 Callback
-	// ============================
-	static bool ReportProgressFast(PakArchive* arc, const PakEntry* entry) {
-		auto cb = arc->GetProcessDataProc();
-		if (!cb) return true;
-
-		const size_t CHUNK = 16384;
-		size_t total = 0;
-
-		if (entry->originalSize == 0) {
-			std::lock_guard<std::mutex> lock(g_CallbackMutex);
-			cb(const_cast<char*>(entry->name.c_str()), 0);
-			return true;
-		}
-
-		while (total < entry->originalSize) {
-			size_t step = std::min(CHUNK, (size_t)entry->originalSize - total);
-
-			int res = 0;
-			{
-				std::lock_guard<std::mutex> lock(g_CallbackMutex);
-				res = cb(const_cast<char*>(entry->name.c_str()), (int)step);
-			}
-
-			if (res == 0) return false;
-			total += step;
-		}
-
-		return true;
-	}
-
-	// ============================
-	// 🔥 ExtractFile
-	// ============================
-	bool ExtractFile(int index, const std::string& destPath) {
-		const PakEntry* entry = GetEntry(index);
-
-		if (!entry || entry->isDirectory) {
-			LogError("[ExtractFile] Invalid entry: " + std::to_string(index));
-			return false;
-		}
-
-		try {
-			// 1️⃣ Path resolve & Early check
-			bool isDirect = false;
-			fs::path finalPath = ResolveTargetPath(destPath, entry, isDirect);
-
-			if (!EnsureDirFast(finalPath)) return false;
-
-			// 2️⃣ Decompress
-			std::vector<uint8_t> data;
-			if (!DecompressEntryFast(this, entry, data)) return false;
-
-			// 3️⃣ Write RAW (Minden konverziós logika eltávolítva)
-			LogInfo("[ExtractFile][DEBUG] Writing RAW: " + PathToLog(finalPath));
-			bool ok = WriteRawFast(finalPath, data.data(), data.size());
-
-			if (!ok) {
-				LogError("[ExtractFile] Write failed: " + PathToLog(finalPath));
-				return false;
-			}
-
-			// 4️⃣ Progress report
-			if (!ReportProgressFast(this, entry)) {
-				LogInfo("[ExtractFile] Aborted by user");
-				return false;
-			}
-
-			return true;
-		}
-		catch (const std::exception& ex) {
-			LogError("[ExtractFile] EXCEPTION: " + std::string(ex.what()));
-			return false;
-		}
-		catch (...) {
-			LogError("[ExtractFile] Unknown EXCEPTION");
-			return false;
-		}
-	}
-};
-
-inline std::string ws2s(const std::wstring& wstr)
-{
-	if (wstr.empty()) return std::string();
-	int size_needed = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), NULL, 0, NULL, NULL);
-	std::string strTo(size_needed, 0);
-	WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-	return strTo;
-}
-
-const std::wstring WORKBENCH_EXE_NAME = L"ArmaReforgerWorkbenchSteamDiag.exe";
-const std::wstring WORKBENCH_FALLBACK_EXE = L"ArmaReforgerWorkbenchSteam.exe";
-
-static std::wstring GetWorkbenchPathFromRegistry() {
-	HKEY hKey;
-	std::wstring exePath = L"";
-	LPCWSTR subkey = L"SOFTWARE\\Bohemia Interactive\\Arma Reforger Tools";
-
-	struct RootKey {
-		HKEY hRoot;
-		const char* name;
-	} roots[] = {
-		{HKEY_LOCAL_MACHINE, "HKLM"},
-		{HKEY_CURRENT_USER,  "HKCU"}
-	};
-
-	LogInfo("[Debug] --- Registry Deep Search Start ---");
-
-	for (auto& root : roots) {
-		LogInfo("[Debug] Checking " + std::string(root.name) + "...");
-
-		DWORD flags[] = { KEY_WOW64_64KEY, KEY_WOW64_32KEY, 0 };
-
-		for (DWORD flag : flags) {
-			if (RegOpenKeyExW(root.hRoot, subkey, 0, KEY_READ | flag, &hKey) == ERROR_SUCCESS) {
-				LogInfo("[Debug] SUCCESS: Key opened in " + std::string(root.name) + " with flags: " + std::to_string(flag));
-
-				wchar_t buffer[MAX_PATH];
-				DWORD bufferSize = sizeof(buffer);
-
-				if (RegQueryValueExW(hKey, L"exe", NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
-					exePath = buffer;
-					LogInfo("[Debug] 'exe' value found: " + ws2s(exePath));
-				} else {
-					bufferSize = sizeof(buffer);
-					if (RegQueryValueExW(hKey, L"path", NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
-						exePath = std::wstring(buffer) + L"\\" + WORKBENCH_EXE_NAME;
-						LogInfo("[Debug] 'path' value found, constructed default exe path.");
-					}
-				}
-
-				RegCloseKey(hKey);
-				if (!exePath.empty()) break;
-			}
-		}
-		if (!exePath.empty()) break;
-	}
-
-	if (exePath.empty()) {
-		LogInfo("[Debug] Still not found, checking HKEY_CLASSES_ROOT\\enfusion...");
-		LPCWSTR uriKey = L"enfusion\\shell\\open\\command";
-		if (RegOpenKeyExW(HKEY_CLASSES_ROOT, uriKey, 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
-			wchar_t buffer[MAX_PATH * 2];
-			DWORD bufferSize = sizeof(buffer);
-			if (RegQueryValueExW(hKey, NULL, NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
-				std::wstring fullCmd = buffer;
-				size_t firstQuote = fullCmd.find(L"\"");
-				size_t secondQuote = fullCmd.find(L"\"", firstQuote + 1);
-				if (firstQuote != std::wstring::npos && secondQuote != std::wstring::npos) {
-					exePath = fullCmd.substr(firstQuote + 1, secondQuote - firstQuote - 1);
-					LogInfo("[Debug] Found path in Enfusion URI handler: " + ws2s(exePath));
-				}
-			}
-			RegCloseKey(hKey);
-		}
-	}
-
-	if (!exePath.empty()) {
-		fs::path p(exePath);
-		std::vector<std::wstring> candidates;
-
-		candidates.push_back(p.wstring());
-
-		if (p.has_parent_path()) {
-			fs::path root = p.parent_path();
-
-			candidates.push_back((root / WORKBENCH_EXE_NAME).wstring());
-			candidates.push_back((root / L"Workbench" / WORKBENCH_EXE_NAME).wstring());
-
-			if (WORKBENCH_EXE_NAME != WORKBENCH_FALLBACK_EXE) {
-				candidates.push_back((root / WORKBENCH_FALLBACK_EXE).wstring());
-				candidates.push_back((root / L"Workbench" / WORKBENCH_FALLBACK_EXE).wstring());
-			}
-		}
-
-		bool found = false;
-		for (const auto& cand : candidates) {
-			if (!cand.empty() && fs::exists(cand) && !fs::is_directory(cand)) {
-				exePath = cand;
-				LogInfo("[Debug] Physical file VERIFIED: " + ws2s(exePath));
-				found = true;
-				break;
-			}
-		}
-
-		if (!found) {
-			LogError("[Debug] Path found in registry, but physical file not found: " + ws2s(exePath));
-			exePath = L"";
-		}
-	}
-
-	if (exePath.empty()) {
-		LogError("[Debug] ALL Registry locations and physical checks failed.");
-	}
-
-	LogInfo("[Debug] --- Registry Deep Search End ---");
-	return exePath;
-}
-
-struct WorkbenchContext {
-	std::string internalPath;
-	fs::path sandboxPath;
-	fs::path targetFilePath;
-	std::string ext;
-	std::string GUID_PROJECT = "A1B2C3D4E5F60789";
-	std::string projectName = "PAKViewer";
-	std::string wbModule = "resourceManager";
-	std::string loadResource;
-};
-
-using ExtensionProcessor = std::function<void(WorkbenchContext&)>;
-std::unordered_map<std::string, ExtensionProcessor> g_ExtensionLogic;
-
-struct ExtensionAutoReg {
-	ExtensionAutoReg() {
-		g_ExtensionLogic[".xob"] = [](WorkbenchContext& ctx) {
-			ctx.projectName = "XOBViewer";
-			ctx.wbModule = "resourceManager";
-
-			std::string GUID_XOB       = "D887766554433221";
-			std::string GUID_ENTITY    = "B9876543210FEDCB";
-			std::string GUID_COMPONENT = "C112233445566778";
-			std::string GUID_PREFAB    = "E554433221100998";
-
-			fs::path prefabDir = ctx.sandboxPath / "Prefabs";
-			fs::create_directories(prefabDir);
-
-			try {
-				std::ofstream xobMeta(ctx.targetFilePath.string() + ".meta");
-				xobMeta << "MetaFileClass {\n Name \"{" << GUID_XOB << "}" << ctx.internalPath
-						<< "\"\n Configurations {\n  StaticModelResourceClass PC {}\n }\n}";
-				xobMeta.close();
-
-				std::ofstream et(prefabDir / "preview.et");
-				et << "GenericEntity {\n ID \"" << GUID_ENTITY << "\"\n components {\n  MeshObject \"" << GUID_COMPONENT << "\" {\n    Object \"{" << GUID_XOB << "}" << ctx.internalPath << "\"\n  }\n }\n}";
-				et.close();
-
-				std::ofstream etMeta(prefabDir / "preview.et.meta");
-				etMeta << "MetaFileClass {\n Name \"{" << GUID_PREFAB << "}Prefabs/preview.et\"\n Configurations {\n  EntityTemplateResourceClass PC {}\n }\n}";
-				etMeta.close();
-
-				ctx.loadResource = "{" + GUID_PREFAB + "}Prefabs/preview.et";
-
-			} catch (...) {
-				LogInfo("[XOB Processor] Critical error while writing files!");
-				ctx.loadResource = "{" + ctx.GUID_PROJECT + "}" + ctx.internalPath;
-			}
-		};
-	}
-};
-
-//static ExtensionAutoReg g_DoReg;
-
-bool IsWorkbenchSupported(const std::string& extension) {
-	if (g_ExtensionLogic.count(extension)) {
-		return true;
-	}
-
-	static const std::unordered_set<std::string> supportedExtensions = {
- //       ".et", ".ent", ".layer", ".c", ".acp", ".sig", ".afm", ".snd", ".wav",
- //       ".agf", ".agr", ".anm", ".asi", ".ast", ".aw", ".ae", ".asy", ".txa",
- //       ".bt", ".ptc", ".layout", ".styles", ".imageset", ".emat", ".gamemat",
- //       ".physmat", ".edds", ".dds", ".st", ".nmn", ".pap", ".siga", ".conf",
- //       ".gproj", ".meta", ".pre", ".fnt", ".ttf"
-		  ".xob", ".c"
-	};
-
-	return supportedExtensions.count(extension) > 0;
-}
-
-int CountProcesses(const std::wstring& exeName) {
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-	if (hSnap == INVALID_HANDLE_VALUE) return 0;
-
-	PROCESSENTRY32W pe;
-	pe.dwSize = sizeof(pe);
-	int count = 0;
-
-	if (Process32FirstW(hSnap, &pe)) {
-		do {
-			if (_wcsicmp(pe.szExeFile, exeName.c_str()) == 0) {
-				count++;
-			}
-		} while (Process32NextW(hSnap, &pe));
-	}
-
-	CloseHandle(hSnap);
-	return count;
-}
-
-bool WaitForSteamReady(int maxWaitSeconds) {
-	LogInfo("[Steam] Monitoring WebHelper count for initialization...");
-
-	int stableTicks = 0;
-	int lastCount = 0;
-
-	for (int i = 0; i < maxWaitSeconds; ++i) {
-		int currentCount = CountProcesses(L"steamwebhelper.exe");
-
-		if (currentCount >= 7 && currentCount == lastCount) {
-			stableTicks++;
-		} else {
-			stableTicks = 0;
-		}
-
-		lastCount = currentCount;
-
-		if (stableTicks >= 3) {
-			LogInfo("[Steam] Ready! WebHelper count stable at: " + std::to_string(currentCount));
-			return true;
-		}
-
-		std::this_thread::sleep_for(std::chrono::seconds(1));
-		if (i % 5 == 0) LogInfo("[Steam] Waiting... Current WebHelpers: " + std::to_string(currentCount));
-	}
-
-	LogInfo("[Steam] Timeout reached, continuing launch attempt anyway...");
-	return false;
-}
-
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-	DWORD pid;
-	GetWindowThreadProcessId(hwnd, &pid);
-	if (pid == (DWORD)lParam) {
-		PostMessage(hwnd, WM_CLOSE, 0, 0);
-	}
-	return TRUE;
-}
-
-bool IsSteamRunning() {
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-	if (hSnap == INVALID_HANDLE_VALUE) return false;
-	PROCESSENTRY32W pe = { sizeof(pe) };
-	bool running = false;
-	if (Process32FirstW(hSnap, &pe)) {
-		do {
-			if (_wcsicmp(pe.szExeFile, L"steam.exe") == 0) {
-				running = true;
-				break;
-			}
-		} while (Process32NextW(hSnap, &pe));
-	}
-	CloseHandle(hSnap);
-	return running;
-}
-
-bool IsProcessRunning(const std::wstring& exeName) {
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-	if (hSnap == INVALID_HANDLE_VALUE) return false;
-
-	PROCESSENTRY32W pe{ sizeof(pe) };
-	bool running = false;
-
-	for (BOOL ok = Process32FirstW(hSnap, &pe); ok; ok = Process32NextW(hSnap, &pe)) {
-		if (_wcsicmp(pe.szExeFile, exeName.c_str()) == 0) {
-			running = true;
-			break;
-		}
-	}
-
-	CloseHandle(hSnap);
-	return running;
-}
-
-bool IsWorkbenchRunning() {
-	return IsProcessRunning(WORKBENCH_EXE_NAME);
-}
-
-bool LaunchWorkbenchWithRetry(const std::wstring& cmd, const std::wstring& workDir, const fs::path& sandboxPath) {
-	const int maxRetries = 5;
-
-	for (int i = 0; i < maxRetries; ++i) {
-		if (!IsSteamRunning()) {
-			LogInfo("[Workbench] Steam not running, launching...");
-			ShellExecuteW(NULL, L"open", L"steam://open/main", NULL, NULL, SW_SHOWNORMAL);
-			WaitForSteamReady(45);
-		} else {
-			if (CountProcesses(L"steamwebhelper.exe") < 7) {
-				LogInfo("[Workbench] Steam running but WebHelpers starting, waiting...");
-				WaitForSteamReady(10);
-			}
-		}
-
-		LogInfo("[Workbench] Launch attempt #" + std::to_string(i + 1));
-
-		STARTUPINFOW si{ sizeof(si) };
-		si.dwFlags = STARTF_USESHOWWINDOW;
-		si.wShowWindow = SW_SHOWNORMAL;
-
-		PROCESS_INFORMATION pi{};
-		std::vector<wchar_t> buffer(cmd.begin(), cmd.end());
-		buffer.push_back(0);
-
-		if (!CreateProcessW(NULL, buffer.data(), NULL, NULL, FALSE, 0, NULL, workDir.c_str(), &si, &pi)) {
-			LogInfo("[Workbench] CreateProcessW failed: " + std::to_string(GetLastError()));
-			std::this_thread::sleep_for(std::chrono::seconds(3));
-			continue;
-		}
-
-		HANDLE hProcess = pi.hProcess;
-		DWORD pid = pi.dwProcessId;
-		CloseHandle(pi.hThread);
-
-		bool success = false;
-		for (int check = 0; check < 15; ++check) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-			DWORD currentExitCode;
-			if (!GetExitCodeProcess(hProcess, &currentExitCode)) break;
-
-			if (currentExitCode != STILL_ACTIVE) {
-				success = false;
-				break;
-			}
-
-			if (check >= 10) {
-				success = true;
-				break;
-			}
-		}
-
-		if (success) {
-			LogInfo("[Workbench] Process running (PID: " + std::to_string(pid) + ")");
-
-			std::thread([hProcess, sandboxPath, pid]() {
-				WaitForSingleObject(hProcess, INFINITE);
-
-				DWORD finalExit = 0;
-				GetExitCodeProcess(hProcess, &finalExit);
-				CloseHandle(hProcess);
-
-				std::this_thread::sleep_for(std::chrono::seconds(1));
-
-				if (finalExit == 0 && fs::exists(sandboxPath)) {
-					try {
-						fs::remove_all(sandboxPath);
-						LogInfo("[Cleanup] Sandbox deleted after Workbench (PID: " + std::to_string(pid) + ") closed.");
-					} catch (...) {
-						LogInfo("[Cleanup] Failed to delete sandbox (folder may be locked).");
-					}
-				} else if (finalExit == 0) {
-					LogInfo("[Cleanup] Sandbox folder already gone or inaccessible, skipping.");
-				} else {
-					LogInfo("[Cleanup] Process " + std::to_string(pid) + " closed via code or error (Exit: " + std::to_string(finalExit) + "), skipping cleanup.");
-				}
-			}).detach();
-
-			return true;
-		}
-
-		LogInfo("[Workbench] Process exited prematurely.");
-		CloseHandle(hProcess);
-		std::this_thread::sleep_for(std::chrono::seconds(3));
-	}
-
-	return false;
-}
-
-void TerminateWorkbench() {
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-	if (hSnap == INVALID_HANDLE_VALUE) return;
-
-	PROCESSENTRY32W pe;
-	pe.dwSize = sizeof(pe);
-
-	if (Process32FirstW(hSnap, &pe)) {
-		do {
-			std::wstring exeName = pe.szExeFile;
-			if (_wcsicmp(exeName.c_str(), WORKBENCH_EXE_NAME.c_str()) == 0) {
-
-				DWORD pid = pe.th32ProcessID;
-
-				LogInfo("[Workbench] Existing process found (PID: " + std::to_string(pid) + "), sending close message...");
-
-				EnumWindows(EnumWindowsProc, pid);
-
-				HANDLE hProcess = OpenProcess(SYNCHRONIZE | PROCESS_TERMINATE, FALSE, pid);
-
-				if (hProcess) {
-					DWORD wait = WaitForSingleObject(hProcess, 5000);
-
-					if (wait == WAIT_TIMEOUT) {
-						LogInfo("[Workbench] Graceful close timeout, forcing termination (PID: " + std::to_string(pid) + ")");
-						TerminateProcess(hProcess, 0);
-						WaitForSingleObject(hProcess, 2000);
-					} else {
-						LogInfo("[Workbench] Process exited cleanly (PID: " + std::to_string(pid) + ")");
-					}
-
-					CloseHandle(hProcess);
-				} else {
-					LogInfo("[Workbench] Failed to open process handle (PID: " + std::to_string(pid) + ")");
-				}
-			}
-		} while (Process32NextW(hSnap, &pe));
-	}
-
-	CloseHandle(hSnap);
-
-	std::this_thread::sleep_for(std::chrono::milliseconds(300));
-}
-
-// =====================================================
-// 🔥 WORKBENCH LAUNCH
-// =====================================================
-static bool OpenInWorkbench(const std::string& pakEntryPath, const std::string& extractedRoot) {
-	TerminateWorkbench();
-
-	for (int i = 0; i < 20; ++i) {
-		if (!IsWorkbenchRunning()) break;
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-	}
-	LogInfo("[Workbench] Launching via Retry system...");
-
-	std::wstring wbExe = GetWorkbenchPathFromRegistry();
-	if (wbExe.empty()) return false;
-
-	fs::path exePath(wbExe);
-	fs::path binDir = exePath.parent_path();
-
-	fs::path diagPath = binDir / WORKBENCH_EXE_NAME;
-	if (fs::exists(diagPath)) wbExe = diagPath.wstring();
-
-	fs::path toolsDir = binDir.parent_path();
-	fs::path commonDir = toolsDir.parent_path();
-	fs::path gameData = commonDir / L"Arma Reforger" / L"addons" / L"data";
-	fs::path sandboxPath = fs::path(extractedRoot);
-
-	WorkbenchContext ctx;
-	ctx.internalPath = pakEntryPath;
-
-	std::replace(ctx.internalPath.begin(), ctx.internalPath.end(), '\\', '/');
-	if (!ctx.internalPath.empty() && ctx.internalPath[0] == '/') ctx.internalPath.erase(0, 1);
-
-	ctx.sandboxPath = sandboxPath;
-	ctx.targetFilePath = sandboxPath / ctx.internalPath;
-	ctx.ext = ctx.targetFilePath.extension().string();
-	std::transform(ctx.ext.begin(), ctx.ext.end(), ctx.ext.begin(), ::tolower);
-
-	ctx.loadResource = "{" + ctx.GUID_PROJECT + "}" + ctx.internalPath;
-
-	fs::create_directories(ctx.targetFilePath.parent_path());
-
-	// =====================================================
-	// 🛠️ EXTENSION LOGIC
-	// =====================================================
-	if (g_ExtensionLogic.count(ctx.ext)) {
-		g_ExtensionLogic[ctx.ext](ctx);
-	} else {
-		const std::string& ext = ctx.ext;
-		if (ext == ".xob") { ctx.projectName = "XOBViewer"; ctx.wbModule = "resourceManager"; }
-		else if (ext == ".et" || ext == ".ent" || ext == ".layer") { ctx.projectName = "WorldEditor"; ctx.wbModule = "worldEditor"; }
-		else if (ext == ".c") { ctx.projectName = "ScriptEditor"; ctx.wbModule = "resourceManager"; }
-		else if (ext == ".acp" || ext == ".sig" || ext == ".afm" || ext == ".snd" || ext == ".wav") { ctx.projectName = "AudioEditor"; ctx.wbModule = "audioEditor"; }
-		else if (ext == ".agf" || ext == ".agr" || ext == ".anm" || ext == ".asi" || ext == ".ast" || ext == ".aw" || ext == ".ae" || ext == ".asy" || ext == ".txa") { ctx.projectName = "AnimationEditor"; ctx.wbModule = "animEditor"; }
-		else if (ext == ".bt") { ctx.projectName = "BehaviorEditor"; ctx.wbModule = "behaviorEditor"; }
-		else if (ext == ".ptc") { ctx.projectName = "ParticleEditor"; ctx.wbModule = "particleEditor"; }
-		else if (ext == ".layout" || ext == ".styles" || ext == ".imageset") { ctx.projectName = "LayoutEditor"; ctx.wbModule = "resourceManager"; }
-		else if (ext == ".emat" || ext == ".gamemat" || ext == ".physmat") { ctx.projectName = "MaterialEditor"; ctx.wbModule = "resourceManager"; }
-		else if (ext == ".edds" || ext == ".dds") { ctx.projectName = "TextureViewer"; ctx.wbModule = "resourceManager"; }
-		else if (ext == ".st") { ctx.projectName = "LocalizationEditor"; ctx.wbModule = "localizationEditor"; }
-		else if (ext == ".nmn") { ctx.projectName = "NavmeshGenerator"; ctx.wbModule = "navmeshGeneratorMain"; }
-		else if (ext == ".pap" || ext == ".siga") { ctx.projectName = "ProcAnimEditor"; ctx.wbModule = "procAnimEditor"; }
-		else if (ext == ".conf" || ext == ".gproj" || ext == ".meta" || ext == ".pre" || ext == ".fnt" || ext == ".ttf") { ctx.projectName = "ConfigViewer"; ctx.wbModule = "resourceManager"; }
-	}
-
-	// =====================================================
-	// 📂 FILE OPERATIONS
-	// =====================================================
-	try {
-		fs::path sourceInSandbox = sandboxPath / ctx.internalPath;
-		if (fs::exists(sourceInSandbox) && sourceInSandbox != ctx.targetFilePath) {
-			if (fs::exists(ctx.targetFilePath)) fs::remove(ctx.targetFilePath);
-			fs::copy_file(sourceInSandbox, ctx.targetFilePath);
-		}
-	} catch (...) { return false; }
-
-	// =====================================================
-	// 📝 PROJECT GENERATION (Meta & GPROJ)
-	// =====================================================
-	try {
-		std::ofstream meta(ctx.targetFilePath.string() + ".meta");
-		meta << "MetaFileClass {\n Name \"{" << ctx.GUID_PROJECT << "}" << ctx.internalPath << "\"\n}\n";
-		meta.close();
-
-		std::ofstream gproj(sandboxPath / "addon.gproj");
-		gproj << "GameProject {\n"
-			  << " ID \"" << ctx.projectName << "\"\n"
-			  << " GUID \"" << ctx.GUID_PROJECT << "\"\n"
-			  << " TITLE \"" << ctx.projectName << "\"\n"
-			  << " Dependencies {\n"
-			  << "  \"58D0FB3206B6F859\"\n"
-			  << " }\n"
-			  << "}";
-		gproj.close();
-	} catch (...) { return false; }
-
-	// =====================================================
-	// 🚀 COMMAND EXECUTION
-	// =====================================================
-	std::wstring wModule = std::wstring(ctx.wbModule.begin(), ctx.wbModule.end());
-	std::wstring wLoad = std::wstring(ctx.loadResource.begin(), ctx.loadResource.end());
-
-	std::wstring openCmd = L"\"" + wbExe + L"\"" +
-		L" -gproj \"" + (sandboxPath / "addon.gproj").wstring() + L"\"" +
-		L" -addonsDir \"" + sandboxPath.wstring() + L"," + gameData.wstring() + L"\"" +
-		L" -wbModule=" + wModule;
-
-	if (ctx.wbModule == "scriptEditor") {
-		openCmd += L" -noGameScriptsOnInit";
-	}
-
-	openCmd += L" -run -load \"" + wLoad + L"\"";
-
-	LogInfo("[Workbench] Final Launch Command: " + ws2s(openCmd));
-
-	if (!LaunchWorkbenchWithRetry(openCmd, binDir.wstring(), sandboxPath)) {
-		MessageBoxW(NULL,
-			L"Failed to launch Workbench after multiple attempts.\nPlease ensure Steam is running and logged in.",
-			L"Error",
-			MB_OK | MB_ICONERROR);
-		return false;
-	}
-
-	return true;
-}
-
-static PakArchive* GetArchive(HANDLE hArcData) {
-	return reinterpret_cast<PakArchive*>(hArcData);
-}
-
-std::unique_ptr<ThreadPool> g_ThreadPool = nullptr;
-
-static std::string g_LastOpenedArcName = "";
-static std::wstring g_LastTargetDir = L"";
-static bool g_ExtractOptionsShown = false;
-static bool g_SettingsChangedForRefresh = false;
-static std::atomic<bool> g_RequireReload{ false };
-static FILETIME g_OriginalArchiveTime = { 0 };
-static std::string g_OriginalArchivePath = "";
-static std::chrono::steady_clock::time_point g_LastOperationEndTime = std::chrono::steady_clock::now();
-
-// ============================================================================
-// AUTOREFRESH
-// ============================================================================
-static HWND FindTCWindow() {
-	HWND h = FindWindowA("TTOTAL_CMD", NULL);
-	if (!h) h = GetForegroundWindow();
-	return h;
-}
-
-static bool TouchArchiveFile(const std::string& filePath, FILETIME originalTime) {
-	if (filePath.empty()) return false;
-
-	if (originalTime.dwLowDateTime == 0 && originalTime.dwHighDateTime == 0) {
-		GetSystemTimeAsFileTime(&originalTime);
-	}
-
-	for (int attempt = 0; attempt < 5; ++attempt) {
-		HANDLE h = CreateFileA(
-			filePath.c_str(),
-			FILE_WRITE_ATTRIBUTES,
-			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-			NULL,
-			OPEN_EXISTING,
-			0,
-			NULL
-		);
-
-		if (h != INVALID_HANDLE_VALUE) {
-			ULARGE_INTEGER uli;
-			uli.LowPart = originalTime.dwLowDateTime;
-			uli.HighPart = originalTime.dwHighDateTime;
-
-			if (uli.QuadPart > 100000000LL) {
-				uli.QuadPart -= 100000000LL;
-			} else {
-				uli.QuadPart = 0;
-			}
-
-			FILETIME ft;
-			ft.dwLowDateTime = uli.LowPart;
-			ft.dwHighDateTime = uli.HighPart;
-
-			bool success = (SetFileTime(h, NULL, NULL, &ft) != 0);
-			if (success) {
-				FlushFileBuffers(h);
-				CloseHandle(h);
-				LogInfo("[Touch] Archive timestamp shifted successfully: " + filePath);
-				return true;
-			}
-
-			DWORD err = GetLastError();
-			CloseHandle(h);
-			LogError("[Touch] SetFileTime failed (attempt " + std::to_string(attempt) + "): " + std::to_string(err));
-		}
-
-		Sleep(100);
-	}
-
-	try {
-		std::filesystem::path p(filePath);
-		if (std::filesystem::exists(p)) {
-			std::filesystem::last_write_time(p, std::filesystem::file_time_type::clock::now());
-			LogInfo("[Touch] Archive timestamp updated via filesystem fallback.");
-			return true;
-		}
-	}
-	catch (const std::exception& e) {
-		LogError(std::string("[Touch] Fallback failed: ") + e.what());
-	}
-
-	return false;
-}
-
-// ============================================================================
-// OPENARCHIVE
-// ============================================================================
-template <typename T>
-static HANDLE OpenArchiveInternal(const std::string& arcName, T* ArchiveData) {
-	std::unique_ptr<PakArchive> newArchive;
-	try {
-		auto now = std::chrono::steady_clock::now();
-		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - g_LastOperationEndTime).count();
-
-		if (elapsed > 1000) {
-			g_ExtractOptionsShown = false;
-		}
-
-		bool forceReload = g_RequireReload.load();
-
-		if (forceReload && !g_OriginalArchivePath.empty()) {
-			HANDLE hRestore = CreateFileA(g_OriginalArchivePath.c_str(), FILE_WRITE_ATTRIBUTES,
-										 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-			if (hRestore != INVALID_HANDLE_VALUE) {
-				if (SetFileTime(hRestore, NULL, NULL, &g_OriginalArchiveTime)) {
-					LogInfo("[OpenArchive] Timestamp RESTORED to original after reload: " + g_OriginalArchivePath);
-				} else {
-					LogError("[OpenArchive] Failed to restore timestamp in Open: " + std::to_string(GetLastError()));
-				}
-				CloseHandle(hRestore);
-			}
-			g_OriginalArchiveTime = { 0 };
-			g_OriginalArchivePath = "";
-		}
-
-		if (forceReload) {
-			LogInfo("[OpenArchive] FORCE RELOAD triggered for: " + arcName);
-		}
-
-		LogInfo("[OpenArchive] Opening archive: " + arcName);
-		newArchive = std::make_unique<PakArchive>(arcName);
-
-		if (!newArchive->IsInitialized()) {
-			LogError("[OpenArchive] Initialization failed for: " + arcName);
-			ArchiveData->OpenResult = E_EOPEN;
-			return nullptr;
-		}
-
-		// Konverziós snapshotok eltávolítva
-		if (forceReload) {
-			g_RequireReload = false;
-		}
-
-		g_LastOpenedArcName = arcName;
-
-		LogInfo("[OpenArchive] Adding virtual entry: pak_plugin.ini");
-		newArchive->AddVirtualEntry("pak_plugin.ini");
-
-		newArchive->BuildIndex();
-		newArchive->ResetIndex();
-
-		ArchiveData->OpenResult = 0;
-
-		LogInfo("Successfully opened archive: " + arcName + " (with virtual plugin entry)");
-		LogInfo("[OpenArchive] instance=" + std::to_string((uintptr_t)newArchive.get()));
-
-		return reinterpret_cast<HANDLE>(newArchive.release());
-	}
-	catch (const std::exception& ex) {
-		LogError("[OpenArchive] EXCEPTION: " + std::string(ex.what()));
-		ArchiveData->OpenResult = E_EOPEN;
-		return nullptr;
-	}
-	catch (...) {
-		LogError("[OpenArchive] Unknown EXCEPTION caught.");
-		ArchiveData->OpenResult = E_EOPEN;
-		return nullptr;
-	}
-}
-
-HANDLE __stdcall OpenArchive(tOpenArchiveData* ArchiveData) {
-	if (!ArchiveData || !ArchiveData->ArcName) {
-		LogError("[OpenArchive] Invalid archive data or missing filename.");
-		if (ArchiveData) ArchiveData->OpenResult = E_BAD_ARCHIVE;
-		return nullptr;
-	}
-
-	return OpenArchiveInternal<tOpenArchiveData>(
-		std::string(ArchiveData->ArcName),
-		ArchiveData
-	);
-}
-
-HANDLE __stdcall OpenArchiveW(tOpenArchiveDataW* ArchiveDataW) {
-	if (!ArchiveDataW || !ArchiveDataW->ArcName) {
-		LogError("[OpenArchiveW] Invalid archive data or missing filename.");
-		if (ArchiveDataW) ArchiveDataW->OpenResult = E_BAD_ARCHIVE;
-		return nullptr;
-	}
-
-	return OpenArchiveInternal<tOpenArchiveDataW>(
-		WCharToUTF8(ArchiveDataW->ArcName),
-		ArchiveDataW
-	);
-}
-
-enum class HeaderResult {
-	OK,
-	END,
-	BAD_ARCHIVE,
-	BAD_DATA
-};
-
-struct PreparedHeader {
-	const PakEntry* entry = nullptr;
-	std::string displayName;
-	uint32_t dosTime = 0;
-};
-
-static HeaderResult PrepareHeaderData(HANDLE hArcData, PreparedHeader& out) {
-	PakArchive* arc = GetArchive(hArcData);
-	if (!arc) return HeaderResult::BAD_ARCHIVE;
-
-	int idx = arc->GetAndIncrementIndex();
-	if (idx >= arc->GetEntryCount()) return HeaderResult::END;
-
-	arc->SetLastIndex(idx);
-
-	out.entry = arc->GetEntry(idx);
-	if (!out.entry) return HeaderResult::BAD_DATA;
-
-	out.displayName = out.entry->name;
-	// EDDS kiterjesztés átírási logika eltávolítva
-
-	if (out.entry->timestamp != 0) {
-		FILETIME ft;
-		LONGLONG ll = Int32x32To64(out.entry->timestamp, 10000000) + 116444736000000000;
-		ft.dwLowDateTime = (DWORD)ll;
-		ft.dwHighDateTime = (DWORD)(ll >> 32);
-
-		SYSTEMTIME st;
-		if (FileTimeToSystemTime(&ft, &st)) {
-			out.dosTime = SystemTimeToDosDateTime(st);
-		} else {
-			out.dosTime = 0;
-		}
-	} else {
-		out.dosTime = 0;
-	}
-
-	return HeaderResult::OK;
-}
-
-static int MapHeaderResult(HeaderResult res) {
-	switch (res) {
-		case HeaderResult::END:          return E_END_ARCHIVE;
-		case HeaderResult::BAD_ARCHIVE: return E_BAD_ARCHIVE;
-		case HeaderResult::BAD_DATA:    return E_BAD_DATA;
-		default:                        return 0;
-	}
-}
-
-template<typename T>
-void FillCommon(T& h, const PreparedHeader& ph) {
-	h.PackSize = ph.entry->isDirectory ? 0 : (uint32_t)ph.entry->size;
-	h.UnpSize  = ph.entry->isDirectory ? 0 : (uint32_t)ph.entry->originalSize;
-	h.FileAttr = ph.entry->isDirectory ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
-	h.FileTime = ph.dosTime;
-}
-
-int __stdcall ReadHeader(HANDLE hArcData, tHeaderData* h) {
-	PreparedHeader ph;
-	HeaderResult res = PrepareHeaderData(hArcData, ph);
-	if (res != HeaderResult::OK) return MapHeaderResult(res);
-
-	*h = {};
-	FillCommon(*h, ph);
-
-	strncpy_s(h->FileName, _countof(h->FileName), ph.displayName.c_str(), _TRUNCATE);
-
-	return 0;
-}
-
-int __stdcall ReadHeaderEx(HANDLE hArcData, tHeaderDataEx* h) {
-	PreparedHeader ph;
-	HeaderResult res = PrepareHeaderData(hArcData, ph);
-	if (res != HeaderResult::OK) return MapHeaderResult(res);
-
-	*h = {};
-	FillCommon(*h, ph);
-
-	strncpy_s(h->FileName, _countof(h->FileName), ph.displayName.c_str(), _TRUNCATE);
-
-	return 0;
-}
-
-int __stdcall ReadHeaderExW(HANDLE hArcData, tHeaderDataExW* h) {
-	PreparedHeader ph;
-	HeaderResult res = PrepareHeaderData(hArcData, ph);
-	if (res != HeaderResult::OK) return MapHeaderResult(res);
-
-	*h = {};
-	FillCommon(*h, ph);
-
-	int len = MultiByteToWideChar(
-		CP_UTF8, 0,
-		ph.displayName.c_str(),
-		-1,
-		h->FileName,
-		_countof(h->FileName)
-	);
-
-	if (len == 0) {
-		h->FileName[0] = L'\0';
-	}
-
-	return 0;
-}
-
-int __stdcall ProcessFile(HANDLE hArcData, int Operation, char* DestPath, char* DestName)
-{
-	wchar_t wideDestPath[MAX_PATH] = { 0 };
-	wchar_t wideDestName[MAX_PATH] = { 0 };
-
-	if (DestPath)
-		MultiByteToWideChar(CP_ACP, 0, DestPath, -1, wideDestPath, MAX_PATH);
-	if (DestName)
-		MultiByteToWideChar(CP_ACP, 0, DestName, -1, wideDestName, MAX_PATH);
-
-	return ProcessFileW(hArcData, Operation,
-		DestPath ? wideDestPath : nullptr,
-		DestName ? wideDestName : nullptr);
-}
-
-static PakEntry g_CurrentEntryForDialog;
-static PakArchive* g_CurrentArchiveForDialog = nullptr;
-
-static INT_PTR CALLBACK SettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam);
-
-// ============================
-// Viewer check
-// ============================
-static bool IsViewerRequest(const std::wstring& name) {
-	return name.find(L"\\_tc\\") != std::wstring::npos ||
-		   name.find(L"/_tc/") != std::wstring::npos;
-}
-
-// ============================
-// Folder copy detection
-// ============================
-static bool DetectFolderCopy(const std::wstring& wDestName, const PakEntry* entry, bool isViewer) {
-	if (wDestName.empty() || isViewer) return false;
-
-	fs::path pDest(wDestName);
-	fs::path pInternal(UTF8ToWString(entry->name));
-
-	if (pDest.has_parent_path() && pInternal.has_parent_path()) {
-		std::wstring destLast = pDest.parent_path().filename().wstring();
-		std::wstring intLast  = pInternal.parent_path().filename().wstring();
-
-		std::transform(destLast.begin(), destLast.end(), destLast.begin(), ::tolower);
-		std::transform(intLast.begin(), intLast.end(), intLast.begin(), ::tolower);
-
-		if (!destLast.empty() && destLast == intLast) {
-			LogInfo("[ProcessFileW][DEBUG] Folder copy detected (Parent match: " + ws2s(destLast) + ")");
-			return true;
-		}
-	}
-	return false;
-}
-
-// ============================================================================
-// 🔥 SETTINGS HANDLING
-// ============================================================================
-static int HandleSettingsFile(PakArchive* currentArchive, const PakEntry* entry, const wchar_t* DestName) {
-	LogInfo("[ProcessFileW] Settings file triggered via viewer.");
-	g_CurrentArchiveForDialog = currentArchive;
-
-	INT_PTR settingsResult = DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ARMAPAK_SETTINGS), NULL, SettingsDialogProc, 0);
-
-	if (settingsResult == IDOK) {
-		if (DestName) {
-			HANDLE hFile = CreateFileW(DestName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-			if (hFile != INVALID_HANDLE_VALUE) {
-				std::string msg = "Settings applied successfully.";
-				DWORD written = 0;
-				WriteFile(hFile, msg.c_str(), (DWORD)msg.length(), &written, NULL);
-				CloseHandle(hFile);
-			}
-		}
-		return 0;
-	}
-	return E_EABORTED;
-}
-
-// ============================
-// WORKBENCH LAUNCH
-// ============================
-static int HandleWorkbenchLaunch(PakArchive* arc) {
-	LogInfo("[ProcessFileW] Workbench launch triggered.");
-
-	// Konverziós mentés eltávolítva
-
-	static std::atomic<uint64_t> counter{0};
-
-	auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-	DWORD pid = GetCurrentProcessId();
-	uint64_t localCounter = counter.fetch_add(1, std::memory_order_relaxed);
-
-	std::string tempBase = "C:\\Temp\\ArmaPak_Preview_" +
-		std::to_string(pid) + "_" +
-		std::to_string(now) + "_" +
-		std::to_string(localCounter);
-
-	fs::create_directories(tempBase);
-
-	LogInfo("[Workbench] Using temp: " + tempBase);
-
-	std::unordered_set<std::string> processed;
-	std::string finalPath = (fs::path(tempBase) / g_CurrentEntryForDialog.name).string();
-
-	bool ok = SmartExtractor::ExtractWithDependencies(
-		arc,
-		arc->GetLastIndex(),
-		finalPath,
-		processed
-	);
-
-	if (ok) {
-		OpenInWorkbench(g_CurrentEntryForDialog.name, tempBase);
-
-		std::thread([tempBase]() {
-			LogInfo("[Cleanup] Waiting before deletion: " + tempBase);
-
-			std::this_thread::sleep_for(std::chrono::seconds(10));
-
-			int safetyCounter = 0;
-			while (IsWorkbenchRunning()) {
-				std::this_thread::sleep_for(std::chrono::seconds(2));
-
-				if (++safetyCounter > 300) {
-					LogInfo("[Cleanup] Safety timeout reached, forcing cleanup.");
-					break;
-				}
-			}
-
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-
-			try {
-				if (fs::exists(tempBase)) {
-					fs::remove_all(tempBase);
-					LogInfo("[Cleanup] Deleted temp: " + tempBase);
-				}
-			} catch (...) {
-				LogError("[Cleanup] Failed to delete temp: " + tempBase);
-			}
-		}).detach();
-	}
-
-	return 0;
-}
-
-// ============================
-// TEST
-// ============================
-static int HandleTest(PakArchive* arc, const PakEntry* entry) {
-	if (entry->isDirectory) return 0;
-
-	std::vector<uint8_t> data = arc->DecompressEntryData(entry);
-
-	auto cb = arc->GetProcessDataProc();
-	if (!cb) return 0;
-
-	const size_t CHUNK = 16384;
-
-	if (entry->originalSize == 0) {
-		std::lock_guard<std::mutex> lock(g_CallbackMutex);
-		cb(const_cast<char*>(entry->name.c_str()), 0);
-		return 0;
-	}
-
-	size_t pos = 0;
-	while (pos < data.size()) {
-		size_t chunkSize = std::min(CHUNK, data.size() - pos);
-
-		int result;
-		{
-			std::lock_guard<std::mutex> lock(g_CallbackMutex);
-			result = cb(const_cast<char*>(entry->name.c_str()), (int)chunkSize);
-		}
-
-		if (result == 0) {
-			LogError("[ProcessFileW] PK_TEST aborted.");
-			return E_EABORTED;
-		}
-
-		pos += chunkSize;
-	}
-
-	return 0;
-}
-
-// ============================
-// EXTRACT
-// ============================
-static int HandleExtract(
-	PakArchive* arc,
-	int entryIndex,
-	const PakEntry* entry,
-	const std::wstring& wDestPath,
-	const std::wstring& wDestName
-) {
-	if (entry && entry->name == "pak_plugin.ini") {
-		return 0;
-	}
-
-	bool isViewer = IsViewerRequest(wDestName);
-	bool isFolderCopy = DetectFolderCopy(wDestName, entry, isViewer);
-
-	fs::path fullTargetPath;
-	if (!wDestName.empty()) fullTargetPath = fs::path(wDestName);
-	else if (!wDestPath.empty()) fullTargetPath = fs::path(wDestPath);
-	else fullTargetPath = fs::current_path();
-
-	fullTargetPath = fullTargetPath.lexically_normal();
-	fs::path basePath = fullTargetPath;
-
-	if (isFolderCopy || (basePath.has_filename() && basePath.has_extension())) {
-		basePath = basePath.parent_path();
-	}
-
-	auto u8str = basePath.u8string();
-	std::string baseDest(reinterpret_cast<const char*>(u8str.c_str()));
-
-	if (entry->isDirectory) {
-		fs::path dirPath = isFolderCopy ? fullTargetPath :
-						   fs::path(PakArchive::BuildFinalPath(baseDest, entry->name));
-		try {
-			fs::create_directories(dirPath);
-			return 0;
-		} catch (...) {
-			auto u8err = dirPath.u8string();
-			LogError("[HandleExtract] Failed to create dir: " + std::string(reinterpret_cast<const char*>(u8err.c_str())));
-			return E_EWRITE;
-		}
-	}
-
-	bool success = false;
-	std::string finalPath;
-
-	// Konverziós logika eltávolítva (EDDS->DDS stb.)
-
-	if (isViewer || isFolderCopy) {
-		fs::path p = fullTargetPath;
-		auto u8dir = p.u8string();
-		std::string direct(reinterpret_cast<const char*>(u8dir.c_str()));
-		success = arc->ExtractFile(entryIndex, direct);
-		finalPath = direct;
-	}
-	else {
-		if (g_EnableSmartExtract) {
-			std::unordered_set<std::string> processed;
-			auto u8final = PakArchive::BuildFinalPath(baseDest, entry->name).u8string();
-			finalPath = std::string(reinterpret_cast<const char*>(u8final.c_str()));
-			success = SmartExtractor::ExtractWithDependencies(arc, entryIndex, finalPath, processed);
-		}
-
-		if (!success) {
-			success = arc->ExtractFile(entryIndex, baseDest);
-			auto u8final = PakArchive::BuildFinalPath(baseDest, entry->name).u8string();
-			finalPath = std::string(reinterpret_cast<const char*>(u8final.c_str()));
-		}
-	}
-
-	if (!success) {
-		LogError("[HandleExtract] Extraction failed for: " + entry->name);
-		return E_EWRITE;
-	}
-
-	return 0;
-}
-
-// ============================================================================
-// 🔥 PROCESSFILEW
-// ============================================================================
-int __stdcall ProcessFileW(HANDLE hArcData, int Operation, const wchar_t* DestPath, const wchar_t* DestName)
-{
-	PakArchive* arc = GetArchive(hArcData);
-
-	try {
-		if (!arc) return E_BAD_ARCHIVE;
-
-		int idx = arc->GetLastIndex();
-		const PakEntry* entry = arc->GetEntry(idx);
-
-		if (entry && entry->name == "pak_plugin.ini") {
-			if (Operation == PK_EXTRACT) {
-				std::wstring wCheck = DestName ? DestName : L"";
-				bool isViewer = IsViewerRequest(wCheck);
-
-				if (isViewer) {
-					return HandleSettingsFile(arc, entry, DestName);
-				}
-				else {
-					LogInfo("[ProcessFileW] Skipping extraction of virtual file: pak_plugin.ini");
-					return 0;
-				}
-			}
-		}
-
-		if (Operation == PK_EXTRACT) {
-			std::wstring currentDestPath = DestPath ? DestPath : L"";
-			std::wstring wCheck = DestName ? DestName : L"";
-			bool isViewer = IsViewerRequest(wCheck);
-
-			if (!isViewer && currentDestPath != g_LastTargetDir) {
-				g_ExtractOptionsShown = false;
-				g_LastTargetDir = currentDestPath;
-			}
-
-			if (!g_ExtractOptionsShown) {
-				if (isViewer && entry && entry->name == "pak_plugin.ini") {
-					return HandleSettingsFile(arc, entry, DestName);
-				}
-
-				if (!isViewer) {
-					if (g_ShowExtractPrompt) {
-						g_CurrentArchiveForDialog = arc;
-						if (entry) g_CurrentEntryForDialog = *entry;
-
-						INT_PTR result = DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_EXTRACT_OPTIONS), NULL, SettingsDialogProc, 0);
-
-						if (result == IDC_OPEN_WORKBENCH) {
-							return HandleWorkbenchLaunch(arc);
-						}
-
-						if (result == IDCANCEL) {
-							return E_EABORTED;
-						}
-
-						if (result == IDOK) {
-							LogInfo("[ProcessFileW] Extract dialog finished.");
-						}
-					}
-					g_ExtractOptionsShown = true;
-				}
-			}
-		}
-
-		if (idx < 0 || idx >= (int)arc->GetEntryCount()) return E_NO_FILES;
-		if (!entry) return E_NO_FILES;
-
-		if (Operation == PK_TEST) {
-			return HandleTest(arc, entry);
-		}
-
-		if (Operation == PK_EXTRACT) {
-			std::wstring wDestPath = DestPath ? DestPath : L"";
-			std::wstring wDestName = DestName ? DestName : L"";
-			return HandleExtract(arc, idx, entry, wDestPath, wDestName);
-		}
-
-		return 0;
-	}
-	catch (...) {
-		LogError("[ProcessFileW] Exception");
-		return E_EWRITE;
-	}
-}
-
-int __stdcall CloseArchive(HANDLE hArcData) {
-	if (!hArcData) {
-		LogError("CloseArchive: NULL handle.");
-		return E_ECLOSE;
-	}
-
-	PakArchive* archiveToClose = reinterpret_cast<PakArchive*>(hArcData);
-
-	g_LastOperationEndTime = std::chrono::steady_clock::now();
-
-	if (!g_OriginalArchivePath.empty() && (g_OriginalArchiveTime.dwLowDateTime != 0 || g_OriginalArchiveTime.dwHighDateTime != 0)) {
-
-		if (g_RequireReload) {
-			LogInfo("[CloseArchive] Refresh in progress, leaving touched timestamp for TC: " + g_OriginalArchivePath);
-		}
-		else {
-			HANDLE hRestore = CreateFileA(g_OriginalArchivePath.c_str(), FILE_WRITE_ATTRIBUTES,
-										 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-
-			if (hRestore != INVALID_HANDLE_VALUE) {
-				if (SetFileTime(hRestore, NULL, NULL, &g_OriginalArchiveTime)) {
-					LogInfo("[CloseArchive] Archive timestamp restored to exact original: " + g_OriginalArchivePath);
-				} else {
-					LogError("[CloseArchive] Failed to restore timestamp: " + std::to_string(GetLastError()));
-				}
-				CloseHandle(hRestore);
-			} else {
-				LogError("[CloseArchive] Failed to open archive for timestamp restoration: " + g_OriginalArchivePath);
-			}
-
-			g_OriginalArchiveTime = { 0 };
-			g_OriginalArchivePath = "";
-		}
-	}
-
-	try {
-		if (archiveToClose) {
-			delete archiveToClose;
-			LogInfo("Archive successfully closed and resources released.");
-			LogInfo("[CloseArchive] instance=" + std::to_string((uintptr_t)archiveToClose));
-		}
-	}
-	catch (const std::exception& ex) {
-		LogError(std::string("CloseArchive EXCEPTION during delete: ") + ex.what());
-		return E_ECLOSE;
-	}
-	catch (...) {
-		LogError("CloseArchive Unknown EXCEPTION during delete.");
-		return E_ECLOSE;
-	}
-
-	g_RequireReload = false;
-
-	return 0;
-}
-
-void __stdcall SetChangeVolProc(HANDLE hArcData, tChangeVolProc pChangeVolProc) {}
-
-void __stdcall SetProcessDataProc(HANDLE hArcData, tProcessDataProc pProcessDataProc) {
-	PakArchive* currentArchive = GetArchive(hArcData);
-	if (currentArchive) {
-		currentArchive->SetProcessDataProc(pProcessDataProc);
-	}
-}
-
-extern "C" __declspec(dllexport) void __stdcall SetSearchText(const char* SearchString) {
-	std::lock_guard<std::mutex> lock(g_SearchTextMutex);
-	if (SearchString) {
-		SearchTextW = UTF8ToWString(SearchString);
-		LogInfo("[SetSearchText] Search pattern set (A): " + WStringToUTF8(SearchTextW));
-	}
-	else {
-		SearchTextW.clear();
-		LogInfo("[SetSearchText] Search pattern cleared (A).");
-	}
-}
-
-extern "C" __declspec(dllexport) void __stdcall SetSearchTextW(const WCHAR* SearchString) {
-	std::lock_guard<std::mutex> lock(g_SearchTextMutex);
-	if (SearchString) {
-		SearchTextW = SearchString;
-		LogInfo("[SetSearchTextW] Search pattern set (W): " + WStringToUTF8(SearchTextW));
-	}
-	else {
-		SearchTextW.clear();
-		LogInfo("[SetSearchTextW] Search pattern cleared (W).");
-	}
-}
-
-static INT_PTR CALLBACK AboutDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam) {
-	switch (message) {
-	case WM_INITDIALOG: {
-		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_ABOUT_LOGO);
-		if (hLogoCtrl) {
-			RECT rect;
-			GetClientRect(hLogoCtrl, &rect);
-			int width = rect.right - rect.left;
-			int height = rect.bottom - rect.top;
-
-			HBITMAP hBmp = (HBITMAP)LoadImage(g_hModule,
-											MAKEINTRESOURCE(IDB_LOGO),
-											IMAGE_BITMAP,
-											width,
-											height,
-											LR_CREATEDIBSECTION);
-
-			if (hBmp) {
-				SendMessage(hLogoCtrl, STM_SETIMAGE, IMAGE_BITMAP, (LPARAM)hBmp);
-			}
-		}
-
-		std::wstring versionText = L"ARMA PAK Plugin v" + UTF8ToWString(PLUGIN_VERSION_STRING);
-		SetDlgItemTextW(hDlg, IDC_ABOUT_VERSION_TEXT, versionText.c_str());
-		SetDlgItemTextW(hDlg, IDC_ABOUT_AUTHOR_TEXT, L"by Icebird");
-		SetDlgItemTextW(hDlg, IDC_ABOUT_SUPPORT_TEXT, L"\u00A9 2026 Icebird. All rights reserved.");
-
-		return TRUE;
-	}
-	case WM_COMMAND: {
-		if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL) {
-			EndDialog(hDlg, LOWORD(wParam));
-			return TRUE;
-		}
-		break;
-	}
-	case WM_DESTROY: {
-		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_ABOUT_LOGO);
-		if (hLogoCtrl) {
-			HBITMAP hBmp = (HBITMAP)SendMessage(hLogoCtrl, STM_GETIMAGE, IMAGE_BITMAP, 0);
-			if (hBmp) DeleteObject(hBmp);
-		}
-		return TRUE;
-	}
-	}
-	return FALSE;
-}
-
-// ============================================================================
-// 🔥 SETTINGS DIALOG PROC
-// ============================================================================
-static INT_PTR CALLBACK SettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam) {
-	static bool isSettingsOnlyMode = false;
-
-	switch (message) {
-	case WM_INITDIALOG: {
-		isSettingsOnlyMode = (lParam == 1);
-
-		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_LOGO);
-		if (hLogoCtrl) {
-			RECT rect = { 0 };
-			GetClientRect(hLogoCtrl, &rect);
-			int width = rect.right - rect.left;
-			int height = rect.bottom - rect.top;
-
-			HBITMAP hBmp = (HBITMAP)LoadImage(g_hModule,
-											MAKEINTRESOURCE(IDB_LOGO),
-											IMAGE_BITMAP,
-											width,
-											height,
-											LR_CREATEDIBSECTION);
-
-			if (hBmp) SendMessage(hLogoCtrl, STM_SETIMAGE, IMAGE_BITMAP, (LPARAM)hBmp);
-		}
-
-		CheckDlgButton(hDlg, IDC_ENABLE_SMART_EXTRACT, g_EnableSmartExtract ? BST_CHECKED : BST_UNCHECKED);
-		CheckDlgButton(hDlg, IDC_KEEP_STRUCT, g_KeepDirectoryStructure ? BST_CHECKED : BST_UNCHECKED);
-
-		if (GetDlgItem(hDlg, IDC_ENABLE_LOG_INFO)) {
-			CheckDlgButton(hDlg, IDC_ENABLE_LOG_INFO, g_EnableLogInfo ? BST_CHECKED : BST_UNCHECKED);
-		}
-
-		if (GetDlgItem(hDlg, IDC_SHOW_EXTRACT_PROMPT)) {
-			CheckDlgButton(hDlg, IDC_SHOW_EXTRACT_PROMPT, g_ShowExtractPrompt ? BST_CHECKED : BST_UNCHECKED);
-		}
-
-		HWND hWorkbenchBtn = GetDlgItem(hDlg, IDC_OPEN_WORKBENCH);
-		if (hWorkbenchBtn) {
-			bool shouldShow = false;
-			if (!g_CurrentEntryForDialog.name.empty() && !g_CurrentEntryForDialog.isDirectory) {
-				std::string ext = fs::path(g_CurrentEntryForDialog.name).extension().string();
-				std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-				if (IsWorkbenchSupported(ext)) shouldShow = true;
-			}
-			ShowWindow(hWorkbenchBtn, shouldShow ? SW_SHOW : SW_HIDE);
-		}
-
-		return TRUE;
-	}
-
-	case WM_COMMAND: {
-		WORD controlId = LOWORD(wParam);
-
-		switch (controlId) {
-		case IDOK: {
-			g_EnableSmartExtract = (IsDlgButtonChecked(hDlg, IDC_ENABLE_SMART_EXTRACT) == BST_CHECKED);
-			g_KeepDirectoryStructure = (IsDlgButtonChecked(hDlg, IDC_KEEP_STRUCT) == BST_CHECKED);
-
-			if (GetDlgItem(hDlg, IDC_ENABLE_LOG_INFO)) {
-				g_EnableLogInfo = (IsDlgButtonChecked(hDlg, IDC_ENABLE_LOG_INFO) == BST_CHECKED);
-			}
-
-			if (GetDlgItem(hDlg, IDC_SHOW_EXTRACT_PROMPT)) {
-				g_ShowExtractPrompt = (IsDlgButtonChecked(hDlg, IDC_SHOW_EXTRACT_PROMPT) == BST_CHECKED);
-			}
-
-			SaveSettings();
-			EndDialog(hDlg, IDOK);
-			return TRUE;
-		}
-		case IDC_OPEN_WORKBENCH: {
-			EndDialog(hDlg, IDC_OPEN_WORKBENCH);
-			return TRUE;
-		}
-		case IDCANCEL: {
-			EndDialog(hDlg, LOWORD(wParam));
-			return TRUE;
-		}
-		case IDC_ABOUT_BUTTON: {
-			DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ABOUTBOX), hDlg, AboutDialogProc, 0);
-			return TRUE;
-		}
-		}
-		break;
-	}
-
-	case WM_DESTROY: {
-		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_LOGO);
-		if (hLogoCtrl) {
-			HBITMAP hBmp = (HBITMAP)SendMessage(hLogoCtrl, STM_GETIMAGE, IMAGE_BITMAP, 0);
-			if (hBmp) DeleteObject(hBmp);
-		}
-		return TRUE;
-	}
-	}
-	return FALSE;
-}
-
-extern "C" __declspec(dllexport) int __stdcall ConfigurePacker(HWND Parent, HINSTANCE DllInstance) {
-	g_LastOpenedArcName = "";
-	DialogBoxParam(DllInstance, MAKEINTRESOURCE(IDD_ARMAPAK_SETTINGS), Parent, SettingsDialogProc, 0);
-	return 0;
-}
-
-extern "C" __declspec(dllexport) void __stdcall About(HWND Parent) {
-	DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ABOUTBOX), Parent, AboutDialogProc, 0);
-}
-
-extern "C" __declspec(dllexport) int __stdcall GetPackerCaps() {
-	return PK_CAPS_MULTIPLE | PK_CAPS_BY_CONTENT | PK_CAPS_OPTIONS | PK_CAPS_SEARCHTEXT | PK_CAPS_MEMPACK;
-}
-
-static BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved) {
-	switch (ul_reason_for_call) {
-	case DLL_PROCESS_ATTACH:
-		g_hModule = hModule;
-		{
-			std::error_code ec;
-			if (!fs::exists(GetIniPath(), ec)) {
-				SaveSettings();
-			} else {
-				LoadSettings();
-			}
-		}
-
-		if (!g_ThreadPool) {
-			unsigned int numThreads = std::thread::hardware_concurrency();
-			if (numThreads == 0) numThreads = 4;
-			g_ThreadPool = std::make_unique<ThreadPool>(numThreads);
-		}
-
-		{
-			std::string logFilePath = GetLogPath();
-			debugLog.open(logFilePath, std::ios::out | std::ios::app);
-			if (debugLog.is_open()) {
-				logInitialized = true;
-				time_t now = time(nullptr);
-				char timeStr[26];
-				ctime_s(timeStr, sizeof(timeStr), &now);
-				if (timeStr[strlen(timeStr) - 1] == '\n') timeStr[strlen(timeStr) - 1] = '\0';
-
-				debugLog << "\n\n=== DLL ATTACH: New session === " << timeStr << "\n";
-				debugLog << "Plugin version: " << PLUGIN_VERSION_STRING << "\n";
-				debugLog << "[INIT] Settings loaded.\n";
-				debugLog.flush();
-			}
-		}
-		break;
-	case DLL_PROCESS_DETACH:
-		if (g_ThreadPool) g_ThreadPool.reset();
-		if (logInitialized && debugLog.is_open()) {
-			debugLog << "[INFO] === DLL DETACH: Session end ===\n";
-			debugLog.close();
-		}
-		break;
-	}
-	return TRUE;
-}
-
-bool SmartExtractor::ExtractWithDependencies(PakArchive* sourceArc, int index, const std::string& destPath, std::unordered_set<std::string>& processed)
-{
-	struct TaskInfo {
-		int entryIndex;
-		std::string targetFullPath;
-		PakArchive* sourceArchive;
-	};
-
-	static std::mutex g_BucketMutexes[64];
-	auto GetBucketLock = [](const std::string& path) -> std::mutex& {
-		size_t h = std::hash<std::string>{}(path);
-		return g_BucketMutexes[h % 64];
-	};
-
-	static std::mutex g_FileWriteMutex;
-
-	std::vector<std::future<bool>> activeTasks;
-	std::queue<TaskInfo> pendingTasks;
-
-	const PakEntry* rootEntry = sourceArc->GetEntry(index);
-	if (!rootEntry) return false;
-
-	fs::path winDestFile(destPath);
-
-	bool isViewer = winDestFile.has_filename() && winDestFile.extension() != "";
-	fs::path baseExtractionDir = winDestFile.parent_path();
-	fs::path rootParent = fs::path(rootEntry->name).parent_path();
-
-	fs::path finalRootPath;
-	if (isViewer) {
-		finalRootPath = winDestFile;
-	} else {
-		finalRootPath = PakArchive::BuildFinalPath(baseExtractionDir.string(), rootEntry->name);
-	}
-
-	pendingTasks.push({ index, finalRootPath.string(), sourceArc });
-
-	while (!pendingTasks.empty() || !activeTasks.empty()) {
-
-		while (!pendingTasks.empty()) {
-			TaskInfo current = pendingTasks.front();
-			pendingTasks.pop();
-
-			const PakEntry* entry = current.sourceArchive->GetEntry(current.entryIndex);
-			if (!entry || entry->isDirectory) continue;
-
-			std::string uniqueKey = current.sourceArchive->GetFilename() + "|" + entry->name;
-			if (processed.count(uniqueKey)) continue;
-
-			if (processed.size() > 8000) {
-				LogInfo("[LIMIT] Reached 8000 files, stopping dependency chain.");
-				break;
-			}
-			processed.insert(uniqueKey);
-
-			LogInfo("[EXTRACT] " + entry->name);
-
-			fs::path fPath(current.targetFullPath);
-			if (!fs::exists(fPath.parent_path())) {
-				fs::create_directories(fPath.parent_path());
-			}
-
-			std::string ext = fs::path(entry->name).extension().string();
-			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-			if (ext == ".xob" || ext == ".emat") {
-				try {
-					static std::mutex g_DecompressMutex;
-					std::vector<uint8_t> data;
-					{
-						std::lock_guard<std::mutex> lock(g_DecompressMutex);
-						data = current.sourceArchive->DecompressEntryData(entry);
-					}
-
-					auto deps = FindDependencies(current.sourceArchive, data);
-
-					for (const auto& depLine : deps) {
-						LogInfo("[DEP RAW] " + depLine);
-
-						std::string cleanPath = depLine;
-
-						size_t bracePos = cleanPath.find('}');
-						if (bracePos != std::string::npos) cleanPath = cleanPath.substr(bracePos + 1);
-
-						auto startIdx = cleanPath.find_first_not_of(" \t\n\r");
-						auto endIdx = cleanPath.find_last_not_of(" \t\n\r");
-						if (startIdx == std::string::npos || endIdx == std::string::npos) continue;
-						cleanPath = cleanPath.substr(startIdx, endIdx - startIdx + 1);
-
-						std::replace(cleanPath.begin(), cleanPath.end(), '/', '\\');
-						std::transform(cleanPath.begin(), cleanPath.end(), cleanPath.begin(), ::tolower);
-
-						size_t assetsPos = cleanPath.find("assets\\");
-						if (assetsPos != std::string::npos) cleanPath = cleanPath.substr(assetsPos);
-						size_t commonPos = cleanPath.find("common\\");
-						if (commonPos != std::string::npos) cleanPath = cleanPath.substr(commonPos);
-
-						const PakEntry* depEntry = nullptr;
-						PakArchive* targetArchive = nullptr;
-
-						auto tryFind = [&](const std::string& p) -> const PakEntry* {
-							std::lock_guard<std::mutex> lock(g_ArchivesMutex);
-							for (auto* arc : g_OpenedArchives) {
-								if (auto* e = arc->FindEntryByName(p)) {
-									targetArchive = arc;
-									return e;
-								}
-							}
-							return nullptr;
-						};
-
-						depEntry = tryFind(cleanPath);
-
-						if (depEntry && targetArchive) {
-							std::string depKey = targetArchive->GetFilename() + "|" + depEntry->name;
-							if (!processed.count(depKey)) {
-
-								fs::path relDep = fs::relative(depEntry->name, rootParent);
-								fs::path subDest = baseExtractionDir / relDep;
-
-								int depIndex = targetArchive->GetEntryIndex(depEntry);
-								if (depIndex != -1) {
-									pendingTasks.push({ depIndex, subDest.string(), targetArchive });
-								} else {
-									LogInfo("[DEP ERROR] Index mapping failed for: " + depEntry->name);
-								}
-							}
-						}
-						else {
-							LogInfo("[DEP NOT FOUND] " + cleanPath);
-						}
-					}
-				}
-				catch (...) {
-					LogInfo("[DEP ERROR] Failed to process dependencies for: " + entry->name);
-				}
-			}
-
-			if (g_ThreadPool) {
-				activeTasks.push_back(g_ThreadPool->enqueue([src = current.sourceArchive, idx = current.entryIndex, p = current.targetFullPath, &GetBucketLock]() {
-
-					if (fs::exists(p)) {
-						LogInfo("[SKIP] Already exists: " + p);
-						return true;
-					}
-
-					std::lock_guard<std::mutex> lock(GetBucketLock(p));
-
-					if (fs::exists(p)) {
-						LogInfo("[SKIP AFTER LOCK] Already exists: " + p);
-						return true;
-					}
-
-					return src->ExtractFile(idx, p);
-				}));
-			}
-			else {
-				std::lock_guard<std::mutex> lock(GetBucketLock(current.targetFullPath));
-
-				if (fs::exists(current.targetFullPath)) {
-					LogInfo("[SKIP] Already exists: " + current.targetFullPath);
-					continue;
-				}
-
-				current.sourceArchive->ExtractFile(current.entryIndex, current.targetFullPath);
-			}
-		}
-
-		for (auto& fut : activeTasks) {
-			if (fut.valid()) fut.get();
-		}
-		activeTasks.clear();
-	}
-
-	return true;
-}
-
-std::vector<std::string> SmartExtractor::FindDependencies(PakArchive* sourceArc, const std::vector<uint8_t>& data) {
-	std::vector<std::string> results;
-	if (data.empty()) return results;
-
-	const std::vector<std::string> extensions = { ".emat", ".edds", ".xob", ".gamemat" };
-
-	for (size_t i = 0; i < data.size(); ) {
-		if (data[i] >= 32 && data[i] <= 126) {
-			size_t start = i;
-
-			while (i < data.size() && data[i] >= 32 && data[i] <= 126) {
-				i++;
-			}
-
-			std::string block(reinterpret_cast<const char*>(&data[start]), i - start);
-
-			std::string lowerBlock = block;
-			std::transform(lowerBlock.begin(), lowerBlock.end(), lowerBlock.begin(), ::tolower);
-
-			size_t p = std::string::npos;
-			size_t pA = lowerBlock.find("assets/");
-			size_t pC = lowerBlock.find("common/");
-
-			if (pA != std::string::npos) p = pA;
-			else if (pC != std::string::npos) p = pC;
-
-			if (p == std::string::npos)
-				continue;
-
-			std::string candidate = block.substr(p);
-
-			size_t end = 0;
-			for (; end < candidate.size(); end++) {
-				unsigned char c = (unsigned char)candidate[end];
-
-				if (!(c > 32 &&
-					c != '"' && c != '\'' &&
-					c != '<' && c != '>' &&
-					c != '{' && c != '}' &&
-					c != '(' && c != ')' &&
-					c != '[' && c != ']' &&
-					c != '|'))
-				{
-					break;
-				}
-			}
-
-			candidate = candidate.substr(0, end);
-
-			auto s = candidate.find_first_not_of(" \t\r\n");
-			auto e = candidate.find_last_not_of(" \t\r\n");
-
-			if (s == std::string::npos || e == std::string::npos)
-				continue;
-
-			candidate = candidate.substr(s, e - s + 1);
-
-			if (!candidate.empty() && candidate.front() == '"') candidate.erase(candidate.begin());
-			if (!candidate.empty() && candidate.back() == '"') candidate.pop_back();
-
-			std::replace(candidate.begin(), candidate.end(), '/', '\\');
-
-			std::string lowerCand = candidate;
-			std::transform(lowerCand.begin(), lowerCand.end(), lowerCand.begin(), ::tolower);
-
-			bool validExt = false;
-			for (const auto& ext : extensions) {
-				if (lowerCand.size() >= ext.size() &&
-					lowerCand.compare(lowerCand.size() - ext.size(), ext.size(), ext) == 0)
-				{
-					validExt = true;
-					break;
-				}
-			}
-
-			if (!validExt)
-				continue;
-
-			if (candidate.length() >= 5 && candidate.length() <= 260) {
-				if (LooksLikePath(candidate)) {
-
-					if (lowerCand.find("assets\\") != std::string::npos) {
-						LogInfo("[DEP PARSED] " + candidate);
-						results.push_back(candidate);
-					}
-					else {
-						LogInfo("[DEP PARSED fallback] " + candidate);
-						results.push_back(candidate);
-					}
-				}
-			}
-		}
-		else {
-			i++;
-		}
-	}
-
-	std::sort(results.begin(), results.end());
-	results.erase(std::unique(results.begin(), results.end()), results.end());
-
-	return results;
-}
-
-bool SmartExtractor::LooksLikePath(const std::string& s) {
-	if (s.length() < 5 || s.length() > 260) return false;
-	if (s.find('.') == std::string::npos) return false;
-	if (s.find('\\') == std::string::npos && s.find('/') == std::string::npos) return false;
-
-	return std::all_of(s.begin(), s.end(), [](char c) {
-		return std::isprint((unsigned char)c);
-		});
-}
\ No newline at end of file
+#define NOMINMAX
+#define _CRT_SECURE_NO_WARNINGS
+#ifndef TCM_GETITEMCOUNT
+#define TCM_GETITEMCOUNT (TCM_FIRST + 4)
+#endif
+#include "wcxhead.h"
+#include "resource.h"
+// EDDS és DDS konverterek eltávolítva
+#include "ThreadPool.h"
+#include "AdaptiveConcurrency.h"
+#include "IoRateLimiter.h"
+
+#include <windows.h>
+#include <commctrl.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+#include <memory>
+#include <map>
+#include <ctime>
+#include <assert.h>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <cctype>
+#include <unordered_set>
+#include <mutex>
+#include <span>
+#include <queue>
+#include <deque>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <type_traits>
+#include <tlhelp32.h>
+
+namespace fs = std::filesystem;
+
+// EddsTargetFormat enum és hivatkozás eltávolítva
+
+const char* PLUGIN_VERSION_STRING = "1.2.0";
+
+extern std::unique_ptr<ThreadPool> g_ThreadPool;
+extern std::unique_ptr<ThreadPool> g_IoPool;
+
+class PakArchive;
+class PakIndex;
+
+class PakEntry {
+public:
+	enum class CompressionType : uint32_t {
+		None = 0,
+		Zlib = 0x106
+	};
+
+	uint32_t timestamp = 0;
+	std::string name = "";
+	uint32_t offset = 0;
+	uint32_t size = 0;
+	uint32_t originalSize = 0;
+	CompressionType compression = CompressionType::None;
+	bool isDirectory = false;
+	std::vector<std::shared_ptr<PakEntry>> children;
+};
+
+#include "SmartExtractor.h"
+#include "TarExporter.h"
+#include "GlobalIndex.h"
+#include "GameCatalog.h"
+#include "ResolveMemo.h"
+#include "DependencyCache.h"
+#include "PathScanner.h"
+#include "ContentMatcher.h"
+#include "ContentType.h"
+#include "ContentIndex.h"
+#include "PatternSet.h"
+#include "GuidIndex.h"
+#include "DependencyGraph.h"
+#include "pak_index.h"
+
+void LogError(const std::string& message);
+void LogInfo(const std::string& message);
+
+static std::ofstream debugLog;
+static bool logInitialized = false;
+static std::mutex g_LogMutex;
+std::mutex g_CallbackMutex;
+static std::mutex g_SearchTextMutex;
+
+std::vector<PakArchive*> g_OpenedArchives;
+std::mutex g_ArchivesMutex;
+
+// Konverziós kapcsolók eltávolítva
+bool g_EnableLogInfo = false;
+bool g_EnableSmartExtract = false;
+bool g_KeepDirectoryStructure = true;
+bool g_ShowExtractPrompt = true;
+std::string g_CatalogDirs;
+int g_SmartExtractMaxFiles = 8000;
+int g_SmartExtractMaxMB = 2048;
+bool g_FuzzyResolve = false;
+int g_CpuThreads = 0;
+int g_IoThreads = 32;
+int g_PoolIdleSeconds = 30;
+int g_ReadLimitMBps = 0;
+int g_ReadLimitIops = 0;
+int g_WriteLimitMBps = 0;
+int g_WriteLimitIops = 0;
+bool g_UseContentIndex = false;
+std::string g_SearchTypes;
+
+// Optional caps on archive entry reads and on extracted-file / tar writes,
+// so a large extraction leaves disk bandwidth to the game or Workbench.
+static IoRateLimiter g_ReadLimiter;
+static IoRateLimiter g_WriteLimiter;
+static FILETIME g_IoLimitsIniTime = { 0 };
+static std::wstring SearchTextW;
+
+static std::unordered_map<std::string, std::unique_ptr<std::mutex>> g_FileWriteLocks;
+static std::mutex g_FileWriteLocksMutex;
+
+const char* const INI_KEY_SMART_EXTRACT = "EnableSmartExtract";
+const char* const INI_KEY_KEEP_STRUCT = "KeepDirectoryStructure";
+const char* const INI_FILE_NAME = "pak_plugin.ini";
+const char* const INI_SECTION_NAME = "Settings";
+// EDDS kulcsok eltávolítva az INI-ből
+const char* const INI_KEY_LOG_INFO = "EnableLogInfo";
+const char* const INI_KEY_CATALOG_DIRS = "CatalogDirs";
+const char* const INI_KEY_SMART_MAX_FILES = "SmartExtractMaxFiles";
+const char* const INI_KEY_SMART_MAX_MB = "SmartExtractMaxMB";
+const char* const INI_KEY_FUZZY_RESOLVE = "FuzzyResolve";
+const char* const INI_KEY_CPU_THREADS = "CpuThreads";
+const char* const INI_KEY_IO_THREADS = "IoThreads";
+const char* const INI_KEY_POOL_IDLE = "PoolIdleSeconds";
+const char* const INI_KEY_READ_LIMIT_MBPS = "ReadLimitMBps";
+const char* const INI_KEY_READ_LIMIT_IOPS = "ReadLimitIops";
+const char* const INI_KEY_WRITE_LIMIT_MBPS = "WriteLimitMBps";
+const char* const INI_KEY_WRITE_LIMIT_IOPS = "WriteLimitIops";
+const char* const INI_KEY_CONTENT_INDEX = "ContentIndex";
+const char* const INI_KEY_SEARCH_TYPES = "SearchTypes";
+const char* const CATALOG_FILE_STEM = "pak_catalog";
+const char* const DEPENDENCY_CACHE_DIR = "pak_depcache";
+const char* const CONTENT_INDEX_DIR = "pak_textindex";
+const char* const LOG_FILE_NAME = "pak_plugin.log";
+
+static HMODULE g_hModule = NULL;
+
+static std::string GetPluginPath() {
+	char path[MAX_PATH];
+	if (g_hModule != NULL) {
+		GetModuleFileNameA(g_hModule, path, MAX_PATH);
+	} else {
+		GetModuleFileNameA(NULL, path, MAX_PATH);
+	}
+	std::filesystem::path plugin_path(path);
+	return plugin_path.parent_path().string();
+}
+
+static std::string GetLogPath() {
+	return GetPluginPath() + "\\" + LOG_FILE_NAME;
+}
+
+static std::string GetIniPath() {
+	return GetPluginPath() + "\\" + INI_FILE_NAME;
+}
+
+static void CheckLogRotation() {
+	std::string path = GetLogPath();
+
+	std::error_code ec;
+	if (fs::exists(path, ec)) {
+		if (fs::file_size(path, ec) > 5 * 1024 * 1024) {
+			if (debugLog.is_open()) debugLog.close();
+
+			debugLog.open(path, std::ios::out | std::ios::trunc);
+
+			if (debugLog.is_open()) {
+				debugLog << "[INFO] Log file rotated (size limit reached, cleared).\n";
+				debugLog.flush();
+			}
+		}
+	}
+}
+
+void LogError(const std::string& message) {
+	std::lock_guard<std::mutex> lock(g_LogMutex);
+	CheckLogRotation();
+
+	if (logInitialized && debugLog.is_open()) {
+		debugLog << "[ERROR] " << message << "\n";
+		debugLog.flush();
+	}
+}
+
+void LogInfo(const std::string& message) {
+	if (!g_EnableLogInfo) return;
+	std::lock_guard<std::mutex> lock(g_LogMutex);
+	CheckLogRotation();
+
+	if (logInitialized && debugLog.is_open()) {
+		debugLog << "[INFO] " << message << "\n";
+		debugLog.flush();
+	}
+}
+
+static void ApplyIoLimits() {
+	const uint64_t MB = 1024 * 1024;
+	g_ReadLimiter.Configure((uint64_t)std::max(0, g_ReadLimitMBps) * MB, (uint64_t)std::max(0, g_ReadLimitIops));
+	g_WriteLimiter.Configure((uint64_t)std::max(0, g_WriteLimitMBps) * MB, (uint64_t)std::max(0, g_WriteLimitIops));
+}
+
+static void LoadIoLimits(const std::string& iniPath) {
+	g_ReadLimitMBps  = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_READ_LIMIT_MBPS, 0, iniPath.c_str());
+	g_ReadLimitIops  = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_READ_LIMIT_IOPS, 0, iniPath.c_str());
+	g_WriteLimitMBps = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_WRITE_LIMIT_MBPS, 0, iniPath.c_str());
+	g_WriteLimitIops = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_WRITE_LIMIT_IOPS, 0, iniPath.c_str());
+	ApplyIoLimits();
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExA(iniPath.c_str(), GetFileExInfoStandard, &attributes)) g_IoLimitsIniTime = attributes.ftLastWriteTime;
+}
+
+// Picks up limits changed by IoLimit (or by hand) while TC keeps the plugin loaded.
+static void RefreshIoLimits() {
+	std::string iniPath = GetIniPath();
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(iniPath.c_str(), GetFileExInfoStandard, &attributes)) return;
+	if (CompareFileTime(&attributes.ftLastWriteTime, &g_IoLimitsIniTime) == 0) return;
+
+	LoadIoLimits(iniPath);
+	LogInfo("[IoLimit] Read " + std::to_string(g_ReadLimitMBps) + " MB/s " + std::to_string(g_ReadLimitIops) + " IOPS, write " +
+			std::to_string(g_WriteLimitMBps) + " MB/s " + std::to_string(g_WriteLimitIops) + " IOPS (0 = unlimited)");
+}
+
+// The I/O limits are written only here, not by SaveSettings: another
+// process (IoLimit) may have changed them since this one last read them.
+static void SaveIoLimits() {
+	std::string iniPath = GetIniPath();
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_READ_LIMIT_MBPS, std::to_string(g_ReadLimitMBps).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_READ_LIMIT_IOPS, std::to_string(g_ReadLimitIops).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_WRITE_LIMIT_MBPS, std::to_string(g_WriteLimitMBps).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_WRITE_LIMIT_IOPS, std::to_string(g_WriteLimitIops).c_str(), iniPath.c_str());
+}
+
+static void LoadSettings() {
+	std::string iniPath = GetIniPath();
+	g_EnableLogInfo          = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_LOG_INFO, 0, iniPath.c_str()) != 0;
+	g_EnableSmartExtract    = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_SMART_EXTRACT, 1, iniPath.c_str()) != 0;
+	g_KeepDirectoryStructure = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_KEEP_STRUCT, 1, iniPath.c_str()) != 0;
+	g_ShowExtractPrompt      = GetPrivateProfileIntA(INI_SECTION_NAME, "ShowExtractPrompt", 1, iniPath.c_str()) != 0;
+	g_SmartExtractMaxFiles   = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_SMART_MAX_FILES, 8000, iniPath.c_str());
+	g_SmartExtractMaxMB      = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_SMART_MAX_MB, 2048, iniPath.c_str());
+	g_FuzzyResolve           = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_FUZZY_RESOLVE, 0, iniPath.c_str()) != 0;
+	g_CpuThreads             = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_CPU_THREADS, 0, iniPath.c_str());
+	g_IoThreads              = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_IO_THREADS, 32, iniPath.c_str());
+	g_PoolIdleSeconds        = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_POOL_IDLE, 30, iniPath.c_str());
+	g_UseContentIndex        = GetPrivateProfileIntA(INI_SECTION_NAME, INI_KEY_CONTENT_INDEX, 0, iniPath.c_str()) != 0;
+	LoadIoLimits(iniPath);
+
+	char dirs[4096] = { 0 };
+	GetPrivateProfileStringA(INI_SECTION_NAME, INI_KEY_CATALOG_DIRS, "", dirs, sizeof(dirs), iniPath.c_str());
+	g_CatalogDirs = dirs;
+
+	char types[256] = { 0 };
+	GetPrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SEARCH_TYPES, "", types, sizeof(types), iniPath.c_str());
+	g_SearchTypes = types;
+}
+
+static void SaveSettings() {
+	std::string iniPath = GetIniPath();
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_LOG_INFO, g_EnableLogInfo ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SMART_EXTRACT, g_EnableSmartExtract ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_KEEP_STRUCT, g_KeepDirectoryStructure ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, "ShowExtractPrompt", g_ShowExtractPrompt ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_CATALOG_DIRS, g_CatalogDirs.c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SMART_MAX_FILES, std::to_string(g_SmartExtractMaxFiles).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SMART_MAX_MB, std::to_string(g_SmartExtractMaxMB).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_FUZZY_RESOLVE, g_FuzzyResolve ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_CPU_THREADS, std::to_string(g_CpuThreads).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_IO_THREADS, std::to_string(g_IoThreads).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_POOL_IDLE, std::to_string(g_PoolIdleSeconds).c_str(), iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_CONTENT_INDEX, g_UseContentIndex ? "1" : "0", iniPath.c_str());
+	WritePrivateProfileStringA(INI_SECTION_NAME, INI_KEY_SEARCH_TYPES, g_SearchTypes.c_str(), iniPath.c_str());
+}
+
+static unsigned int SystemTimeToDosDateTime(const SYSTEMTIME& st) {
+	const unsigned int year   = static_cast<unsigned int>(st.wYear);
+	const unsigned int month  = static_cast<unsigned int>(st.wMonth);
+	const unsigned int day    = static_cast<unsigned int>(st.wDay);
+	const unsigned int hour   = static_cast<unsigned int>(st.wHour);
+	const unsigned int minute = static_cast<unsigned int>(st.wMinute);
+	const unsigned int second = static_cast<unsigned int>(st.wSecond);
+	unsigned int dosDate = ((year - 1980) << 9) | (month << 5) | day;
+	unsigned int dosTime = (hour << 11) | (minute << 5) | (second / 2);
+	return (dosDate << 16) | (dosTime & 0xFFFF);
+}
+
+static std::string WStringToUTF8(const wchar_t* ws) {
+	if (!ws || ws[0] == L'\0') return "";
+	int len = (int)wcslen(ws);
+	int size_needed = WideCharToMultiByte(CP_UTF8, 0, ws, len, nullptr, 0, nullptr, nullptr);
+	if (size_needed <= 0) return "";
+	std::string result(size_needed, 0);
+	WideCharToMultiByte(CP_UTF8, 0, ws, len, &result[0], size_needed, nullptr, nullptr);
+	return result;
+}
+
+static std::string WStringToUTF8(const std::wstring& ws) {
+	return WStringToUTF8(ws.c_str());
+}
+
+static std::string WCharToUTF8(const WCHAR* ws) {
+	return WStringToUTF8(ws);
+}
+
+static std::wstring UTF8ToWString(const std::string& str) {
+	if (str.empty()) return L"";
+	int size_needed = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), NULL, 0);
+	if (size_needed <= 0) return L"";
+	std::wstring wstrTo(size_needed, 0);
+	MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), &wstrTo[0], size_needed);
+	return wstrTo;
+}
+
+class PakArchive {
+private:
+	std::shared_ptr<PakEntry> root;
+	std::vector<std::shared_ptr<PakEntry>> flatEntries;
+	std::string filename;
+	bool initialized = false;
+	bool m_Registered = true;
+	long long actualFileSize = 0;
+
+	// Small process-unique id, so (archive, entry) pairs fit in one integer.
+	static inline std::atomic<uint32_t> s_NextSerial{ 0 };
+	const uint32_t m_Serial = s_NextSerial.fetch_add(1, std::memory_order_relaxed);
+
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+
+	std::atomic<int> m_CurrentIndex{0};
+	std::atomic<int> m_LastIndex{-1};
+	std::mutex indexMutex;
+	mutable std::mutex m_FileMutex;
+
+	std::atomic<std::shared_ptr<const PakIndex>> m_index;
+
+	// Content type of every entry, one byte each, published like m_index.
+	// BuildIndex sets it from the extensions; entries whose extension says
+	// nothing stay Unknown until SniffEntryTypes has read their first bytes.
+	std::atomic<std::shared_ptr<const std::vector<ContentType>>> m_Types;
+	std::mutex m_SniffMutex;
+	bool m_TypesSniffed = false;
+
+	tProcessDataProc m_pProcessDataProc = nullptr;
+
+	// Result of the last TC search on this archive, one flag per entry.
+	std::mutex m_SearchMutex;
+	std::wstring m_SearchPattern;
+	std::vector<bool> m_SearchHits;
+
+	struct IffChunk {
+		char id[4];
+		uint32_t size;
+		uint64_t dataStart;
+		uint64_t dataEnd;
+	};
+
+	bool InternalRead(void* buffer, DWORD size) {
+		DWORD bytesRead = 0;
+		return ReadFile(hFile, buffer, size, &bytesRead, NULL) && bytesRead == size;
+	}
+
+	uint32_t ReadU32BE() {
+		uint32_t val;
+		if (!InternalRead(&val, 4)) throw std::runtime_error("Read error (U32BE)");
+		return _byteswap_ulong(val);
+	}
+
+	uint32_t ReadU32LE() {
+		uint32_t val;
+		if (!InternalRead(&val, 4)) throw std::runtime_error("Read error (U32LE)");
+		return val;
+	}
+
+	uint8_t ReadU8() {
+		uint8_t val;
+		if (!InternalRead(&val, 1)) throw std::runtime_error("Read error (U8)");
+		return val;
+	}
+
+	std::string ReadString(uint8_t length) {
+		if (length == 0) return "";
+		std::string str(length, '\0');
+		if (!InternalRead(&str[0], length)) throw std::runtime_error("Read error (String)");
+		return str;
+	}
+
+	bool ReadNextChunk(IffChunk& chunk) {
+		LARGE_INTEGER currentPos;
+		currentPos.QuadPart = 0;
+		if (!SetFilePointerEx(hFile, currentPos, &currentPos, FILE_CURRENT)) return false;
+
+		if (currentPos.QuadPart + 8 > actualFileSize) return false;
+
+		if (!InternalRead(chunk.id, 4)) return false;
+		chunk.size = ReadU32BE();
+		chunk.dataStart = currentPos.QuadPart + 8;
+		chunk.dataEnd = chunk.dataStart + chunk.size;
+
+		if (chunk.dataEnd > (uint64_t)actualFileSize) {
+			LogError("Chunk '" + std::string(chunk.id, 4) + "' size exceeds file bounds.");
+			return false;
+		}
+		return true;
+	}
+
+	void ProcessHeadChunk(const IffChunk& chunk) {
+		LARGE_INTEGER li;
+		li.QuadPart = chunk.dataEnd;
+		SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
+	}
+
+	void ProcessFileChunk(const IffChunk& chunk) {
+		uint8_t entryType = ReadU8();
+		uint8_t nameLength = ReadU8();
+		std::string name = ReadString(nameLength);
+
+		if (entryType == 0) root->children.push_back(ReadDirectoryEntry(name));
+		else root->children.push_back(ReadFileEntry(name));
+
+		LARGE_INTEGER li;
+		li.QuadPart = chunk.dataEnd;
+		SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
+	}
+
+	std::shared_ptr<PakEntry> ReadDirectoryEntry(const std::string& name) {
+		auto entry = std::make_shared<PakEntry>();
+		entry->name = name;
+		entry->isDirectory = true;
+
+		uint32_t childCount = ReadU32LE();
+
+		entry->timestamp = static_cast<uint32_t>(time(nullptr));
+
+		for (uint32_t i = 0; i < childCount; i++) {
+			uint8_t childType = ReadU8();
+			uint8_t childNameLength = ReadU8();
+			std::string childName = ReadString(childNameLength);
+
+			if (childType == 0) {
+				entry->children.push_back(ReadDirectoryEntry(childName));
+			} else {
+				entry->children.push_back(ReadFileEntry(childName));
+			}
+		}
+		return entry;
+	}
+
+	std::shared_ptr<PakEntry> ReadFileEntry(const std::string& name) {
+		auto entry = std::make_shared<PakEntry>();
+		entry->name = name;
+		entry->isDirectory = false;
+		entry->offset = ReadU32LE();
+		entry->size = ReadU32LE();
+		entry->originalSize = ReadU32LE();
+
+		LARGE_INTEGER li; li.QuadPart = 4;
+		SetFilePointerEx(hFile, li, NULL, FILE_CURRENT);
+		entry->compression = static_cast<PakEntry::CompressionType>(ReadU32BE());
+		entry->timestamp = ReadU32LE();
+
+		return entry;
+	}
+
+	void FlattenEntries(const std::shared_ptr<PakEntry>& entry, const std::string& path = "") {
+		std::string fullPath = path;
+		if (entry.get() != root.get()) {
+			if (!fullPath.empty()) fullPath += "\\";
+			fullPath += entry->name;
+		}
+		if (entry.get() != root.get()) {
+			auto flatEntry = std::make_shared<PakEntry>(*entry);
+			flatEntry->name = fullPath;
+			flatEntries.push_back(flatEntry);
+		}
+		for (const auto& child : entry->children) FlattenEntries(child, fullPath);
+	}
+
+public:
+	void AddVirtualEntry(const std::string& name) {
+		auto entry = std::make_shared<PakEntry>();
+		entry->name = name;
+		entry->isDirectory = false;
+		entry->size = 1;
+		entry->originalSize = 1;
+		entry->offset = 0;
+		entry->compression = PakEntry::CompressionType::None;
+
+		entry->timestamp = static_cast<uint32_t>(time(nullptr));
+
+		flatEntries.push_back(entry);
+	}
+
+	void BuildIndex() {
+		if (flatEntries.empty()) return;
+
+		// RCU-style: the new index is built off to the side and swapped in;
+		// readers holding the previous snapshot finish on it undisturbed.
+		m_index.store(std::make_shared<const PakIndex>(flatEntries));
+		ResolveMemo::Invalidate();
+
+		auto types = std::make_shared<std::vector<ContentType>>(flatEntries.size());
+		for (size_t i = 0; i < flatEntries.size(); ++i) {
+			(*types)[i] = flatEntries[i]->isDirectory ? ContentType::Unknown : ContentClassifier::FromExtension(flatEntries[i]->name);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_SniffMutex);
+			m_Types.store(std::move(types));
+			m_TypesSniffed = false;
+		}
+
+		if (initialized && m_Registered) GlobalIndex::OnArchiveOpened(this);
+	}
+
+	std::shared_ptr<const PakIndex> GetIndex() const { return m_index.load(); }
+
+	int FindIndexByName(const std::string& name) const {
+		auto index = m_index.load();
+		return index ? index->FindPath(name) : -1;
+	}
+
+	std::string GetFilename() const { return filename; }
+	uint32_t GetSerial() const { return m_Serial; }
+
+	int GetEntryIndex(const PakEntry* entry) const {
+		if (!entry || flatEntries.empty()) return -1;
+
+		for (size_t i = 0; i < flatEntries.size(); ++i) {
+			if (flatEntries[i].get() == entry) return (int)i;
+		}
+
+		return -1;
+	}
+
+	const PakEntry* FindEntryByName(const std::string& name) const {
+		PakArchive* owner = nullptr;
+		int index = -1;
+		return ResolveEntry(name, owner, index) ? owner->flatEntries[index].get() : nullptr;
+	}
+
+	// Resolves a dependency path: this archive first, then the game-wide
+	// overlay of all opened archives, then the persistent catalog, each with the "assets\\" and "common\\"
+	// prefix fallbacks. When all of them miss, the nearest entry by file name
+	// and folders is used when FuzzyResolve is on (off by default). Results, including misses, are memoised for the session.
+	bool ResolveEntry(const std::string& name, PakArchive*& owner, int& index) const {
+		ResolveMemo::Result cached;
+		if (ResolveMemo::Lookup(this, name, cached)) {
+			owner = cached.archive;
+			index = cached.index;
+			return cached.archive != nullptr;
+		}
+
+		uint64_t generation = ResolveMemo::Generation();
+		bool found = ResolveUncached(name, owner, index);
+		ResolveMemo::Store(this, name, generation, found ? ResolveMemo::Result{ owner, index } : ResolveMemo::Result{});
+		return found;
+	}
+
+	bool ResolveUncached(const std::string& name, PakArchive*& owner, int& index) const {
+		LogInfo("[FindEntry] SEARCH: " + name);
+		auto ownIndex = m_index.load();
+
+		auto tryFindExact = [&](std::string_view prefix) -> bool {
+			if (ownIndex && !ownIndex->MayContain(name, prefix)) {
+				ResolveMemo::CountFiltered();
+			} else if (int idx = ownIndex ? ownIndex->FindPath(name, prefix) : -1; idx >= 0) {
+				owner = const_cast<PakArchive*>(this);
+				index = idx;
+				return true;
+			}
+
+			GlobalIndex::Hit hit = GlobalIndex::Resolve(name, prefix);
+			if (hit.archive) {
+				owner = hit.archive;
+				index = hit.index;
+				return true;
+			}
+
+			GameCatalog::Hit catalogHit = GameCatalog::Resolve(name, prefix);
+			if (catalogHit.archive) {
+				owner = catalogHit.archive;
+				index = catalogHit.index;
+				return true;
+			}
+			return false;
+		};
+
+		if (tryFindExact({})) {
+			LogInfo("[FindEntry] FULL MATCH: " + name);
+			return true;
+		}
+
+		if (!StartsWithFolded(name, "assets\\") && !StartsWithFolded(name, "common\\")) {
+			if (tryFindExact("assets\\")) {
+				LogInfo("[FindEntry] FIXED (assets\\ prefix): assets\\" + name);
+				return true;
+			}
+		}
+
+		if (!ContainsFolded(name, "common\\")) {
+			if (tryFindExact("common\\")) {
+				LogInfo("[FindEntry] FIXED (common\\ prefix): common\\" + name);
+				return true;
+			}
+		}
+
+		if (g_FuzzyResolve) {
+			PakIndex::Near near = ownIndex ? ownIndex->FindNearest(name) : PakIndex::Near{};
+			if (near.index >= 0) {
+				owner = const_cast<PakArchive*>(this);
+				index = near.index;
+			}
+
+			int score = near.score;
+			GlobalIndex::Hit hit = GlobalIndex::ResolveNearest(name, score);
+			if (hit.archive) {
+				owner = hit.archive;
+				index = hit.index;
+			}
+
+			if (near.index >= 0 || hit.archive) {
+				LogInfo("[FindEntry] FUZZY: " + name + " -> " + owner->flatEntries[index]->name);
+				return true;
+			}
+		}
+
+		LogInfo("[FindEntry] NOT FOUND: " + name);
+		return false;
+	}
+
+	int FindIndexWithPrefix(std::string_view prefix, std::string_view name) const {
+		auto index = m_index.load();
+		return index ? index->FindPath(name, prefix) : -1;
+	}
+
+	static bool StartsWithFolded(std::string_view s, std::string_view foldedPrefix) {
+		if (s.size() < foldedPrefix.size()) return false;
+		for (size_t i = 0; i < foldedPrefix.size(); ++i) {
+			if (PakIndex::FoldChar((unsigned char)s[i]) != (unsigned char)foldedPrefix[i]) return false;
+		}
+		return true;
+	}
+
+	static bool ContainsFolded(std::string_view s, std::string_view foldedNeedle) {
+		for (size_t i = 0; i + foldedNeedle.size() <= s.size(); ++i) {
+			if (StartsWithFolded(s.substr(i), foldedNeedle)) return true;
+		}
+		return false;
+	}
+
+	// A cancelled token stops the read and the inflate within one slice by
+	// throwing CancellationToken::OperationCancelled.
+	std::vector<uint8_t> DecompressEntryData(const PakEntry* entry, const CancellationToken& cancel = CancellationToken()) {
+		if (!entry || entry->isDirectory) {
+			throw std::runtime_error("Invalid or directory entry for decompression.");
+		}
+		cancel.throw_if_cancelled();
+
+		if (entry->size == 0) {
+			return {};
+		}
+
+		uint64_t endPos = static_cast<uint64_t>(entry->offset) + entry->size;
+		if (endPos > static_cast<uint64_t>(actualFileSize)) {
+			LogError("[DecompressEntryData] Entry data goes beyond archive bounds: " + entry->name);
+			throw std::runtime_error("Entry data out of bounds.");
+		}
+
+		if (entry->size > 1024 * 1024 * 1024) {
+			LogError("[DecompressEntryData] Compressed entry too large (over 1GB): " + entry->name);
+			throw std::runtime_error("Compressed entry too large");
+		}
+
+		// Read in slices so a read limit is charged, and waited for, before
+		// each one; the handle is never held while waiting.
+		std::vector<uint8_t> rawBuffer(entry->size);
+		const uint32_t READ_SLICE = 8 * 1024 * 1024;
+		for (uint32_t pos = 0; pos < entry->size; pos += READ_SLICE) {
+			DWORD step = std::min(READ_SLICE, entry->size - pos);
+			if (!g_ReadLimiter.Acquire(step, 1, cancel)) cancel.throw_if_cancelled();
+
+			// Only the seek + read pair shares the handle; inflation runs unlocked.
+			std::lock_guard<std::mutex> readLock(m_FileMutex);
+
+			LARGE_INTEGER li;
+			li.QuadPart = (LONGLONG)entry->offset + pos;
+			if (!SetFilePointerEx(hFile, li, NULL, FILE_BEGIN)) {
+				throw std::runtime_error("Failed to seek to entry: " + entry->name);
+			}
+
+			DWORD read = 0;
+			if (!ReadFile(hFile, rawBuffer.data() + pos, step, &read, NULL) || read != step) {
+				LogError("[DecompressEntryData] Read failed for " + entry->name);
+				throw std::runtime_error("Read failed.");
+			}
+		}
+
+		if (entry->compression == PakEntry::CompressionType::Zlib) {
+			if (entry->originalSize == 0) {
+				LogError("[DecompressEntryData] originalSize is 0 for compressed entry: " + entry->name);
+				throw std::runtime_error("Invalid original size");
+			}
+
+			double ratio = (entry->size > 0) ? (static_cast<double>(entry->originalSize) / entry->size) : 0;
+
+			if (entry->originalSize > 1024 * 1024 * 1024 || ratio > 1000.0) {
+				LogError("[DecompressEntryData] Compression bomb detected (Ratio: " + std::to_string(ratio) + "): " + entry->name);
+				throw std::runtime_error("Uncompressed size too large or suspicious ratio");
+			}
+
+			std::vector<uint8_t> processedContent(entry->originalSize);
+			z_stream zs = {};
+			if (inflateInit(&zs) != Z_OK) throw std::runtime_error("Zlib init failed.");
+			zs.next_in = reinterpret_cast<Bytef*>(rawBuffer.data());
+			zs.avail_in = entry->size;
+			zs.next_out = reinterpret_cast<Bytef*>(processedContent.data());
+
+			const size_t SLICE = 1024 * 1024;
+			int zResult = Z_OK;
+			while (zResult == Z_OK) {
+				if (cancel.cancelled()) {
+					inflateEnd(&zs);
+					cancel.throw_if_cancelled();
+				}
+				zs.avail_out = (uInt)std::min<size_t>(SLICE, entry->originalSize - zs.total_out);
+				zResult = inflate(&zs, Z_NO_FLUSH);
+			}
+			uLong destLen = zs.total_out;
+			inflateEnd(&zs);
+
+			if (zResult != Z_STREAM_END || destLen != entry->originalSize) {
+				LogError("[DecompressEntryData] Zlib error code: " + std::to_string(zResult) + " for " + entry->name);
+				throw std::runtime_error("Zlib decompression failed.");
+			}
+			return processedContent;
+		}
+
+		return rawBuffer;
+	}
+
+	// Up to `limit` bytes from the start of the inflated entry, reading only
+	// as much of the stored data as that takes (a few KB for zlib entries).
+	// Empty if the entry cannot be read.
+	std::vector<uint8_t> ReadEntryHead(const PakEntry* entry, size_t limit, const CancellationToken& cancel = CancellationToken()) {
+		if (!entry || entry->isDirectory || entry->size == 0) return {};
+		if ((uint64_t)entry->offset + entry->size > (uint64_t)actualFileSize) return {};
+
+		bool zlib = entry->compression == PakEntry::CompressionType::Zlib;
+		DWORD want = (DWORD)std::min<uint64_t>(entry->size, zlib ? std::max<size_t>(limit * 8, 4096) : limit);
+		std::vector<uint8_t> raw(want);
+		if (!g_ReadLimiter.Acquire(want, 1, cancel)) return {};
+		{
+			std::lock_guard<std::mutex> readLock(m_FileMutex);
+			LARGE_INTEGER li;
+			li.QuadPart = (LONGLONG)entry->offset;
+			DWORD read = 0;
+			if (!SetFilePointerEx(hFile, li, NULL, FILE_BEGIN) || !ReadFile(hFile, raw.data(), want, &read, NULL) || read != want) return {};
+		}
+		if (!zlib) return raw;
+
+		std::vector<uint8_t> head(std::min<size_t>(limit, entry->originalSize));
+		z_stream zs = {};
+		if (inflateInit(&zs) != Z_OK) return {};
+		zs.next_in = raw.data();
+		zs.avail_in = want;
+		zs.next_out = head.data();
+		zs.avail_out = (uInt)head.size();
+		int zResult = inflate(&zs, Z_SYNC_FLUSH);
+		head.resize(zs.total_out);
+		inflateEnd(&zs);
+		if (zResult != Z_OK && zResult != Z_STREAM_END && zResult != Z_BUF_ERROR) return {};
+		return head;
+	}
+
+	// registerGlobally = false opens the archive privately (catalog scans and
+	// lazily opened catalog archives): no index and no g_OpenedArchives entry.
+	PakArchive(const std::string& filename, bool registerGlobally = true) : filename(filename), m_Registered(registerGlobally) {
+		try {
+			hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (hFile == INVALID_HANDLE_VALUE) {
+				LogError("Failed to open PAK file (WinAPI): " + filename);
+				throw std::runtime_error("Failed to open PAK file");
+			}
+
+			std::lock_guard<std::mutex> lock(m_FileMutex);
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(hFile, &fileSize)) throw std::runtime_error("Failed to get file size");
+			actualFileSize = fileSize.QuadPart;
+
+			char formSig[4];
+			if (!InternalRead(formSig, 4) || memcmp(formSig, "FORM", 4) != 0) {
+				LogError("PAK file does not start with 'FORM' signature: " + filename);
+				throw std::runtime_error("Invalid PAK signature.");
+			}
+
+			uint32_t formSize = ReadU32BE();
+			uint64_t expectedTotalSize = 8 + (uint64_t)formSize;
+			if (actualFileSize != static_cast<long long>(expectedTotalSize)) {
+				LogError("Archive header size mismatch. Expected: " + std::to_string(expectedTotalSize));
+				throw std::runtime_error("Archive size mismatch.");
+			}
+
+			char pac1Sig[4];
+			if (!InternalRead(pac1Sig, 4) || memcmp(pac1Sig, "PAC1", 4) != 0) {
+				LogError("PAK file FORM chunk type is not 'PAC1'.");
+				throw std::runtime_error("Invalid PAK type.");
+			}
+
+			root = std::make_shared<PakEntry>();
+			root->name = "";
+			root->isDirectory = true;
+
+			while (true) {
+				LARGE_INTEGER cur; cur.QuadPart = 0;
+				SetFilePointerEx(hFile, cur, &cur, FILE_CURRENT);
+				if ((long long)cur.QuadPart >= actualFileSize) break;
+
+				IffChunk chunk;
+				if (!ReadNextChunk(chunk)) break;
+
+				if (strncmp(chunk.id, "HEAD", 4) == 0) ProcessHeadChunk(chunk);
+				else if (strncmp(chunk.id, "FILE", 4) == 0) ProcessFileChunk(chunk);
+				else if (strncmp(chunk.id, "DATA", 4) == 0) {
+					LARGE_INTEGER li; li.QuadPart = chunk.dataEnd;
+					SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
+				}
+				else {
+					LogInfo("Skipping unknown chunk: " + std::string(chunk.id, 4));
+					LARGE_INTEGER li; li.QuadPart = chunk.dataEnd;
+					SetFilePointerEx(hFile, li, NULL, FILE_BEGIN);
+				}
+			}
+			if (root) FlattenEntries(root);
+
+			if (m_Registered) {
+				BuildIndex();
+
+				std::lock_guard<std::mutex> lock(g_ArchivesMutex);
+				g_OpenedArchives.push_back(this);
+			}
+
+			ResetIndex();
+
+			initialized = true;
+			if (m_Registered) GlobalIndex::OnArchiveOpened(this);
+		} catch (const std::exception& ex) {
+			LogError("PakArchive construction EXCEPTION: " + std::string(ex.what()));
+			initialized = false;
+		}
+	}
+
+	~PakArchive() {
+		// Unlisted first: GuidIndex::Prepare only builds for listed archives,
+		// and OnArchiveClosed waits for a build that is already running.
+		{
+			std::lock_guard<std::mutex> lock(g_ArchivesMutex);
+			auto it = std::find(g_OpenedArchives.begin(), g_OpenedArchives.end(), this);
+			if (it != g_OpenedArchives.end()) g_OpenedArchives.erase(it);
+		}
+
+		if (initialized && m_Registered) GlobalIndex::OnArchiveClosed(this);
+		GuidIndex::OnArchiveClosed(this);
+		ResolveMemo::Invalidate();
+
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+	}
+
+	// Every later read fails as if the entry were unreadable; for archives
+	// whose file was rewritten while they were open.
+	void CloseFile() {
+		std::lock_guard<std::mutex> lock(m_FileMutex);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+		hFile = INVALID_HANDLE_VALUE;
+	}
+
+	bool IsInitialized() const { return initialized; }
+	int GetEntryCount() const { return static_cast<int>(flatEntries.size()); }
+
+	std::vector<int> AllEntries() const {
+		std::vector<int> all(flatEntries.size());
+		for (size_t i = 0; i < all.size(); ++i) all[i] = (int)i;
+		return all;
+	}
+
+	const PakEntry* GetEntry(int index) const {
+		if (index < 0 || index >= static_cast<int>(flatEntries.size())) return nullptr;
+		return flatEntries[index].get();
+	}
+
+	int GetAndIncrementIndex() {
+		return m_CurrentIndex.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	int GetLastProcessedIndex() {
+		return m_CurrentIndex.load(std::memory_order_relaxed) - 1;
+	}
+
+	void SetLastIndex(int idx) {
+		m_LastIndex.store(idx, std::memory_order_relaxed);
+	}
+
+	int GetLastIndex() const {
+		return m_LastIndex.load(std::memory_order_relaxed);
+	}
+
+	void ResetIndex() {
+		std::lock_guard<std::mutex> lock(indexMutex);
+		m_CurrentIndex.store(0, std::memory_order_relaxed);
+		m_LastIndex.store(-1, std::memory_order_relaxed);
+	}
+
+	// ConversionSnapshot hivatkozások eltávolítva
+
+	// Type of an entry as known so far; never reads anything. Archives
+	// without an index classify by extension on the fly.
+	ContentType GetEntryType(int index) const {
+		auto types = m_Types.load();
+		if (types && index >= 0 && index < (int)types->size()) return (*types)[index];
+		const PakEntry* entry = GetEntry(index);
+		return entry && !entry->isDirectory ? ContentClassifier::FromExtension(entry->name) : ContentType::Unknown;
+	}
+
+	// Sniffs the entries still Unknown, once per index, on the I/O pool:
+	// a partial read and inflate of their first bytes, so even a large
+	// archive is classified in a fraction of one full search. False if
+	// cancelled; the column is then left as it was.
+	bool SniffEntryTypes(const CancellationToken& cancel = CancellationToken()) {
+		std::lock_guard<std::mutex> lock(m_SniffMutex);
+		if (m_TypesSniffed) return true;
+
+		auto types = std::make_shared<std::vector<ContentType>>(flatEntries.size());
+		for (int i = 0; i < (int)types->size(); ++i) (*types)[i] = GetEntryType(i);
+
+		std::vector<int> unknown;
+		for (int i = 0; i < (int)types->size(); ++i) {
+			const PakEntry* entry = GetEntry(i);
+			if ((*types)[i] == ContentType::Unknown && !entry->isDirectory && entry->size > 0 && entry->name != "pak_plugin.ini") unknown.push_back(i);
+		}
+
+		const size_t CHUNK = 64;
+		auto sniffChunk = [&](size_t chunk) {
+			for (size_t k = chunk * CHUNK; k < std::min(unknown.size(), (chunk + 1) * CHUNK); ++k) {
+				if (cancel.cancelled()) return;
+				std::vector<uint8_t> head = ReadEntryHead(GetEntry(unknown[k]), ContentClassifier::SNIFF_BYTES, cancel);
+				(*types)[unknown[k]] = ContentClassifier::Sniff(head.data(), head.size());
+			}
+		};
+		size_t chunks = (unknown.size() + CHUNK - 1) / CHUNK;
+		ThreadPool* pool = g_IoPool ? g_IoPool.get() : g_ThreadPool.get();
+		if (pool) pool->parallel_for_isolated(chunks, sniffChunk);
+		else for (size_t c = 0; c < chunks; ++c) sniffChunk(c);
+		if (cancel.cancelled()) return false;
+
+		size_t counts[(size_t)ContentType::Count] = {};
+		for (ContentType type : *types) counts[(size_t)type]++;
+		std::string summary;
+		for (size_t t = 0; t < (size_t)ContentType::Count; ++t) {
+			summary += std::string(summary.empty() ? "" : ", ") + ContentClassifier::Name((ContentType)t) + " " + std::to_string(counts[t]);
+		}
+		LogInfo("[ContentType] " + filename + ": sniffed " + std::to_string(unknown.size()) + " entries; " + summary);
+
+		m_Types.store(std::move(types));
+		m_TypesSniffed = true;
+		return true;
+	}
+
+	// The given entries (ascending) whose type is in `types`, a mask of
+	// ContentClassifier::Bit; 0 or ALL keeps them all without sniffing.
+	std::vector<int> FilterByType(const std::vector<int>& entries, uint32_t types, const CancellationToken& cancel = CancellationToken()) {
+		if ((types & ContentClassifier::ALL) == 0 || (types & ContentClassifier::ALL) == ContentClassifier::ALL) return entries;
+		SniffEntryTypes(cancel);
+		std::vector<int> kept;
+		for (int i : entries) {
+			if (types & ContentClassifier::Bit(GetEntryType(i))) kept.push_back(i);
+		}
+		return kept;
+	}
+
+	// Indices of the entries whose inflated data contains the pattern, in
+	// ascending order. Entries are inflated and matched in parallel, in
+	// chunks of 64, and dropped again right after matching.
+	std::vector<int> SearchContent(const ContentMatcher& matcher, const CancellationToken& cancel = CancellationToken()) {
+		return SearchContent(matcher, AllEntries(), cancel);
+	}
+
+	// Same, limited to the given entries (ascending), e.g. the candidates of a ContentIndex.
+	std::vector<int> SearchContent(const ContentMatcher& matcher, const std::vector<int>& entries, const CancellationToken& cancel = CancellationToken()) {
+		const size_t CHUNK = 64;
+		std::vector<uint8_t> hits(entries.size(), 0);
+		auto scanChunk = [&](size_t chunk) {
+			for (size_t i = chunk * CHUNK; i < std::min(entries.size(), (chunk + 1) * CHUNK); ++i) {
+				const PakEntry* entry = GetEntry(entries[i]);
+				if (cancel.cancelled()) return;
+				if (!entry || entry->isDirectory || entry->size == 0 || entry->name == "pak_plugin.ini") continue;
+				try {
+					std::vector<uint8_t> data = DecompressEntryData(entry, cancel);
+					hits[i] = matcher.Contains(data.data(), data.size());
+				}
+				catch (...) {}
+			}
+		};
+
+		size_t chunks = (entries.size() + CHUNK - 1) / CHUNK;
+		// Isolated: TC's Find text calls this holding m_SearchMutex.
+		if (g_ThreadPool) g_ThreadPool->parallel_for_isolated(chunks, scanChunk);
+		else for (size_t c = 0; c < chunks; ++c) scanChunk(c);
+
+		std::vector<int> result;
+		for (size_t i = 0; i < hits.size(); ++i) {
+			if (hits[i]) result.push_back(entries[i]);
+		}
+		return result;
+	}
+
+	// Full scan, or with `indexed` only the candidates the archive's
+	// ContentIndex gives for the pattern, plus the entries it does not
+	// cover. Either way only entries whose type is in `types` (0 = any) are
+	// inflated.
+	std::vector<int> SearchContent(const ContentMatcher& matcher, const std::wstring& pattern, bool indexed, uint32_t types = 0) {
+		std::vector<int> candidates;
+		if (!indexed || !ContentIndex::Candidates(this, pattern, candidates)) candidates = AllEntries();
+		return SearchContent(matcher, FilterByType(candidates, types));
+	}
+
+	// Every match of a PatternSet, per entry (ascending), in one scan of each
+	// inflated entry. With `indexed` only entries the ContentIndex finds a
+	// prefilter string of some pattern in, or does not cover, are inflated,
+	// and only those whose type is in `types` (0 = any).
+	std::vector<std::pair<int, std::vector<PatternSet::Match>>> SearchPatterns(const PatternSet& set, bool indexed, uint32_t types = 0,
+																			  const CancellationToken& cancel = CancellationToken()) {
+		std::vector<int> entries;
+		bool narrowed = indexed;
+		for (const std::string& factor : set.Prefilter()) {
+			std::vector<int> candidates;
+			if (!narrowed || !ContentIndex::Candidates(this, UTF8ToWString(factor), candidates, cancel)) {
+				narrowed = false;
+				break;
+			}
+			entries.insert(entries.end(), candidates.begin(), candidates.end());
+		}
+		if (narrowed) {
+			std::sort(entries.begin(), entries.end());
+			entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+		} else {
+			entries = AllEntries();
+		}
+		entries = FilterByType(entries, types, cancel);
+
+		const size_t CHUNK = 64;
+		std::vector<std::vector<PatternSet::Match>> found(entries.size());
+		auto scanChunk = [&](size_t chunk) {
+			for (size_t i = chunk * CHUNK; i < std::min(entries.size(), (chunk + 1) * CHUNK); ++i) {
+				const PakEntry* entry = GetEntry(entries[i]);
+				if (cancel.cancelled()) return;
+				if (!entry || entry->isDirectory || entry->size == 0 || entry->name == "pak_plugin.ini") continue;
+				try {
+					std::vector<uint8_t> data = DecompressEntryData(entry, cancel);
+					set.Scan(data.data(), data.size(), found[i]);
+				}
+				catch (...) {}
+			}
+		};
+
+		size_t chunks = (entries.size() + CHUNK - 1) / CHUNK;
+		if (g_ThreadPool) g_ThreadPool->parallel_for(chunks, scanChunk);
+		else for (size_t c = 0; c < chunks; ++c) scanChunk(c);
+
+		std::vector<std::pair<int, std::vector<PatternSet::Match>>> result;
+		for (size_t i = 0; i < found.size(); ++i) {
+			if (!found[i].empty()) result.emplace_back(entries[i], std::move(found[i]));
+		}
+		return result;
+	}
+
+	// Answers TC's per-entry content search: the first entry asked about a
+	// new pattern searches the whole archive, the rest are lookups.
+	bool MatchesSearchText(int index, const std::wstring& pattern) {
+		std::lock_guard<std::mutex> lock(m_SearchMutex);
+		if (pattern != m_SearchPattern) {
+			ContentMatcher matcher(pattern, false);
+			m_SearchHits.assign(flatEntries.size(), false);
+			uint32_t types = ContentClassifier::ParseMask(g_SearchTypes);
+			for (int i : SearchContent(matcher, pattern, g_UseContentIndex, types)) m_SearchHits[i] = true;
+			m_SearchPattern = pattern;
+			LogInfo("[Search] " + filename + ": " + std::to_string(std::count(m_SearchHits.begin(), m_SearchHits.end(), true)) + " entries match");
+		}
+		return index >= 0 && index < (int)m_SearchHits.size() && m_SearchHits[index];
+	}
+
+	void SetProcessDataProc(tProcessDataProc p) { m_pProcessDataProc = p; }
+	tProcessDataProc GetProcessDataProc() const { return m_pProcessDataProc; }
+
+static fs::path BuildFinalPath(const std::string& base, const std::string& entryName) {
+		fs::path basePath = base.empty()
+			? fs::current_path()
+			: fs::absolute(fs::path(base));
+
+		if (basePath.has_filename() && basePath.extension() != "") {
+			basePath = basePath.parent_path();
+		}
+
+		std::string safePath = g_KeepDirectoryStructure
+			? entryName
+			: fs::path(entryName).filename().string();
+
+		size_t drivePos = safePath.find(':');
+		if (drivePos != std::string::npos) {
+			safePath = safePath.substr(drivePos + 1);
+		}
+
+		while (!safePath.empty() && (safePath[0] == '\\' || safePath[0] == '/')) {
+			safePath.erase(0, 1);
+		}
+
+		std::replace(safePath.begin(), safePath.end(), '/', '\\');
+
+		fs::path finalPath = basePath / fs::path(safePath);
+
+		return fs::absolute(finalPath).lexically_normal();
+	}
+
+	// ============================
+	// 🔹 PathToLog
+	// ============================
+	static inline std::string PathToLog(const fs::path& p) {
+		auto u8 = p.u8string();
+		return std::string(reinterpret_cast<const char*>(u8.data()), u8.size());
+	}
+
+	// ============================
+	// 🔹 Decompress
+	// ============================
+	static bool DecompressEntryFast(PakArchive* arc, const PakEntry* entry, std::vector<uint8_t>& out, const CancellationToken& cancel) {
+		out = arc->DecompressEntryData(entry, cancel);
+
+		if (out.empty() && entry->originalSize > 0) {
+			LogError("[ExtractFile] Decompression failed: " + entry->name);
+			return false;
+		}
+		return true;
+	}
+
+	// ============================
+	// 🔹 Path resolve
+	// ============================
+	static fs::path ResolveTargetPath(const std::string& destPath, const PakEntry* entry, bool& isDirectFileTarget) {
+		fs::path input(destPath);
+		isDirectFileTarget = input.has_filename() && !input.extension().empty();
+
+		if (isDirectFileTarget) {
+			LogInfo("[ExtractFile][DEBUG] Direct Target: " + PathToLog(input));
+			return input;
+		}
+
+		fs::path result = PakArchive::BuildFinalPath(destPath, entry->name);
+		LogInfo("[ExtractFile][DEBUG] Directory Target: " + PathToLog(result));
+		return result;
+	}
+
+	// ============================
+	// 🔹 Ensure dir (FAST PATH)
+	// ============================
+	static inline bool EnsureDirFast(const fs::path& path) {
+		auto dir = path.parent_path();
+		if (dir.empty()) return true;
+
+		std::error_code ec;
+		if (!fs::exists(dir) && !fs::create_directories(dir, ec) && ec) {
+			LogError("[ExtractFile] Dir create failed: " + PathToLog(dir));
+			return false;
+		}
+		return true;
+	}
+
+	// ============================
+	// 🔹 Write RAW (BUFFERED LARGE WRITE + SEQ FLAG)
+	// ============================
+	// Written in slices; a cancelled token stops the loop and removes the partial file.
+	static bool WriteRawFast(const fs::path& path, const uint8_t* data, size_t size, const CancellationToken& cancel) {
+		HANDLE hFile = CreateFileW(
+			path.wstring().c_str(),
+			GENERIC_WRITE,
+			FILE_SHARE_READ,
+			NULL,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			NULL
+		);
+
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+
+		const size_t SLICE = 8 * 1024 * 1024;
+		bool ok = true;
+		for (size_t pos = 0; ok && pos < size; pos += SLICE) {
+			DWORD step = (DWORD)std::min(SLICE, size - pos);
+			if (!g_WriteLimiter.Acquire(step, 1, cancel)) {
+				CloseHandle(hFile);
+				DeleteFileW(path.wstring().c_str());
+				return false;
+			}
+			DWORD written = 0;
+			ok = WriteFile(hFile, data + pos, step, &written, NULL) && written == step;
+		}
+
+		CloseHandle(hFile);
+		return ok;
+	}
+
+	// ============================
+	// 🔹 Callback
+	// ============================
+	static bool ReportProgressFast(PakArchive* arc, const PakEntry* entry) {
+		auto cb = arc->GetProcessDataProc();
+		if (!cb) return true;
+
+		const size_t CHUNK = 16384;
+		size_t total = 0;
+
+		if (entry->originalSize == 0) {
+			std::lock_guard<std::mutex> lock(g_CallbackMutex);
+			cb(const_cast<char*>(entry->name.c_str()), 0);
+			return true;
+		}
+
+		while (total < entry->originalSize) {
+			size_t step = std::min(CHUNK, (size_t)entry->originalSize - total);
+
+			int res = 0;
+			{
+				std::lock_guard<std::mutex> lock(g_CallbackMutex);
+				res = cb(const_cast<char*>(entry->name.c_str()), (int)step);
+			}
+
+			if (res == 0) return false;
+			total += step;
+		}
+
+		return true;
+	}
+
+	// ============================
+	// 🔥 ExtractFile
+	// ============================
+	// When the caller already holds the inflated bytes (SmartExtractor scans
+	// them for dependencies) they are written as-is instead of inflated again.
+	// A user abort in the progress callback cancels the token, which stops
+	// every other entry of the same operation.
+	bool ExtractFile(int index, const std::string& destPath, const std::vector<uint8_t>* preloaded = nullptr,
+					 const CancellationToken& cancel = CancellationToken()) {
+		const PakEntry* entry = GetEntry(index);
+
+		if (!entry || entry->isDirectory) {
+			LogError("[ExtractFile] Invalid entry: " + std::to_string(index));
+			return false;
+		}
+
+		try {
+			// 1️⃣ Path resolve & Early check
+			bool isDirect = false;
+			fs::path finalPath = ResolveTargetPath(destPath, entry, isDirect);
+
+			if (!EnsureDirFast(finalPath)) return false;
+
+			// 2️⃣ Decompress
+			std::vector<uint8_t> inflated;
+			if (!preloaded && !DecompressEntryFast(this, entry, inflated, cancel)) return false;
+			const std::vector<uint8_t>& data = preloaded ? *preloaded : inflated;
+
+			// 3️⃣ Write RAW (Minden konverziós logika eltávolítva)
+			LogInfo("[ExtractFile][DEBUG] Writing RAW: " + PathToLog(finalPath));
+			bool ok = WriteRawFast(finalPath, data.data(), data.size(), cancel);
+
+			if (!ok) {
+				if (cancel.cancelled()) {
+					LogInfo("[ExtractFile] Cancelled: " + entry->name);
+					return false;
+				}
+				LogError("[ExtractFile] Write failed: " + PathToLog(finalPath));
+				return false;
+			}
+
+			// 4️⃣ Progress report
+			if (!ReportProgressFast(this, entry)) {
+				LogInfo("[ExtractFile] Aborted by user");
+				cancel.cancel();
+				return false;
+			}
+
+			return true;
+		}
+		catch (const CancellationToken::OperationCancelled&) {
+			LogInfo("[ExtractFile] Cancelled: " + entry->name);
+			return false;
+		}
+		catch (const std::exception& ex) {
+			LogError("[ExtractFile] EXCEPTION: " + std::string(ex.what()));
+			return false;
+		}
+		catch (...) {
+			LogError("[ExtractFile] Unknown EXCEPTION");
+			return false;
+		}
+	}
+};
+
+// ============================================================================
+// 🌐 GLOBAL INDEX
+// ============================================================================
+std::mutex GlobalIndex::s_WriterMutex;
+std::atomic<std::shared_ptr<const GlobalIndex::Snapshot>> GlobalIndex::s_Current;
+uint64_t GlobalIndex::s_NextOrder = 0;
+
+GlobalIndex::Layer GlobalIndex::ClassifyArchive(const std::string& filename) {
+	std::string norm = filename;
+	std::replace(norm.begin(), norm.end(), '/', '\\');
+	std::transform(norm.begin(), norm.end(), norm.begin(), ::tolower);
+
+	if (norm.find("\\arma reforger\\addons\\") != std::string::npos) return Layer::Game;
+	if (norm.find("\\addons\\") != std::string::npos) return Layer::Addon;
+	return Layer::Loose;
+}
+
+bool GlobalIndex::Outranks(const Source& a, const Source& b) {
+	if (a.layer != b.layer) return a.layer > b.layer;
+	return a.order > b.order;
+}
+
+void GlobalIndex::Reserve(Snapshot& snap, size_t count) {
+	size_t cap = snap.slots.empty() ? 1024 : snap.slots.size();
+	while (cap < count * 2 + 1) cap <<= 1;
+	if (cap == snap.slots.size()) return;
+
+	std::vector<Slot> old;
+	old.swap(snap.slots);
+	snap.slots.assign(cap, Slot{ 0, EMPTY, EMPTY });
+	snap.mask = (uint32_t)(cap - 1);
+
+	for (const Slot& s : old) {
+		if (s.entry == EMPTY) continue;
+		uint64_t h = snap.sources[s.source].index->PathHashAt(s.entry);
+		for (uint32_t i = (uint32_t)h & snap.mask;; i = (i + 1) & snap.mask) {
+			if (snap.slots[i].entry == EMPTY) { snap.slots[i] = s; break; }
+		}
+	}
+}
+
+void GlobalIndex::Insert(Snapshot& snap, uint64_t hash, uint32_t entry, uint32_t source) {
+	std::string_view path = snap.sources[source].index->PathAt(entry);
+
+	for (uint32_t i = (uint32_t)hash & snap.mask;; i = (i + 1) & snap.mask) {
+		Slot& s = snap.slots[i];
+		if (s.entry == EMPTY) {
+			s = { (uint32_t)hash, entry, source };
+			snap.count++;
+			return;
+		}
+		if (s.hash == (uint32_t)hash && snap.sources[s.source].index->PathAt(s.entry) == path) {
+			if (Outranks(snap.sources[source], snap.sources[s.source])) {
+				s.entry = entry;
+				s.source = source;
+			}
+			return;
+		}
+	}
+}
+
+void GlobalIndex::RebuildFilter(Snapshot& snap) {
+	snap.filter.Reset(snap.count);
+	for (const Slot& s : snap.slots) {
+		if (s.entry != EMPTY) snap.filter.Add(snap.sources[s.source].index->PathHashAt(s.entry));
+	}
+}
+
+uint64_t GlobalIndex::RemoveSource(Snapshot& snap, PakArchive* arc) {
+	auto it = std::find_if(snap.sources.begin(), snap.sources.end(), [arc](const Source& src) { return src.archive == arc; });
+	if (it == snap.sources.end()) return s_NextOrder++;
+
+	uint32_t removed = (uint32_t)(it - snap.sources.begin());
+	Source gone = *it;
+	snap.sources.erase(it);
+
+	// Keep every surviving slot (only the source ids shift) and remember the
+	// paths the closed archive was providing; those fall back to the best
+	// remaining archive that also has them.
+	std::vector<uint32_t> orphans;
+	std::vector<Slot> old;
+	old.swap(snap.slots);
+	snap.slots.assign(old.size(), Slot{ 0, EMPTY, EMPTY });
+	snap.count = 0;
+
+	for (const Slot& s : old) {
+		if (s.entry == EMPTY) continue;
+		if (s.source == removed) {
+			orphans.push_back(s.entry);
+			continue;
+		}
+		Slot moved = s;
+		if (moved.source > removed) moved.source--;
+		uint64_t h = snap.sources[moved.source].index->PathHashAt(moved.entry);
+		for (uint32_t i = (uint32_t)h & snap.mask;; i = (i + 1) & snap.mask) {
+			if (snap.slots[i].entry == EMPTY) { snap.slots[i] = moved; snap.count++; break; }
+		}
+	}
+
+	for (uint32_t entry : orphans) {
+		std::string_view path = gone.index->PathAt(entry);
+		uint64_t h = gone.index->PathHashAt(entry);
+		for (uint32_t src = 0; src < (uint32_t)snap.sources.size(); ++src) {
+			int idx = snap.sources[src].index->FindPath(path);
+			if (idx >= 0) Insert(snap, h, (uint32_t)idx, src);
+		}
+	}
+
+	return gone.order;
+}
+
+void GlobalIndex::OnArchiveOpened(PakArchive* arc) {
+	auto index = arc->GetIndex();
+	if (!index) return;
+
+	std::lock_guard<std::mutex> lock(s_WriterMutex);
+	auto current = s_Current.load();
+	auto next = current ? std::make_shared<Snapshot>(*current) : std::make_shared<Snapshot>();
+
+	// A re-indexed archive keeps its position in the load order.
+	uint64_t order = RemoveSource(*next, arc);
+
+	size_t added = 0;
+	index->ForEachPath([&](uint32_t, uint64_t) { added++; });
+	next->sources.push_back({ arc, index, ClassifyArchive(arc->GetFilename()), order });
+	Reserve(*next, next->count + added);
+
+	uint32_t source = (uint32_t)next->sources.size() - 1;
+	index->ForEachPath([&](uint32_t id, uint64_t h) { Insert(*next, h, id, source); });
+	RebuildFilter(*next);
+
+	s_Current.store(std::move(next));
+	LogInfo("[GlobalIndex] Added " + arc->GetFilename() + " (layer " + std::to_string((int)ClassifyArchive(arc->GetFilename())) + ")");
+}
+
+void GlobalIndex::OnArchiveClosed(PakArchive* arc) {
+	std::lock_guard<std::mutex> lock(s_WriterMutex);
+	auto current = s_Current.load();
+	if (!current) return;
+
+	auto next = std::make_shared<Snapshot>(*current);
+	RemoveSource(*next, arc);
+	RebuildFilter(*next);
+
+	if (next->sources.empty()) s_Current.store(nullptr);
+	else s_Current.store(std::move(next));
+	LogInfo("[GlobalIndex] Removed " + arc->GetFilename());
+}
+
+GlobalIndex::Hit GlobalIndex::Resolve(std::string_view path, std::string_view prefix) {
+	auto snap = s_Current.load();
+	if (!snap || snap->slots.empty()) return {};
+
+	uint64_t h = PakIndex::HashFolded(path, PakIndex::HashFolded(prefix));
+	if (!snap->filter.MayContain(h)) {
+		ResolveMemo::CountFiltered();
+		return {};
+	}
+
+	for (uint32_t i = (uint32_t)h & snap->mask;; i = (i + 1) & snap->mask) {
+		const Slot& s = snap->slots[i];
+		if (s.entry == EMPTY) return {};
+		if (s.hash == (uint32_t)h && PakIndex::EqualsFolded(prefix, path, snap->sources[s.source].index->PathAt(s.entry))) {
+			return { snap->sources[s.source].archive, (int)s.entry };
+		}
+	}
+}
+
+// The own index of a requester is searched by the caller; sources are only
+// taken when they beat the score it found.
+GlobalIndex::Hit GlobalIndex::ResolveNearest(std::string_view path, int& bestScore) {
+	auto snap = s_Current.load();
+	if (!snap) return {};
+
+	Hit best;
+	const Source* bestSource = nullptr;
+	for (const Source& src : snap->sources) {
+		PakIndex::Near near = src.index->FindNearest(path);
+		if (near.index < 0) continue;
+		if (near.score < bestScore || (near.score == bestScore && bestSource && Outranks(src, *bestSource))) {
+			bestScore = near.score;
+			bestSource = &src;
+			best = { src.archive, near.index };
+		}
+	}
+	return best;
+}
+
+// ============================================================================
+// 🗂️ GAME CATALOG
+// ============================================================================
+std::mutex GameCatalog::s_WriterMutex;
+std::atomic<std::shared_ptr<const GameCatalog::Mapping>> GameCatalog::s_Current;
+std::atomic<bool> GameCatalog::s_Checked{ false };
+std::mutex GameCatalog::s_OpenMutex;
+std::unordered_map<std::string, GameCatalog::Opened> GameCatalog::s_Opened;
+std::vector<std::shared_future<std::shared_ptr<PakArchive>>> GameCatalog::s_Retired;
+
+// Catalog generation n lives in pak_catalog.<n>.bin; pak_catalog.bin, as
+// written by older versions, is generation 0. The newest one is current.
+static std::wstring GetCatalogPath(uint64_t generation) {
+	std::string name = std::string(CATALOG_FILE_STEM) + (generation ? "." + std::to_string(generation) : "") + ".bin";
+	return UTF8ToWString(GetPluginPath() + "\\" + name);
+}
+
+// Generations present next to the plugin, ascending.
+static std::vector<uint64_t> GetCatalogGenerations() {
+	std::vector<uint64_t> found;
+	std::string stem = std::string(CATALOG_FILE_STEM) + ".";
+	std::error_code ec;
+	for (fs::directory_iterator it(fs::u8path(GetPluginPath()), ec), end; !ec && it != end; it.increment(ec)) {
+		std::string name = it->path().filename().string();
+		if (name == stem + "bin") {
+			found.push_back(0);
+			continue;
+		}
+		if (name.size() < stem.size() + 5 || name.compare(0, stem.size(), stem) != 0 || name.compare(name.size() - 4, 4, ".bin") != 0) continue;
+		std::string digits = name.substr(stem.size(), name.size() - stem.size() - 4);
+		if (digits.size() <= 18 && digits.find_first_not_of("0123456789") == std::string::npos) found.push_back(std::stoull(digits));
+	}
+	std::sort(found.begin(), found.end());
+	return found;
+}
+
+GameCatalog::Mapping::~Mapping() {
+	if (view) UnmapViewOfFile(view);
+	if (hMap) CloseHandle(hMap);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+	if (superseded && !file.empty()) DeleteFileW(file.c_str());
+}
+
+std::shared_ptr<const GameCatalog::Mapping> GameCatalog::Load(const std::wstring& file) {
+	auto m = std::make_shared<Mapping>();
+	m->hFile = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (m->hFile == INVALID_HANDLE_VALUE) return nullptr;
+	m->file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m->hFile, &size) || size.QuadPart < (LONGLONG)sizeof(FileHeader)) return nullptr;
+
+	m->hMap = CreateFileMappingW(m->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m->hMap) return nullptr;
+	m->view = static_cast<const uint8_t*>(MapViewOfFile(m->hMap, FILE_MAP_READ, 0, 0, 0));
+	if (!m->view) return nullptr;
+
+	m->header = reinterpret_cast<const FileHeader*>(m->view);
+	const FileHeader& h = *m->header;
+	uint64_t expected = sizeof(FileHeader) + (uint64_t)h.archiveCount * sizeof(ArchiveRecord) +
+						(uint64_t)h.entryCount * sizeof(EntryRecord) + (uint64_t)h.slotCount * sizeof(uint32_t) + h.stringsSize;
+
+	if (memcmp(h.magic, "PAKCAT01", 8) != 0 || h.version != VERSION || expected != (uint64_t)size.QuadPart ||
+		(h.slotCount & (h.slotCount - 1)) != 0) {
+		LogInfo("[Catalog] Ignoring stale or invalid catalog file.");
+		return nullptr;
+	}
+
+	const uint8_t* p = m->view + sizeof(FileHeader);
+	m->archives = reinterpret_cast<const ArchiveRecord*>(p);
+	p += (size_t)h.archiveCount * sizeof(ArchiveRecord);
+	m->entries = reinterpret_cast<const EntryRecord*>(p);
+	p += (size_t)h.entryCount * sizeof(EntryRecord);
+	m->slots = reinterpret_cast<const uint32_t*>(p);
+	p += (size_t)h.slotCount * sizeof(uint32_t);
+	m->strings = reinterpret_cast<const char*>(p);
+
+	m->filter.Reset(h.entryCount);
+	for (uint32_t i = 0; i < h.entryCount; ++i) m->filter.Add(m->entries[i].hash);
+	return m;
+}
+
+bool GameCatalog::Write(const std::wstring& file, const std::vector<ScannedArchive>& archives) {
+	FileHeader h = {};
+	memcpy(h.magic, "PAKCAT01", 8);
+	h.version = VERSION;
+	h.archiveCount = (uint32_t)archives.size();
+
+	std::vector<ArchiveRecord> arcRecords;
+	std::vector<EntryRecord> entryRecords;
+	std::string strings;
+
+	for (const auto& a : archives) {
+		ArchiveRecord r = { a.mtime, a.size, (uint32_t)strings.size(), (uint32_t)a.path.size(), (uint32_t)entryRecords.size(), (uint32_t)a.entries.size() };
+		strings += a.path;
+		for (const auto& [path, entryIndex] : a.entries) {
+			entryRecords.push_back({ PakIndex::HashFolded(path), (uint32_t)strings.size(), (uint32_t)path.size(), (uint32_t)arcRecords.size(), entryIndex });
+			strings += path;
+		}
+		arcRecords.push_back(r);
+	}
+	h.entryCount = (uint32_t)entryRecords.size();
+	h.stringsSize = strings.size();
+
+	uint32_t cap = 16;
+	while (cap < h.entryCount * 2 + 1) cap <<= 1;
+	h.slotCount = cap;
+
+	// Same overlay rules as the live GlobalIndex; archives are sorted by path,
+	// so within a layer the later one wins deterministically.
+	std::vector<uint32_t> slots(cap, EMPTY);
+	for (uint32_t id = 0; id < h.entryCount; ++id) {
+		const EntryRecord& e = entryRecords[id];
+		std::string_view path(strings.data() + e.pathOffset, e.pathLength);
+		for (uint32_t i = (uint32_t)e.hash & (cap - 1);; i = (i + 1) & (cap - 1)) {
+			if (slots[i] == EMPTY) { slots[i] = id; break; }
+			const EntryRecord& cur = entryRecords[slots[i]];
+			if (cur.hash == e.hash && std::string_view(strings.data() + cur.pathOffset, cur.pathLength) == path) {
+				if (GlobalIndex::ClassifyArchive(archives[e.archive].path) >= GlobalIndex::ClassifyArchive(archives[cur.archive].path)) slots[i] = id;
+				break;
+			}
+		}
+	}
+
+	std::ofstream out(fs::path(file), std::ios::binary | std::ios::trunc);
+	if (!out) return false;
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(arcRecords.data()), arcRecords.size() * sizeof(ArchiveRecord));
+	out.write(reinterpret_cast<const char*>(entryRecords.data()), entryRecords.size() * sizeof(EntryRecord));
+	out.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint32_t));
+	out.write(strings.data(), strings.size());
+	return out.good();
+}
+
+bool GameCatalog::Refresh(std::shared_ptr<const Mapping> old) {
+	std::vector<ScannedArchive> archives;
+	{
+		std::stringstream ss(g_CatalogDirs);
+		std::string dir;
+		while (std::getline(ss, dir, ';')) {
+			if (dir.empty()) continue;
+			std::error_code ec;
+			for (fs::recursive_directory_iterator it(fs::u8path(dir), fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+				std::string ext = it->path().extension().string();
+				std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+				if (ext != ".pak" || !it->is_regular_file(ec)) continue;
+
+				ScannedArchive a;
+				auto u8 = it->path().u8string();
+				a.path.assign(reinterpret_cast<const char*>(u8.data()), u8.size());
+				a.mtime = (uint64_t)fs::last_write_time(it->path(), ec).time_since_epoch().count();
+				a.size = (uint64_t)it->file_size(ec);
+				archives.push_back(std::move(a));
+			}
+		}
+	}
+	std::sort(archives.begin(), archives.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+
+	// Unchanged archives (same path, size and mtime) are copied from the old
+	// catalog; only new or modified ones are parsed, in parallel.
+	std::unordered_map<std::string_view, uint32_t> previous;
+	if (old) {
+		for (uint32_t i = 0; i < old->header->archiveCount; ++i) {
+			previous[old->String(old->archives[i].pathOffset, old->archives[i].pathLength)] = i;
+		}
+	}
+
+	size_t reused = 0;
+	std::vector<ScannedArchive*> toScan;
+	for (auto& a : archives) {
+		auto it = previous.find(a.path);
+		if (it != previous.end() && old->archives[it->second].mtime == a.mtime && old->archives[it->second].size == a.size) {
+			const ArchiveRecord& r = old->archives[it->second];
+			for (uint32_t e = r.firstEntry; e < r.firstEntry + r.entryCount; ++e) {
+				a.entries.emplace_back(std::string(old->String(old->entries[e].pathOffset, old->entries[e].pathLength)), old->entries[e].entryIndex);
+			}
+			reused++;
+			continue;
+		}
+		toScan.push_back(&a);
+	}
+
+	auto scan = [&toScan](size_t k) {
+		ScannedArchive& a = *toScan[k];
+		PakArchive arc(a.path, false);
+		if (!arc.IsInitialized()) return;
+		for (int i = 0; i < arc.GetEntryCount(); ++i) {
+			const PakEntry* e = arc.GetEntry(i);
+			if (!e || e->isDirectory) continue;
+			std::string folded = e->name;
+			std::transform(folded.begin(), folded.end(), folded.begin(), [](char c) { return (char)PakIndex::FoldChar((unsigned char)c); });
+			a.entries.emplace_back(std::move(folded), (uint32_t)i);
+		}
+	};
+	// Opening an archive is mostly waiting for its header to be read. Runs
+	// under s_WriterMutex, so the scans are isolated from other pool work.
+	if (g_IoPool) g_IoPool->parallel_for_isolated(toScan.size(), scan);
+	else for (size_t k = 0; k < toScan.size(); ++k) scan(k);
+
+	if (old && reused == archives.size() && reused == old->header->archiveCount) {
+		s_Current.store(old);
+		ResolveMemo::Invalidate();
+		return true;
+	}
+
+	// Written to a private temporary file and renamed to the next free
+	// generation; the rename never replaces an existing file, so a
+	// generation another process published meanwhile stays intact.
+	std::wstring tmp = UTF8ToWString(GetPluginPath() + "\\" + CATALOG_FILE_STEM + "." + std::to_string(GetCurrentProcessId()) + ".tmp");
+	if (!Write(tmp, archives)) {
+		LogError("[Catalog] Failed to write catalog file.");
+		DeleteFileW(tmp.c_str());
+		return false;
+	}
+
+	std::vector<uint64_t> generations = GetCatalogGenerations();
+	uint64_t generation = generations.empty() ? 1 : generations.back() + 1;
+	std::wstring file;
+	for (int attempt = 0;; ++attempt, ++generation) {
+		file = GetCatalogPath(generation);
+		if (MoveFileExW(tmp.c_str(), file.c_str(), 0)) break;
+		DWORD error = GetLastError();
+		if (attempt == 16 || (error != ERROR_ALREADY_EXISTS && error != ERROR_FILE_EXISTS)) {
+			LogError("[Catalog] Failed to store catalog file (error " + std::to_string(error) + ").");
+			DeleteFileW(tmp.c_str());
+			return false;
+		}
+	}
+
+	// The previous catalog stays published until the new one is mapped.
+	std::shared_ptr<const Mapping> mapped = Load(file);
+	if (!mapped) {
+		LogError("[Catalog] Failed to map " + WStringToUTF8(file));
+		DeleteFileW(file.c_str());
+		return false;
+	}
+
+	// Older generations go as soon as nothing maps them: the one still in
+	// use here when its last Mapping is released, others (from other
+	// processes or earlier sessions) now, where Windows lets us.
+	if (old) old->superseded = true;
+	for (uint64_t g : generations) {
+		std::wstring older = GetCatalogPath(g);
+		if (!old || older != old->file) DeleteFileW(older.c_str());
+	}
+
+	s_Current.store(mapped);
+	ResolveMemo::Invalidate();
+	LogInfo("[Catalog] " + std::to_string(archives.size()) + " archives (" + std::to_string(reused) + " unchanged), " +
+			std::to_string(mapped->header->entryCount) + " entries, generation " + std::to_string(generation));
+	return true;
+}
+
+// Only one thread refreshes. With `wait` false, a thread arriving while
+// another refreshes keeps using the previous catalog instead of blocking:
+// resolution runs in pool tasks of a dependency walk, which must not wait
+// for each other.
+std::shared_ptr<const GameCatalog::Mapping> GameCatalog::Current(bool wait) {
+	if (!s_Checked.load()) {
+		std::unique_lock<std::mutex> lock(s_WriterMutex, std::defer_lock);
+		if (wait) lock.lock();
+		else lock.try_lock();
+		if (lock && !s_Checked.load()) {
+			std::shared_ptr<const Mapping> old = s_Current.load();
+			bool ok = true;
+			if (g_CatalogDirs.empty()) s_Current.store(nullptr);
+			else {
+				if (!old) {
+					std::vector<uint64_t> generations = GetCatalogGenerations();
+					if (!generations.empty()) old = Load(GetCatalogPath(generations.back()));
+				}
+				ok = Refresh(old);
+				if (!ok && old && !s_Current.load()) s_Current.store(old);
+			}
+			// A failed refresh is tried again on the next call; the last
+			// good catalog stays in use meanwhile.
+			s_Checked = ok;
+		}
+	}
+	return s_Current.load();
+}
+
+void GameCatalog::Prepare() {
+	Current(true);
+}
+
+bool GameCatalog::Stat(const std::string& path, uint64_t& size, uint64_t& mtime) {
+	std::error_code ec;
+	fs::path p = fs::u8path(path);
+	size = (uint64_t)fs::file_size(p, ec);
+	if (ec) return false;
+	mtime = (uint64_t)fs::last_write_time(p, ec).time_since_epoch().count();
+	return !ec;
+}
+
+// Called with s_OpenMutex held. A plan in flight may still point at the
+// archive, so it is only closed: its reads fail from now on instead of
+// returning data from a rewritten file. The object goes at Shutdown.
+void GameCatalog::Retire(const Opened& opened) {
+	s_Retired.push_back(opened.archive);
+	if (opened.archive.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+	if (PakArchive* arc = opened.archive.get().get()) {
+		arc->CloseFile();
+		LogInfo("[Catalog] Closed changed archive: " + arc->GetFilename());
+	}
+}
+
+// The archive is opened and indexed outside s_OpenMutex: indexing fans out
+// on the pool, and whoever resolves through the catalog may be a pool task
+// itself. Threads asking for the same archive meanwhile wait on its slot;
+// the index build runs only its own chunks (parallel_for_isolated), so that
+// wait always ends. A slot is only reused for the size and mtime it was
+// opened at, and dropped again if the open failed.
+PakArchive* GameCatalog::OpenLazily(const std::string& path, uint64_t size, uint64_t mtime) {
+	std::promise<std::shared_ptr<PakArchive>> promise;
+	std::shared_future<std::shared_ptr<PakArchive>> slot;
+	bool owner = false;
+	{
+		std::lock_guard<std::mutex> lock(s_OpenMutex);
+		auto it = s_Opened.find(path);
+		if (it != s_Opened.end() && it->second.size == size && it->second.mtime == mtime) {
+			slot = it->second.archive;
+		} else {
+			if (it != s_Opened.end()) Retire(it->second);
+			slot = promise.get_future().share();
+			s_Opened[path] = { size, mtime, slot };
+			owner = true;
+		}
+	}
+	if (!owner) return slot.get().get();
+
+	std::shared_ptr<PakArchive> arc;
+	try {
+		arc = std::make_shared<PakArchive>(path, false);
+		if (arc->IsInitialized()) {
+			arc->BuildIndex();
+			LogInfo("[Catalog] Opened archive on demand: " + path);
+		} else {
+			arc.reset();
+		}
+	}
+	catch (...) {
+		arc.reset();
+	}
+	promise.set_value(arc);
+
+	if (!arc) {
+		std::lock_guard<std::mutex> lock(s_OpenMutex);
+		auto it = s_Opened.find(path);
+		if (it != s_Opened.end() && it->second.archive.wait_for(std::chrono::seconds(0)) == std::future_status::ready &&
+			!it->second.archive.get()) {
+			s_Opened.erase(it);
+		}
+	}
+	return arc.get();
+}
+
+GameCatalog::Hit GameCatalog::Resolve(std::string_view path, std::string_view prefix) {
+	auto m = Current(false);
+	if (!m || m->header->slotCount == 0) return {};
+
+	uint64_t h = PakIndex::HashFolded(path, PakIndex::HashFolded(prefix));
+	if (!m->filter.MayContain(h)) {
+		ResolveMemo::CountFiltered();
+		return {};
+	}
+
+	uint32_t mask = m->header->slotCount - 1;
+	for (uint32_t i = (uint32_t)h & mask;; i = (i + 1) & mask) {
+		uint32_t id = m->slots[i];
+		if (id == EMPTY) return {};
+
+		const EntryRecord& e = m->entries[id];
+		std::string_view stored = m->String(e.pathOffset, e.pathLength);
+		if (e.hash != h || !PakIndex::EqualsFolded(prefix, path, stored)) continue;
+
+		const ArchiveRecord& a = m->archives[e.archive];
+		PakArchive* arc = OpenLazily(std::string(m->String(a.pathOffset, a.pathLength)), a.size, a.mtime);
+		if (!arc) return {};
+
+		// Guard against an archive that changed after the catalog was written.
+		int idx = (int)e.entryIndex;
+		const PakEntry* entry = arc->GetEntry(idx);
+		if (!entry || !PakIndex::EqualsFolded({}, entry->name, stored)) idx = arc->FindIndexByName(std::string(stored));
+		if (idx < 0) return {};
+
+		return { arc, idx };
+	}
+}
+
+// Archives whose file changed since they were opened are retired, so
+// nothing keeps reading a rewritten PAK through its old entry table.
+void GameCatalog::Invalidate() {
+	s_Checked = false;
+	{
+		std::lock_guard<std::mutex> lock(s_OpenMutex);
+		for (auto it = s_Opened.begin(); it != s_Opened.end();) {
+			uint64_t size = 0, mtime = 0;
+			bool opening = it->second.archive.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+			if (opening || (Stat(it->first, size, mtime) && size == it->second.size && mtime == it->second.mtime)) {
+				++it;
+				continue;
+			}
+			Retire(it->second);
+			it = s_Opened.erase(it);
+		}
+	}
+	ResolveMemo::Invalidate();
+}
+
+void GameCatalog::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(s_OpenMutex);
+		s_Opened.clear();
+		s_Retired.clear();
+	}
+	s_Current.store(nullptr);
+	ResolveMemo::Invalidate();
+}
+
+// ============================================================================
+// 🧠 RESOLVE MEMO
+// ============================================================================
+ResolveMemo::Shard ResolveMemo::s_Shards[ResolveMemo::SHARD_COUNT];
+std::atomic<uint64_t> ResolveMemo::s_Generation{ 0 };
+std::atomic<uint64_t> ResolveMemo::s_Hits{ 0 };
+std::atomic<uint64_t> ResolveMemo::s_Negative{ 0 };
+std::atomic<uint64_t> ResolveMemo::s_Misses{ 0 };
+std::atomic<uint64_t> ResolveMemo::s_Filtered{ 0 };
+
+std::string ResolveMemo::MakeKey(const PakArchive* requester, std::string_view path) {
+	std::string key(sizeof(requester) + path.size(), '\0');
+	memcpy(key.data(), &requester, sizeof(requester));
+	for (size_t i = 0; i < path.size(); ++i) key[sizeof(requester) + i] = (char)PakIndex::FoldChar((unsigned char)path[i]);
+	return key;
+}
+
+bool ResolveMemo::Lookup(const PakArchive* requester, std::string_view path, Result& out) {
+	std::string key = MakeKey(requester, path);
+	Shard& shard = s_Shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+	uint64_t generation = Generation();
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end() || it->second.generation != generation) {
+		s_Misses++;
+		return false;
+	}
+
+	out = it->second.result;
+	if (out.archive) s_Hits++;
+	else s_Negative++;
+	return true;
+}
+
+void ResolveMemo::Store(const PakArchive* requester, std::string_view path, uint64_t generation, const Result& result) {
+	// Resolved against a set of archives that has changed since; don't keep it.
+	if (generation != Generation()) return;
+
+	std::string key = MakeKey(requester, path);
+	Shard& shard = s_Shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	if (shard.entries.size() >= MAX_SHARD_ENTRIES) shard.entries.clear();
+	shard.entries[std::move(key)] = { result, generation };
+}
+
+void ResolveMemo::LogStats() {
+	LogInfo("[ResolveMemo] " + std::to_string(s_Hits.load()) + " cached hits, " + std::to_string(s_Negative.load()) +
+			" cached misses, " + std::to_string(s_Misses.load()) + " full lookups, " + std::to_string(s_Filtered.load()) +
+			" probes skipped by Bloom filters");
+}
+
+// ============================================================================
+// 🔗 DEPENDENCY CACHE
+// ============================================================================
+std::mutex DependencyCache::s_Mutex;
+std::unordered_map<std::string, std::unique_ptr<DependencyCache::ArchiveCache>> DependencyCache::s_Caches;
+
+std::string DependencyCache::Fingerprint(const std::string& archivePath) {
+	std::error_code ec;
+	uint64_t size = (uint64_t)fs::file_size(fs::path(archivePath), ec);
+	uint64_t mtime = (uint64_t)fs::last_write_time(fs::path(archivePath), ec).time_since_epoch().count();
+
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%016llx_%llx_%llx", (unsigned long long)PakIndex::HashFolded(archivePath),
+			 (unsigned long long)size, (unsigned long long)mtime);
+	return buf;
+}
+
+DependencyCache::ArchiveCache& DependencyCache::For(PakArchive* arc) {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	auto& slot = s_Caches[arc->GetFilename()];
+	if (!slot) {
+		slot = std::make_unique<ArchiveCache>();
+		slot->file = GetPluginPath() + "\\" + DEPENDENCY_CACHE_DIR + "\\" + Fingerprint(arc->GetFilename()) + ".bin";
+	}
+	return *slot;
+}
+
+void DependencyCache::Load(ArchiveCache& cache) {
+	cache.loaded = true;
+
+	std::ifstream in(fs::path(UTF8ToWString(cache.file)), std::ios::binary);
+	if (!in) return;
+	std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	size_t pos = 0;
+	auto read = [&](void* dst, size_t n) {
+		if (buf.size() - pos < n) return false;
+		memcpy(dst, buf.data() + pos, n);
+		pos += n;
+		return true;
+	};
+
+	char magic[8];
+	uint32_t version = 0, count = 0;
+	if (!read(magic, 8) || memcmp(magic, "PAKDEP01", 8) != 0 || !read(&version, 4) || version != VERSION || !read(&count, 4)) return;
+
+	for (uint32_t r = 0; r < count; ++r) {
+		uint32_t index = 0, depCount = 0;
+		if (!read(&index, 4) || !read(&depCount, 4)) break;
+
+		std::vector<std::string> deps;
+		for (uint32_t d = 0; d < depCount; ++d) {
+			uint16_t len = 0;
+			if (!read(&len, 2) || buf.size() - pos < len) return;
+			deps.emplace_back(buf.data() + pos, len);
+			pos += len;
+		}
+		cache.deps[index] = std::move(deps);
+	}
+	LogInfo("[DepCache] Loaded " + std::to_string(cache.deps.size()) + " entries from " + cache.file);
+}
+
+bool DependencyCache::Save(ArchiveCache& cache) {
+	std::string buf("PAKDEP01", 8);
+	auto put = [&buf](const void* src, size_t n) { buf.append(static_cast<const char*>(src), n); };
+
+	uint32_t version = VERSION, count = (uint32_t)cache.deps.size();
+	put(&version, 4);
+	put(&count, 4);
+	for (const auto& [index, deps] : cache.deps) {
+		uint32_t depCount = (uint32_t)deps.size();
+		put(&index, 4);
+		put(&depCount, 4);
+		for (const auto& d : deps) {
+			uint16_t len = (uint16_t)std::min<size_t>(d.size(), 0xFFFF);
+			put(&len, 2);
+			put(d.data(), len);
+		}
+	}
+
+	std::wstring file = UTF8ToWString(cache.file);
+	std::wstring tmp = file + L".tmp";
+	std::error_code ec;
+	fs::create_directories(fs::path(file).parent_path(), ec);
+	{
+		std::ofstream out(fs::path(tmp), std::ios::binary | std::ios::trunc);
+		if (!out || !out.write(buf.data(), buf.size())) return false;
+	}
+	if (!MoveFileExW(tmp.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileW(tmp.c_str());
+		return false;
+	}
+	cache.dirty = false;
+	return true;
+}
+
+bool DependencyCache::Lookup(PakArchive* arc, int index, std::vector<std::string>& deps) {
+	ArchiveCache& cache = For(arc);
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (!cache.loaded) Load(cache);
+
+	auto it = cache.deps.find((uint32_t)index);
+	if (it == cache.deps.end()) return false;
+	deps = it->second;
+	return true;
+}
+
+void DependencyCache::Store(PakArchive* arc, int index, const std::vector<std::string>& deps) {
+	ArchiveCache& cache = For(arc);
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (!cache.loaded) Load(cache);
+
+	cache.deps[(uint32_t)index] = deps;
+	cache.dirty = true;
+}
+
+void DependencyCache::Flush() {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	for (auto& [path, cache] : s_Caches) {
+		std::lock_guard<std::mutex> cacheLock(cache->mutex);
+		if (cache->dirty && !Save(*cache)) LogError("[DepCache] Failed to write " + cache->file);
+	}
+}
+
+// Runs under the loader lock, so nothing is written here; every smart
+// extraction flushes its own results.
+void DependencyCache::Shutdown() {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Caches.clear();
+}
+
+// ============================================================================
+// 🔤 CONTENT INDEX
+// ============================================================================
+std::mutex ContentIndex::s_Mutex;
+std::mutex ContentIndex::s_BuildMutex;
+std::unordered_map<std::string, std::shared_ptr<const ContentIndex::Table>> ContentIndex::s_Tables;
+
+// Trigrams fold ASCII letters the way ContentMatcher does, so one index
+// serves case-sensitive and case-insensitive searches alike.
+static inline uint32_t NextTrigram(uint32_t trigram, uint8_t c) {
+	if (c >= 'A' && c <= 'Z') c |= 0x20;
+	return ((trigram << 8) | c) & 0xFFFFFF;
+}
+
+static void PutVarint(std::string& out, uint32_t value) {
+	while (value >= 0x80) {
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+// UTF-16LE text (BOM already skipped) as UTF-8, so it yields the same
+// trigrams as the UTF-8 form of a search pattern.
+static std::string Utf16LeToUtf8(const uint8_t* data, size_t size) {
+	std::string out;
+	out.reserve(size / 2);
+	for (size_t i = 0; i + 1 < size; i += 2) {
+		uint32_t c = data[i] | (data[i + 1] << 8);
+		if (c >= 0xD800 && c < 0xDC00 && i + 3 < size) {
+			uint32_t low = data[i + 2] | (data[i + 3] << 8);
+			if (low >= 0xDC00 && low < 0xE000) {
+				c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+				i += 2;
+			}
+		}
+		if (c < 0x80) {
+			out.push_back((char)c);
+		} else if (c < 0x800) {
+			out.push_back((char)(0xC0 | (c >> 6)));
+			out.push_back((char)(0x80 | (c & 0x3F)));
+		} else if (c < 0x10000) {
+			out.push_back((char)(0xE0 | (c >> 12)));
+			out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+			out.push_back((char)(0x80 | (c & 0x3F)));
+		} else {
+			out.push_back((char)(0xF0 | (c >> 18)));
+			out.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+			out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+			out.push_back((char)(0x80 | (c & 0x3F)));
+		}
+	}
+	return out;
+}
+
+std::shared_ptr<const ContentIndex::Table> ContentIndex::Build(PakArchive* arc, const CancellationToken& cancel) {
+	auto t0 = std::chrono::steady_clock::now();
+	auto table = std::make_shared<Table>();
+	table->entryCount = (uint32_t)arc->GetEntryCount();
+
+	// Only text and scripts are inflated, plus what could not be sniffed;
+	// those are still dropped below if they turn out to contain NUL bytes.
+	std::vector<uint32_t> todo;
+	uint32_t types = ContentClassifier::TEXTUAL | ContentClassifier::Bit(ContentType::Unknown);
+	for (int i : arc->FilterByType(arc->AllEntries(), types, cancel)) {
+		const PakEntry* entry = arc->GetEntry(i);
+		if (entry->isDirectory || entry->size == 0 || entry->name == "pak_plugin.ini") continue;
+		todo.push_back((uint32_t)i);
+	}
+
+	// Postings grow in entry order: batches are merged one after the other,
+	// and the chunks of a batch in order, each sorted by (trigram, entry).
+	struct Posting {
+		std::string deltas;
+		uint32_t last = 0;
+	};
+	std::unordered_map<uint32_t, Posting> postings;
+
+	const size_t CHUNK = 64;
+	const size_t BATCH = CHUNK * 2 * std::max<size_t>(1, g_ThreadPool ? g_ThreadPool->size() : 1);
+	for (size_t first = 0; first < todo.size() && !cancel.cancelled(); first += BATCH) {
+		size_t count = std::min(BATCH, todo.size() - first);
+		size_t chunks = (count + CHUNK - 1) / CHUNK;
+		std::vector<std::vector<uint64_t>> keys(chunks);
+		std::vector<uint64_t> textBytes(count, UINT64_MAX);
+
+		auto indexChunk = [&](size_t c) {
+			// One bit per trigram, cleared again through `found` after each entry.
+			static thread_local std::vector<uint64_t> seen(1 << 18);
+			std::vector<uint32_t> found;
+			for (size_t k = c * CHUNK; k < std::min(count, (c + 1) * CHUNK); ++k) {
+				if (cancel.cancelled()) return;
+				uint32_t index = todo[first + k];
+				std::vector<uint8_t> data;
+				try {
+					data = arc->DecompressEntryData(arc->GetEntry(index), cancel);
+				}
+				catch (...) { continue; }
+
+				std::string utf8;
+				const uint8_t* p = data.data();
+				size_t n = data.size();
+				if (n >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+					utf8 = Utf16LeToUtf8(p + 2, n - 2);
+					p = reinterpret_cast<const uint8_t*>(utf8.data());
+					n = utf8.size();
+				} else if (memchr(p, 0, n)) {
+					continue;
+				}
+
+				found.clear();
+				uint32_t trigram = 0;
+				for (size_t i = 0; i < n; ++i) {
+					trigram = NextTrigram(trigram, p[i]);
+					if (i < 2) continue;
+					uint64_t& word = seen[trigram >> 6];
+					uint64_t bit = 1ull << (trigram & 63);
+					if (!(word & bit)) {
+						word |= bit;
+						found.push_back(trigram);
+					}
+				}
+				for (uint32_t t : found) {
+					seen[t >> 6] = 0;
+					keys[c].push_back(((uint64_t)t << 32) | index);
+				}
+				textBytes[k] = n;
+			}
+			std::sort(keys[c].begin(), keys[c].end());
+		};
+
+		if (g_ThreadPool) g_ThreadPool->parallel_for_isolated(chunks, indexChunk);
+		else for (size_t c = 0; c < chunks; ++c) indexChunk(c);
+
+		for (auto& chunk : keys) {
+			Posting* posting = nullptr;
+			uint32_t current = 0;
+			for (uint64_t key : chunk) {
+				uint32_t trigram = (uint32_t)(key >> 32), index = (uint32_t)key;
+				if (!posting || trigram != current) {
+					posting = &postings[trigram];
+					current = trigram;
+				}
+				PutVarint(posting->deltas, index + 1 - posting->last);
+				posting->last = index + 1;
+			}
+		}
+		for (size_t k = 0; k < count; ++k) {
+			if (textBytes[k] == UINT64_MAX) continue;
+			table->covered.push_back(todo[first + k]);
+			table->corpusBytes += textBytes[k];
+		}
+	}
+	if (cancel.cancelled()) return nullptr;
+
+	table->trigrams.reserve(postings.size());
+	for (const auto& [trigram, posting] : postings) table->trigrams.push_back(trigram);
+	std::sort(table->trigrams.begin(), table->trigrams.end());
+	table->offsets.reserve(table->trigrams.size() + 1);
+	for (uint32_t trigram : table->trigrams) {
+		table->offsets.push_back((uint32_t)table->postings.size());
+		table->postings += postings[trigram].deltas;
+	}
+	table->offsets.push_back((uint32_t)table->postings.size());
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[ContentIndex] " + arc->GetFilename() + ": indexed " + std::to_string(table->covered.size()) + " of " +
+			std::to_string(table->entryCount) + " entries, " + std::to_string(table->corpusBytes / 1024) + " KB of text, " +
+			std::to_string(table->trigrams.size()) + " trigrams, " + std::to_string(table->postings.size() / 1024) +
+			" KB of postings in " + std::to_string(ms) + " ms");
+	return table;
+}
+
+std::shared_ptr<const ContentIndex::Table> ContentIndex::Load(const std::string& file, uint32_t entryCount) {
+	std::ifstream in(fs::path(UTF8ToWString(file)), std::ios::binary);
+	if (!in) return nullptr;
+	std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	size_t pos = 0;
+	auto read = [&](void* dst, size_t n) {
+		if (buf.size() - pos < n) return false;
+		memcpy(dst, buf.data() + pos, n);
+		pos += n;
+		return true;
+	};
+	auto readArray = [&](std::vector<uint32_t>& dst, uint32_t count) {
+		if ((buf.size() - pos) / 4 < count) return false;
+		dst.resize(count);
+		return read(dst.data(), (size_t)count * 4);
+	};
+
+	auto table = std::make_shared<Table>();
+	char magic[8];
+	uint32_t version = 0, coveredCount = 0, trigramCount = 0;
+	if (!read(magic, 8) || memcmp(magic, "PAKTRI01", 8) != 0 || !read(&version, 4) || version != VERSION ||
+		!read(&table->entryCount, 4) || table->entryCount != entryCount || !read(&table->corpusBytes, 8) ||
+		!read(&coveredCount, 4) || !readArray(table->covered, coveredCount) ||
+		!read(&trigramCount, 4) || !readArray(table->trigrams, trigramCount) || !readArray(table->offsets, trigramCount + 1) ||
+		table->offsets.back() != buf.size() - pos) {
+		return nullptr;
+	}
+	table->postings.assign(buf.data() + pos, buf.size() - pos);
+
+	LogInfo("[ContentIndex] Loaded " + std::to_string(trigramCount) + " trigrams over " + std::to_string(coveredCount) +
+			" entries from " + file);
+	return table;
+}
+
+bool ContentIndex::Save(const Table& table, const std::string& file) {
+	std::string buf("PAKTRI01", 8);
+	auto put = [&buf](const void* src, size_t n) { buf.append(static_cast<const char*>(src), n); };
+
+	uint32_t version = VERSION, coveredCount = (uint32_t)table.covered.size(), trigramCount = (uint32_t)table.trigrams.size();
+	put(&version, 4);
+	put(&table.entryCount, 4);
+	put(&table.corpusBytes, 8);
+	put(&coveredCount, 4);
+	put(table.covered.data(), table.covered.size() * 4);
+	put(&trigramCount, 4);
+	put(table.trigrams.data(), table.trigrams.size() * 4);
+	put(table.offsets.data(), table.offsets.size() * 4);
+	buf += table.postings;
+
+	std::wstring path = UTF8ToWString(file);
+	std::wstring tmp = path + L".tmp";
+	std::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+	{
+		std::ofstream out(fs::path(tmp), std::ios::binary | std::ios::trunc);
+		if (!out || !out.write(buf.data(), buf.size())) return false;
+	}
+	if (!MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileW(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+size_t ContentIndex::Find(const Table& table, uint32_t trigram) {
+	auto it = std::lower_bound(table.trigrams.begin(), table.trigrams.end(), trigram);
+	if (it == table.trigrams.end() || *it != trigram) return SIZE_MAX;
+	return (size_t)(it - table.trigrams.begin());
+}
+
+std::vector<uint32_t> ContentIndex::Postings(const Table& table, size_t slot) {
+	std::vector<uint32_t> entries;
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(table.postings.data()) + table.offsets[slot];
+	const uint8_t* end = reinterpret_cast<const uint8_t*>(table.postings.data()) + table.offsets[slot + 1];
+	uint32_t current = 0;
+	while (p < end) {
+		uint32_t delta = 0;
+		for (int shift = 0; p < end; shift += 7) {
+			uint8_t b = *p++;
+			delta |= (uint32_t)(b & 0x7F) << shift;
+			if (!(b & 0x80)) break;
+		}
+		current += delta;
+		entries.push_back(current - 1);
+	}
+	return entries;
+}
+
+bool ContentIndex::Candidates(PakArchive* arc, std::wstring_view pattern, std::vector<int>& entries, const CancellationToken& cancel) {
+	std::string file = GetPluginPath() + "\\" + CONTENT_INDEX_DIR + "\\" + DependencyCache::Fingerprint(arc->GetFilename()) + ".bin";
+	auto lookup = [&file] {
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		auto it = s_Tables.find(file);
+		return it != s_Tables.end() ? it->second : nullptr;
+	};
+
+	std::shared_ptr<const Table> table = lookup();
+	if (!table) {
+		std::lock_guard<std::mutex> building(s_BuildMutex);
+		table = lookup();
+		if (!table) table = Load(file, (uint32_t)arc->GetEntryCount());
+		if (!table) {
+			table = Build(arc, cancel);
+			if (!table) return false;
+			if (!Save(*table, file)) LogError("[ContentIndex] Failed to write " + file);
+		}
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Tables[file] = table;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::string needle = WStringToUTF8(std::wstring(pattern));
+	std::vector<uint32_t> trigrams;
+	uint32_t trigram = 0;
+	for (size_t i = 0; i < needle.size(); ++i) {
+		trigram = NextTrigram(trigram, (uint8_t)needle[i]);
+		if (i >= 2) trigrams.push_back(trigram);
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+	std::vector<uint32_t> result;
+	if (trigrams.empty()) {
+		// Too short to narrow anything down: every covered entry is a candidate.
+		result = table->covered;
+	} else {
+		// Shortest lists first, so the intersection shrinks as early as possible.
+		std::vector<std::pair<uint32_t, size_t>> lists;
+		for (uint32_t t : trigrams) {
+			size_t slot = Find(*table, t);
+			if (slot == SIZE_MAX) {
+				lists.clear();
+				break;
+			}
+			lists.push_back({ table->offsets[slot + 1] - table->offsets[slot], slot });
+		}
+		std::sort(lists.begin(), lists.end());
+
+		std::vector<uint32_t> next;
+		if (!lists.empty()) result = Postings(*table, lists[0].second);
+		for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+			std::vector<uint32_t> list = Postings(*table, lists[i].second);
+			next.resize(std::min(result.size(), list.size()));
+			next.erase(std::set_intersection(result.begin(), result.end(), list.begin(), list.end(), next.begin()), next.end());
+			result.swap(next);
+		}
+	}
+
+	// The index only rules out entries it covers; the others (binary or
+	// UTF-16 text, entries that could not be sniffed) stay candidates and
+	// are left to the caller's type filter.
+	std::vector<uint8_t> keep(table->entryCount, 1);
+	for (uint32_t i : table->covered) keep[i] = 0;
+	for (uint32_t i : result) keep[i] = 1;
+	entries.clear();
+	for (uint32_t i = 0; i < table->entryCount; ++i) {
+		if (keep[i]) entries.push_back((int)i);
+	}
+
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[ContentIndex] " + std::to_string(result.size()) + " of " + std::to_string(table->covered.size()) +
+			" indexed entries are candidates, plus " + std::to_string(entries.size() - result.size()) + " not indexed (" +
+			std::to_string(trigrams.size()) + " trigrams, " + std::to_string(us) + " us)");
+	return true;
+}
+
+void ContentIndex::Shutdown() {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Tables.clear();
+}
+
+// ============================================================================
+// 🆔 GUID INDEX
+// ============================================================================
+std::mutex GuidIndex::s_Mutex;
+std::vector<std::shared_ptr<const GuidIndex::Table>> GuidIndex::s_Tables;
+std::mutex GuidIndex::s_BuildMutex;
+
+size_t GuidIndex::ParseGuid(std::string_view text, uint64_t& guid) {
+	if (text.size() < 18 || text[0] != '{' || text[17] != '}') return 0;
+	guid = 0;
+	for (size_t i = 1; i <= 16; ++i) {
+		char c = text[i];
+		uint64_t v;
+		if (c >= '0' && c <= '9') v = c - '0';
+		else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+		else return 0;
+		guid = (guid << 4) | v;
+	}
+	return 18;
+}
+
+std::shared_ptr<const GuidIndex::Table> GuidIndex::Build(PakArchive* arc) {
+	auto t0 = std::chrono::steady_clock::now();
+	auto table = std::make_shared<Table>();
+	table->archive = arc;
+
+	std::vector<int> metas;
+	for (int i = 0; i < arc->GetEntryCount(); ++i) {
+		const PakEntry* e = arc->GetEntry(i);
+		if (e && !e->isDirectory && e->name.size() > 5 && PakArchive::StartsWithFolded(std::string_view(e->name).substr(e->name.size() - 5), ".meta")) metas.push_back(i);
+	}
+	if (metas.empty()) return table;
+
+	// A .meta names its resource as: Name "{GUID}path". The resource is the
+	// sibling entry without the ".meta" suffix; the stored path is only a fallback.
+	auto parseRange = [arc, &metas](size_t begin, size_t end) {
+		std::vector<std::pair<uint64_t, int>> out;
+		for (size_t k = begin; k < end; ++k) {
+			const PakEntry* meta = arc->GetEntry(metas[k]);
+			std::vector<uint8_t> data;
+			try { data = arc->DecompressEntryData(meta); }
+			catch (...) { continue; }
+
+			std::string_view text(reinterpret_cast<const char*>(data.data()), data.size());
+			size_t name = text.find("Name");
+			size_t brace = name == std::string_view::npos ? name : text.find('{', name);
+			uint64_t guid;
+			size_t len = brace == std::string_view::npos ? 0 : ParseGuid(text.substr(brace), guid);
+			if (!len) continue;
+
+			int idx = arc->FindIndexByName(meta->name.substr(0, meta->name.size() - 5));
+			if (idx < 0) {
+				std::string_view path = text.substr(brace + len);
+				path = path.substr(0, path.find('"'));
+				idx = arc->FindIndexByName(std::string(path));
+			}
+			if (idx >= 0) out.push_back({ guid, idx });
+		}
+		return out;
+	};
+
+	size_t chunks = metas.size() >= 256 && g_ThreadPool ? std::max<size_t>(1, std::thread::hardware_concurrency()) : 1;
+	size_t chunkSize = (metas.size() + chunks - 1) / chunks;
+	std::vector<std::vector<std::pair<uint64_t, int>>> parts(chunks);
+	auto parseChunk = [&](size_t c) {
+		size_t begin = c * chunkSize, end = std::min(metas.size(), begin + chunkSize);
+		if (begin < end) parts[c] = parseRange(begin, end);
+	};
+	// Isolated: runs under s_BuildMutex.
+	if (chunks > 1) g_ThreadPool->parallel_for_isolated(chunks, parseChunk);
+	else parseChunk(0);
+
+	for (const auto& part : parts) {
+		for (const auto& [guid, idx] : part) table->entries.emplace(guid, idx);
+	}
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[GuidIndex] " + arc->GetFilename() + ": " + std::to_string(table->entries.size()) + " GUIDs from " +
+			std::to_string(metas.size()) + " .meta files in " + std::to_string(ms) + " ms");
+	return table;
+}
+
+void GuidIndex::Prepare() {
+	std::vector<PakArchive*> archives;
+	{
+		std::lock_guard<std::mutex> lock(g_ArchivesMutex);
+		archives = g_OpenedArchives;
+	}
+
+	// The copy may go stale: each archive is built under s_BuildMutex, which
+	// OnArchiveClosed also takes, and only while it is still listed. A closing
+	// archive is unlisted before it calls OnArchiveClosed, so it is either
+	// skipped here or stays alive until its table is built and dropped again.
+	for (PakArchive* arc : archives) {
+		std::lock_guard<std::mutex> building(s_BuildMutex);
+		{
+			std::lock_guard<std::mutex> lock(g_ArchivesMutex);
+			if (std::find(g_OpenedArchives.begin(), g_OpenedArchives.end(), arc) == g_OpenedArchives.end()) continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (std::any_of(s_Tables.begin(), s_Tables.end(), [arc](const auto& t) { return t->archive == arc; })) continue;
+		}
+		auto table = Build(arc);
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Tables.push_back(std::move(table));
+	}
+}
+
+bool GuidIndex::Resolve(uint64_t guid, const PakArchive* requester, PakArchive*& owner, int& index) {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	const Table* found = nullptr;
+	int foundIndex = -1;
+
+	// The requesting archive wins; otherwise the most recently indexed one.
+	for (auto it = s_Tables.rbegin(); it != s_Tables.rend(); ++it) {
+		auto hit = (*it)->entries.find(guid);
+		if (hit == (*it)->entries.end()) continue;
+		if (!found || (*it)->archive == requester) {
+			found = it->get();
+			foundIndex = hit->second;
+		}
+		if ((*it)->archive == requester) break;
+	}
+
+	if (!found) return false;
+	owner = found->archive;
+	index = foundIndex;
+	return true;
+}
+
+void GuidIndex::OnArchiveClosed(PakArchive* arc) {
+	std::lock_guard<std::mutex> building(s_BuildMutex);
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Tables.erase(std::remove_if(s_Tables.begin(), s_Tables.end(), [arc](const auto& t) { return t->archive == arc; }), s_Tables.end());
+}
+
+inline std::string ws2s(const std::wstring& wstr)
+{
+	if (wstr.empty()) return std::string();
+	int size_needed = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), NULL, 0, NULL, NULL);
+	std::string strTo(size_needed, 0);
+	WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
+	return strTo;
+}
+
+const std::wstring WORKBENCH_EXE_NAME = L"ArmaReforgerWorkbenchSteamDiag.exe";
+const std::wstring WORKBENCH_FALLBACK_EXE = L"ArmaReforgerWorkbenchSteam.exe";
+
+static std::wstring GetWorkbenchPathFromRegistry() {
+	HKEY hKey;
+	std::wstring exePath = L"";
+	LPCWSTR subkey = L"SOFTWARE\\Bohemia Interactive\\Arma Reforger Tools";
+
+	struct RootKey {
+		HKEY hRoot;
+		const char* name;
+	} roots[] = {
+		{HKEY_LOCAL_MACHINE, "HKLM"},
+		{HKEY_CURRENT_USER,  "HKCU"}
+	};
+
+	LogInfo("[Debug] --- Registry Deep Search Start ---");
+
+	for (auto& root : roots) {
+		LogInfo("[Debug] Checking " + std::string(root.name) + "...");
+
+		DWORD flags[] = { KEY_WOW64_64KEY, KEY_WOW64_32KEY, 0 };
+
+		for (DWORD flag : flags) {
+			if (RegOpenKeyExW(root.hRoot, subkey, 0, KEY_READ | flag, &hKey) == ERROR_SUCCESS) {
+				LogInfo("[Debug] SUCCESS: Key opened in " + std::string(root.name) + " with flags: " + std::to_string(flag));
+
+				wchar_t buffer[MAX_PATH];
+				DWORD bufferSize = sizeof(buffer);
+
+				if (RegQueryValueExW(hKey, L"exe", NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
+					exePath = buffer;
+					LogInfo("[Debug] 'exe' value found: " + ws2s(exePath));
+				} else {
+					bufferSize = sizeof(buffer);
+					if (RegQueryValueExW(hKey, L"path", NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
+						exePath = std::wstring(buffer) + L"\\" + WORKBENCH_EXE_NAME;
+						LogInfo("[Debug] 'path' value found, constructed default exe path.");
+					}
+				}
+
+				RegCloseKey(hKey);
+				if (!exePath.empty()) break;
+			}
+		}
+		if (!exePath.empty()) break;
+	}
+
+	if (exePath.empty()) {
+		LogInfo("[Debug] Still not found, checking HKEY_CLASSES_ROOT\\enfusion...");
+		LPCWSTR uriKey = L"enfusion\\shell\\open\\command";
+		if (RegOpenKeyExW(HKEY_CLASSES_ROOT, uriKey, 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
+			wchar_t buffer[MAX_PATH * 2];
+			DWORD bufferSize = sizeof(buffer);
+			if (RegQueryValueExW(hKey, NULL, NULL, NULL, (LPBYTE)buffer, &bufferSize) == ERROR_SUCCESS) {
+				std::wstring fullCmd = buffer;
+				size_t firstQuote = fullCmd.find(L"\"");
+				size_t secondQuote = fullCmd.find(L"\"", firstQuote + 1);
+				if (firstQuote != std::wstring::npos && secondQuote != std::wstring::npos) {
+					exePath = fullCmd.substr(firstQuote + 1, secondQuote - firstQuote - 1);
+					LogInfo("[Debug] Found path in Enfusion URI handler: " + ws2s(exePath));
+				}
+			}
+			RegCloseKey(hKey);
+		}
+	}
+
+	if (!exePath.empty()) {
+		fs::path p(exePath);
+		std::vector<std::wstring> candidates;
+
+		candidates.push_back(p.wstring());
+
+		if (p.has_parent_path()) {
+			fs::path root = p.parent_path();
+
+			candidates.push_back((root / WORKBENCH_EXE_NAME).wstring());
+			candidates.push_back((root / L"Workbench" / WORKBENCH_EXE_NAME).wstring());
+
+			if (WORKBENCH_EXE_NAME != WORKBENCH_FALLBACK_EXE) {
+				candidates.push_back((root / WORKBENCH_FALLBACK_EXE).wstring());
+				candidates.push_back((root / L"Workbench" / WORKBENCH_FALLBACK_EXE).wstring());
+			}
+		}
+
+		bool found = false;
+		for (const auto& cand : candidates) {
+			if (!cand.empty() && fs::exists(cand) && !fs::is_directory(cand)) {
+				exePath = cand;
+				LogInfo("[Debug] Physical file VERIFIED: " + ws2s(exePath));
+				found = true;
+				break;
+			}
+		}
+
+		if (!found) {
+			LogError("[Debug] Path found in registry, but physical file not found: " + ws2s(exePath));
+			exePath = L"";
+		}
+	}
+
+	if (exePath.empty()) {
+		LogError("[Debug] ALL Registry locations and physical checks failed.");
+	}
+
+	LogInfo("[Debug] --- Registry Deep Search End ---");
+	return exePath;
+}
+
+struct WorkbenchContext {
+	std::string internalPath;
+	fs::path sandboxPath;
+	fs::path targetFilePath;
+	std::string ext;
+	std::string GUID_PROJECT = "A1B2C3D4E5F60789";
+	std::string projectName = "PAKViewer";
+	std::string wbModule = "resourceManager";
+	std::string loadResource;
+};
+
+using ExtensionProcessor = std::function<void(WorkbenchContext&)>;
+std::unordered_map<std::string, ExtensionProcessor> g_ExtensionLogic;
+
+struct ExtensionAutoReg {
+	ExtensionAutoReg() {
+		g_ExtensionLogic[".xob"] = [](WorkbenchContext& ctx) {
+			ctx.projectName = "XOBViewer";
+			ctx.wbModule = "resourceManager";
+
+			std::string GUID_XOB       = "D887766554433221";
+			std::string GUID_ENTITY    = "B9876543210FEDCB";
+			std::string GUID_COMPONENT = "C112233445566778";
+			std::string GUID_PREFAB    = "E554433221100998";
+
+			fs::path prefabDir = ctx.sandboxPath / "Prefabs";
+			fs::create_directories(prefabDir);
+
+			try {
+				std::ofstream xobMeta(ctx.targetFilePath.string() + ".meta");
+				xobMeta << "MetaFileClass {\n Name \"{" << GUID_XOB << "}" << ctx.internalPath
+						<< "\"\n Configurations {\n  StaticModelResourceClass PC {}\n }\n}";
+				xobMeta.close();
+
+				std::ofstream et(prefabDir / "preview.et");
+				et << "GenericEntity {\n ID \"" << GUID_ENTITY << "\"\n components {\n  MeshObject \"" << GUID_COMPONENT << "\" {\n    Object \"{" << GUID_XOB << "}" << ctx.internalPath << "\"\n  }\n }\n}";
+				et.close();
+
+				std::ofstream etMeta(prefabDir / "preview.et.meta");
+				etMeta << "MetaFileClass {\n Name \"{" << GUID_PREFAB << "}Prefabs/preview.et\"\n Configurations {\n  EntityTemplateResourceClass PC {}\n }\n}";
+				etMeta.close();
+
+				ctx.loadResource = "{" + GUID_PREFAB + "}Prefabs/preview.et";
+
+			} catch (...) {
+				LogInfo("[XOB Processor] Critical error while writing files!");
+				ctx.loadResource = "{" + ctx.GUID_PROJECT + "}" + ctx.internalPath;
+			}
+		};
+	}
+};
+
+//static ExtensionAutoReg g_DoReg;
+
+bool IsWorkbenchSupported(const std::string& extension) {
+	if (g_ExtensionLogic.count(extension)) {
+		return true;
+	}
+
+	static const std::unordered_set<std::string> supportedExtensions = {
+ //       ".et", ".ent", ".layer", ".c", ".acp", ".sig", ".afm", ".snd", ".wav",
+ //       ".agf", ".agr", ".anm", ".asi", ".ast", ".aw", ".ae", ".asy", ".txa",
+ //       ".bt", ".ptc", ".layout", ".styles", ".imageset", ".emat", ".gamemat",
+ //       ".physmat", ".edds", ".dds", ".st", ".nmn", ".pap", ".siga", ".conf",
+ //       ".gproj", ".meta", ".pre", ".fnt", ".ttf"
+		  ".xob", ".c"
+	};
+
+	return supportedExtensions.count(extension) > 0;
+}
+
+int CountProcesses(const std::wstring& exeName) {
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (hSnap == INVALID_HANDLE_VALUE) return 0;
+
+	PROCESSENTRY32W pe;
+	pe.dwSize = sizeof(pe);
+	int count = 0;
+
+	if (Process32FirstW(hSnap, &pe)) {
+		do {
+			if (_wcsicmp(pe.szExeFile, exeName.c_str()) == 0) {
+				count++;
+			}
+		} while (Process32NextW(hSnap, &pe));
+	}
+
+	CloseHandle(hSnap);
+	return count;
+}
+
+bool WaitForSteamReady(int maxWaitSeconds) {
+	LogInfo("[Steam] Monitoring WebHelper count for initialization...");
+
+	int stableTicks = 0;
+	int lastCount = 0;
+
+	for (int i = 0; i < maxWaitSeconds; ++i) {
+		int currentCount = CountProcesses(L"steamwebhelper.exe");
+
+		if (currentCount >= 7 && currentCount == lastCount) {
+			stableTicks++;
+		} else {
+			stableTicks = 0;
+		}
+
+		lastCount = currentCount;
+
+		if (stableTicks >= 3) {
+			LogInfo("[Steam] Ready! WebHelper count stable at: " + std::to_string(currentCount));
+			return true;
+		}
+
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		if (i % 5 == 0) LogInfo("[Steam] Waiting... Current WebHelpers: " + std::to_string(currentCount));
+	}
+
+	LogInfo("[Steam] Timeout reached, continuing launch attempt anyway...");
+	return false;
+}
+
+BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
+	DWORD pid;
+	GetWindowThreadProcessId(hwnd, &pid);
+	if (pid == (DWORD)lParam) {
+		PostMessage(hwnd, WM_CLOSE, 0, 0);
+	}
+	return TRUE;
+}
+
+bool IsSteamRunning() {
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (hSnap == INVALID_HANDLE_VALUE) return false;
+	PROCESSENTRY32W pe = { sizeof(pe) };
+	bool running = false;
+	if (Process32FirstW(hSnap, &pe)) {
+		do {
+			if (_wcsicmp(pe.szExeFile, L"steam.exe") == 0) {
+				running = true;
+				break;
+			}
+		} while (Process32NextW(hSnap, &pe));
+	}
+	CloseHandle(hSnap);
+	return running;
+}
+
+bool IsProcessRunning(const std::wstring& exeName) {
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (hSnap == INVALID_HANDLE_VALUE) return false;
+
+	PROCESSENTRY32W pe{ sizeof(pe) };
+	bool running = false;
+
+	for (BOOL ok = Process32FirstW(hSnap, &pe); ok; ok = Process32NextW(hSnap, &pe)) {
+		if (_wcsicmp(pe.szExeFile, exeName.c_str()) == 0) {
+			running = true;
+			break;
+		}
+	}
+
+	CloseHandle(hSnap);
+	return running;
+}
+
+bool IsWorkbenchRunning() {
+	return IsProcessRunning(WORKBENCH_EXE_NAME);
+}
+
+bool LaunchWorkbenchWithRetry(const std::wstring& cmd, const std::wstring& workDir, const fs::path& sandboxPath) {
+	const int maxRetries = 5;
+
+	for (int i = 0; i < maxRetries; ++i) {
+		if (!IsSteamRunning()) {
+			LogInfo("[Workbench] Steam not running, launching...");
+			ShellExecuteW(NULL, L"open", L"steam://open/main", NULL, NULL, SW_SHOWNORMAL);
+			WaitForSteamReady(45);
+		} else {
+			if (CountProcesses(L"steamwebhelper.exe") < 7) {
+				LogInfo("[Workbench] Steam running but WebHelpers starting, waiting...");
+				WaitForSteamReady(10);
+			}
+		}
+
+		LogInfo("[Workbench] Launch attempt #" + std::to_string(i + 1));
+
+		STARTUPINFOW si{ sizeof(si) };
+		si.dwFlags = STARTF_USESHOWWINDOW;
+		si.wShowWindow = SW_SHOWNORMAL;
+
+		PROCESS_INFORMATION pi{};
+		std::vector<wchar_t> buffer(cmd.begin(), cmd.end());
+		buffer.push_back(0);
+
+		if (!CreateProcessW(NULL, buffer.data(), NULL, NULL, FALSE, 0, NULL, workDir.c_str(), &si, &pi)) {
+			LogInfo("[Workbench] CreateProcessW failed: " + std::to_string(GetLastError()));
+			std::this_thread::sleep_for(std::chrono::seconds(3));
+			continue;
+		}
+
+		HANDLE hProcess = pi.hProcess;
+		DWORD pid = pi.dwProcessId;
+		CloseHandle(pi.hThread);
+
+		bool success = false;
+		for (int check = 0; check < 15; ++check) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+			DWORD currentExitCode;
+			if (!GetExitCodeProcess(hProcess, &currentExitCode)) break;
+
+			if (currentExitCode != STILL_ACTIVE) {
+				success = false;
+				break;
+			}
+
+			if (check >= 10) {
+				success = true;
+				break;
+			}
+		}
+
+		if (success) {
+			LogInfo("[Workbench] Process running (PID: " + std::to_string(pid) + ")");
+
+			std::thread([hProcess, sandboxPath, pid]() {
+				WaitForSingleObject(hProcess, INFINITE);
+
+				DWORD finalExit = 0;
+				GetExitCodeProcess(hProcess, &finalExit);
+				CloseHandle(hProcess);
+
+				std::this_thread::sleep_for(std::chrono::seconds(1));
+
+				if (finalExit == 0 && fs::exists(sandboxPath)) {
+					try {
+						fs::remove_all(sandboxPath);
+						LogInfo("[Cleanup] Sandbox deleted after Workbench (PID: " + std::to_string(pid) + ") closed.");
+					} catch (...) {
+						LogInfo("[Cleanup] Failed to delete sandbox (folder may be locked).");
+					}
+				} else if (finalExit == 0) {
+					LogInfo("[Cleanup] Sandbox folder already gone or inaccessible, skipping.");
+				} else {
+					LogInfo("[Cleanup] Process " + std::to_string(pid) + " closed via code or error (Exit: " + std::to_string(finalExit) + "), skipping cleanup.");
+				}
+			}).detach();
+
+			return true;
+		}
+
+		LogInfo("[Workbench] Process exited prematurely.");
+		CloseHandle(hProcess);
+		std::this_thread::sleep_for(std::chrono::seconds(3));
+	}
+
+	return false;
+}
+
+void TerminateWorkbench() {
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (hSnap == INVALID_HANDLE_VALUE) return;
+
+	PROCESSENTRY32W pe;
+	pe.dwSize = sizeof(pe);
+
+	if (Process32FirstW(hSnap, &pe)) {
+		do {
+			std::wstring exeName = pe.szExeFile;
+			if (_wcsicmp(exeName.c_str(), WORKBENCH_EXE_NAME.c_str()) == 0) {
+
+				DWORD pid = pe.th32ProcessID;
+
+				LogInfo("[Workbench] Existing process found (PID: " + std::to_string(pid) + "), sending close message...");
+
+				EnumWindows(EnumWindowsProc, pid);
+
+				HANDLE hProcess = OpenProcess(SYNCHRONIZE | PROCESS_TERMINATE, FALSE, pid);
+
+				if (hProcess) {
+					DWORD wait = WaitForSingleObject(hProcess, 5000);
+
+					if (wait == WAIT_TIMEOUT) {
+						LogInfo("[Workbench] Graceful close timeout, forcing termination (PID: " + std::to_string(pid) + ")");
+						TerminateProcess(hProcess, 0);
+						WaitForSingleObject(hProcess, 2000);
+					} else {
+						LogInfo("[Workbench] Process exited cleanly (PID: " + std::to_string(pid) + ")");
+					}
+
+					CloseHandle(hProcess);
+				} else {
+					LogInfo("[Workbench] Failed to open process handle (PID: " + std::to_string(pid) + ")");
+				}
+			}
+		} while (Process32NextW(hSnap, &pe));
+	}
+
+	CloseHandle(hSnap);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+}
+
+// =====================================================
+// 🔥 WORKBENCH LAUNCH
+// =====================================================
+static bool OpenInWorkbench(const std::string& pakEntryPath, const std::string& extractedRoot) {
+	TerminateWorkbench();
+
+	for (int i = 0; i < 20; ++i) {
+		if (!IsWorkbenchRunning()) break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	LogInfo("[Workbench] Launching via Retry system...");
+
+	std::wstring wbExe = GetWorkbenchPathFromRegistry();
+	if (wbExe.empty()) return false;
+
+	fs::path exePath(wbExe);
+	fs::path binDir = exePath.parent_path();
+
+	fs::path diagPath = binDir / WORKBENCH_EXE_NAME;
+	if (fs::exists(diagPath)) wbExe = diagPath.wstring();
+
+	fs::path toolsDir = binDir.parent_path();
+	fs::path commonDir = toolsDir.parent_path();
+	fs::path gameData = commonDir / L"Arma Reforger" / L"addons" / L"data";
+	fs::path sandboxPath = fs::path(extractedRoot);
+
+	WorkbenchContext ctx;
+	ctx.internalPath = pakEntryPath;
+
+	std::replace(ctx.internalPath.begin(), ctx.internalPath.end(), '\\', '/');
+	if (!ctx.internalPath.empty() && ctx.internalPath[0] == '/') ctx.internalPath.erase(0, 1);
+
+	ctx.sandboxPath = sandboxPath;
+	ctx.targetFilePath = sandboxPath / ctx.internalPath;
+	ctx.ext = ctx.targetFilePath.extension().string();
+	std::transform(ctx.ext.begin(), ctx.ext.end(), ctx.ext.begin(), ::tolower);
+
+	ctx.loadResource = "{" + ctx.GUID_PROJECT + "}" + ctx.internalPath;
+
+	fs::create_directories(ctx.targetFilePath.parent_path());
+
+	// =====================================================
+	// 🛠️ EXTENSION LOGIC
+	// =====================================================
+	if (g_ExtensionLogic.count(ctx.ext)) {
+		g_ExtensionLogic[ctx.ext](ctx);
+	} else {
+		const std::string& ext = ctx.ext;
+		if (ext == ".xob") { ctx.projectName = "XOBViewer"; ctx.wbModule = "resourceManager"; }
+		else if (ext == ".et" || ext == ".ent" || ext == ".layer") { ctx.projectName = "WorldEditor"; ctx.wbModule = "worldEditor"; }
+		else if (ext == ".c") { ctx.projectName = "ScriptEditor"; ctx.wbModule = "resourceManager"; }
+		else if (ext == ".acp" || ext == ".sig" || ext == ".afm" || ext == ".snd" || ext == ".wav") { ctx.projectName = "AudioEditor"; ctx.wbModule = "audioEditor"; }
+		else if (ext == ".agf" || ext == ".agr" || ext == ".anm" || ext == ".asi" || ext == ".ast" || ext == ".aw" || ext == ".ae" || ext == ".asy" || ext == ".txa") { ctx.projectName = "AnimationEditor"; ctx.wbModule = "animEditor"; }
+		else if (ext == ".bt") { ctx.projectName = "BehaviorEditor"; ctx.wbModule = "behaviorEditor"; }
+		else if (ext == ".ptc") { ctx.projectName = "ParticleEditor"; ctx.wbModule = "particleEditor"; }
+		else if (ext == ".layout" || ext == ".styles" || ext == ".imageset") { ctx.projectName = "LayoutEditor"; ctx.wbModule = "resourceManager"; }
+		else if (ext == ".emat" || ext == ".gamemat" || ext == ".physmat") { ctx.projectName = "MaterialEditor"; ctx.wbModule = "resourceManager"; }
+		else if (ext == ".edds" || ext == ".dds") { ctx.projectName = "TextureViewer"; ctx.wbModule = "resourceManager"; }
+		else if (ext == ".st") { ctx.projectName = "LocalizationEditor"; ctx.wbModule = "localizationEditor"; }
+		else if (ext == ".nmn") { ctx.projectName = "NavmeshGenerator"; ctx.wbModule = "navmeshGeneratorMain"; }
+		else if (ext == ".pap" || ext == ".siga") { ctx.projectName = "ProcAnimEditor"; ctx.wbModule = "procAnimEditor"; }
+		else if (ext == ".conf" || ext == ".gproj" || ext == ".meta" || ext == ".pre" || ext == ".fnt" || ext == ".ttf") { ctx.projectName = "ConfigViewer"; ctx.wbModule = "resourceManager"; }
+	}
+
+	// =====================================================
+	// 📂 FILE OPERATIONS
+	// =====================================================
+	try {
+		fs::path sourceInSandbox = sandboxPath / ctx.internalPath;
+		if (fs::exists(sourceInSandbox) && sourceInSandbox != ctx.targetFilePath) {
+			if (fs::exists(ctx.targetFilePath)) fs::remove(ctx.targetFilePath);
+			fs::copy_file(sourceInSandbox, ctx.targetFilePath);
+		}
+	} catch (...) { return false; }
+
+	// =====================================================
+	// 📝 PROJECT GENERATION (Meta & GPROJ)
+	// =====================================================
+	try {
+		std::ofstream meta(ctx.targetFilePath.string() + ".meta");
+		meta << "MetaFileClass {\n Name \"{" << ctx.GUID_PROJECT << "}" << ctx.internalPath << "\"\n}\n";
+		meta.close();
+
+		std::ofstream gproj(sandboxPath / "addon.gproj");
+		gproj << "GameProject {\n"
+			  << " ID \"" << ctx.projectName << "\"\n"
+			  << " GUID \"" << ctx.GUID_PROJECT << "\"\n"
+			  << " TITLE \"" << ctx.projectName << "\"\n"
+			  << " Dependencies {\n"
+			  << "  \"58D0FB3206B6F859\"\n"
+			  << " }\n"
+			  << "}";
+		gproj.close();
+	} catch (...) { return false; }
+
+	// =====================================================
+	// 🚀 COMMAND EXECUTION
+	// =====================================================
+	std::wstring wModule = std::wstring(ctx.wbModule.begin(), ctx.wbModule.end());
+	std::wstring wLoad = std::wstring(ctx.loadResource.begin(), ctx.loadResource.end());
+
+	std::wstring openCmd = L"\"" + wbExe + L"\"" +
+		L" -gproj \"" + (sandboxPath / "addon.gproj").wstring() + L"\"" +
+		L" -addonsDir \"" + sandboxPath.wstring() + L"," + gameData.wstring() + L"\"" +
+		L" -wbModule=" + wModule;
+
+	if (ctx.wbModule == "scriptEditor") {
+		openCmd += L" -noGameScriptsOnInit";
+	}
+
+	openCmd += L" -run -load \"" + wLoad + L"\"";
+
+	LogInfo("[Workbench] Final Launch Command: " + ws2s(openCmd));
+
+	if (!LaunchWorkbenchWithRetry(openCmd, binDir.wstring(), sandboxPath)) {
+		MessageBoxW(NULL,
+			L"Failed to launch Workbench after multiple attempts.\nPlease ensure Steam is running and logged in.",
+			L"Error",
+			MB_OK | MB_ICONERROR);
+		return false;
+	}
+
+	return true;
+}
+
+static PakArchive* GetArchive(HANDLE hArcData) {
+	return reinterpret_cast<PakArchive*>(hArcData);
+}
+
+// Inflation, scanning and index builds run on g_ThreadPool; work that mostly
+// blocks on the disk (writing extracted files, reading archive headers) runs
+// on g_IoPool so it never holds a core the CPU pool could use. Both pools
+// start their threads on first use.
+std::unique_ptr<ThreadPool> g_ThreadPool = nullptr;
+std::unique_ptr<ThreadPool> g_IoPool = nullptr;
+
+static std::string g_LastOpenedArcName = "";
+static std::wstring g_LastTargetDir = L"";
+static bool g_ExtractOptionsShown = false;
+static bool g_SettingsChangedForRefresh = false;
+static std::atomic<bool> g_RequireReload{ false };
+static FILETIME g_OriginalArchiveTime = { 0 };
+static std::string g_OriginalArchivePath = "";
+static std::chrono::steady_clock::time_point g_LastOperationEndTime = std::chrono::steady_clock::now();
+
+// ============================================================================
+// AUTOREFRESH
+// ============================================================================
+static HWND FindTCWindow() {
+	HWND h = FindWindowA("TTOTAL_CMD", NULL);
+	if (!h) h = GetForegroundWindow();
+	return h;
+}
+
+static bool TouchArchiveFile(const std::string& filePath, FILETIME originalTime) {
+	if (filePath.empty()) return false;
+
+	if (originalTime.dwLowDateTime == 0 && originalTime.dwHighDateTime == 0) {
+		GetSystemTimeAsFileTime(&originalTime);
+	}
+
+	for (int attempt = 0; attempt < 5; ++attempt) {
+		HANDLE h = CreateFileA(
+			filePath.c_str(),
+			FILE_WRITE_ATTRIBUTES,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL,
+			OPEN_EXISTING,
+			0,
+			NULL
+		);
+
+		if (h != INVALID_HANDLE_VALUE) {
+			ULARGE_INTEGER uli;
+			uli.LowPart = originalTime.dwLowDateTime;
+			uli.HighPart = originalTime.dwHighDateTime;
+
+			if (uli.QuadPart > 100000000LL) {
+				uli.QuadPart -= 100000000LL;
+			} else {
+				uli.QuadPart = 0;
+			}
+
+			FILETIME ft;
+			ft.dwLowDateTime = uli.LowPart;
+			ft.dwHighDateTime = uli.HighPart;
+
+			bool success = (SetFileTime(h, NULL, NULL, &ft) != 0);
+			if (success) {
+				FlushFileBuffers(h);
+				CloseHandle(h);
+				LogInfo("[Touch] Archive timestamp shifted successfully: " + filePath);
+				return true;
+			}
+
+			DWORD err = GetLastError();
+			CloseHandle(h);
+			LogError("[Touch] SetFileTime failed (attempt " + std::to_string(attempt) + "): " + std::to_string(err));
+		}
+
+		Sleep(100);
+	}
+
+	try {
+		std::filesystem::path p(filePath);
+		if (std::filesystem::exists(p)) {
+			std::filesystem::last_write_time(p, std::filesystem::file_time_type::clock::now());
+			LogInfo("[Touch] Archive timestamp updated via filesystem fallback.");
+			return true;
+		}
+	}
+	catch (const std::exception& e) {
+		LogError(std::string("[Touch] Fallback failed: ") + e.what());
+	}
+
+	return false;
+}
+
+// ============================================================================
+// OPENARCHIVE
+// ============================================================================
+template <typename T>
+static HANDLE OpenArchiveInternal(const std::string& arcName, T* ArchiveData) {
+	std::unique_ptr<PakArchive> newArchive;
+	try {
+		RefreshIoLimits();
+
+		auto now = std::chrono::steady_clock::now();
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - g_LastOperationEndTime).count();
+
+		if (elapsed > 1000) {
+			g_ExtractOptionsShown = false;
+		}
+
+		bool forceReload = g_RequireReload.load();
+
+		if (forceReload && !g_OriginalArchivePath.empty()) {
+			HANDLE hRestore = CreateFileA(g_OriginalArchivePath.c_str(), FILE_WRITE_ATTRIBUTES,
+										 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+			if (hRestore != INVALID_HANDLE_VALUE) {
+				if (SetFileTime(hRestore, NULL, NULL, &g_OriginalArchiveTime)) {
+					LogInfo("[OpenArchive] Timestamp RESTORED to original after reload: " + g_OriginalArchivePath);
+				} else {
+					LogError("[OpenArchive] Failed to restore timestamp in Open: " + std::to_string(GetLastError()));
+				}
+				CloseHandle(hRestore);
+			}
+			g_OriginalArchiveTime = { 0 };
+			g_OriginalArchivePath = "";
+		}
+
+		if (forceReload) {
+			LogInfo("[OpenArchive] FORCE RELOAD triggered for: " + arcName);
+			GameCatalog::Invalidate();
+		}
+
+		LogInfo("[OpenArchive] Opening archive: " + arcName);
+		newArchive = std::make_unique<PakArchive>(arcName);
+
+		if (!newArchive->IsInitialized()) {
+			LogError("[OpenArchive] Initialization failed for: " + arcName);
+			ArchiveData->OpenResult = E_EOPEN;
+			return nullptr;
+		}
+
+		// Konverziós snapshotok eltávolítva
+		if (forceReload) {
+			g_RequireReload = false;
+		}
+
+		g_LastOpenedArcName = arcName;
+
+		LogInfo("[OpenArchive] Adding virtual entry: pak_plugin.ini");
+		newArchive->AddVirtualEntry("pak_plugin.ini");
+
+		newArchive->BuildIndex();
+		newArchive->ResetIndex();
+
+		ArchiveData->OpenResult = 0;
+
+		LogInfo("Successfully opened archive: " + arcName + " (with virtual plugin entry)");
+		LogInfo("[OpenArchive] instance=" + std::to_string((uintptr_t)newArchive.get()));
+
+		return reinterpret_cast<HANDLE>(newArchive.release());
+	}
+	catch (const std::exception& ex) {
+		LogError("[OpenArchive] EXCEPTION: " + std::string(ex.what()));
+		ArchiveData->OpenResult = E_EOPEN;
+		return nullptr;
+	}
+	catch (...) {
+		LogError("[OpenArchive] Unknown EXCEPTION caught.");
+		ArchiveData->OpenResult = E_EOPEN;
+		return nullptr;
+	}
+}
+
+HANDLE __stdcall OpenArchive(tOpenArchiveData* ArchiveData) {
+	if (!ArchiveData || !ArchiveData->ArcName) {
+		LogError("[OpenArchive] Invalid archive data or missing filename.");
+		if (ArchiveData) ArchiveData->OpenResult = E_BAD_ARCHIVE;
+		return nullptr;
+	}
+
+	return OpenArchiveInternal<tOpenArchiveData>(
+		std::string(ArchiveData->ArcName),
+		ArchiveData
+	);
+}
+
+HANDLE __stdcall OpenArchiveW(tOpenArchiveDataW* ArchiveDataW) {
+	if (!ArchiveDataW || !ArchiveDataW->ArcName) {
+		LogError("[OpenArchiveW] Invalid archive data or missing filename.");
+		if (ArchiveDataW) ArchiveDataW->OpenResult = E_BAD_ARCHIVE;
+		return nullptr;
+	}
+
+	return OpenArchiveInternal<tOpenArchiveDataW>(
+		WCharToUTF8(ArchiveDataW->ArcName),
+		ArchiveDataW
+	);
+}
+
+enum class HeaderResult {
+	OK,
+	END,
+	BAD_ARCHIVE,
+	BAD_DATA
+};
+
+struct PreparedHeader {
+	const PakEntry* entry = nullptr;
+	std::string displayName;
+	uint32_t dosTime = 0;
+};
+
+static HeaderResult PrepareHeaderData(HANDLE hArcData, PreparedHeader& out) {
+	PakArchive* arc = GetArchive(hArcData);
+	if (!arc) return HeaderResult::BAD_ARCHIVE;
+
+	int idx = arc->GetAndIncrementIndex();
+	if (idx >= arc->GetEntryCount()) return HeaderResult::END;
+
+	arc->SetLastIndex(idx);
+
+	out.entry = arc->GetEntry(idx);
+	if (!out.entry) return HeaderResult::BAD_DATA;
+
+	out.displayName = out.entry->name;
+	// EDDS kiterjesztés átírási logika eltávolítva
+
+	if (out.entry->timestamp != 0) {
+		FILETIME ft;
+		LONGLONG ll = Int32x32To64(out.entry->timestamp, 10000000) + 116444736000000000;
+		ft.dwLowDateTime = (DWORD)ll;
+		ft.dwHighDateTime = (DWORD)(ll >> 32);
+
+		SYSTEMTIME st;
+		if (FileTimeToSystemTime(&ft, &st)) {
+			out.dosTime = SystemTimeToDosDateTime(st);
+		} else {
+			out.dosTime = 0;
+		}
+	} else {
+		out.dosTime = 0;
+	}
+
+	return HeaderResult::OK;
+}
+
+static int MapHeaderResult(HeaderResult res) {
+	switch (res) {
+		case HeaderResult::END:          return E_END_ARCHIVE;
+		case HeaderResult::BAD_ARCHIVE: return E_BAD_ARCHIVE;
+		case HeaderResult::BAD_DATA:    return E_BAD_DATA;
+		default:                        return 0;
+	}
+}
+
+template<typename T>
+void FillCommon(T& h, const PreparedHeader& ph) {
+	h.PackSize = ph.entry->isDirectory ? 0 : (uint32_t)ph.entry->size;
+	h.UnpSize  = ph.entry->isDirectory ? 0 : (uint32_t)ph.entry->originalSize;
+	h.FileAttr = ph.entry->isDirectory ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+	h.FileTime = ph.dosTime;
+}
+
+int __stdcall ReadHeader(HANDLE hArcData, tHeaderData* h) {
+	PreparedHeader ph;
+	HeaderResult res = PrepareHeaderData(hArcData, ph);
+	if (res != HeaderResult::OK) return MapHeaderResult(res);
+
+	*h = {};
+	FillCommon(*h, ph);
+
+	strncpy_s(h->FileName, _countof(h->FileName), ph.displayName.c_str(), _TRUNCATE);
+
+	return 0;
+}
+
+int __stdcall ReadHeaderEx(HANDLE hArcData, tHeaderDataEx* h) {
+	PreparedHeader ph;
+	HeaderResult res = PrepareHeaderData(hArcData, ph);
+	if (res != HeaderResult::OK) return MapHeaderResult(res);
+
+	*h = {};
+	FillCommon(*h, ph);
+
+	strncpy_s(h->FileName, _countof(h->FileName), ph.displayName.c_str(), _TRUNCATE);
+
+	return 0;
+}
+
+int __stdcall ReadHeaderExW(HANDLE hArcData, tHeaderDataExW* h) {
+	PreparedHeader ph;
+	HeaderResult res = PrepareHeaderData(hArcData, ph);
+	if (res != HeaderResult::OK) return MapHeaderResult(res);
+
+	*h = {};
+	FillCommon(*h, ph);
+
+	int len = MultiByteToWideChar(
+		CP_UTF8, 0,
+		ph.displayName.c_str(),
+		-1,
+		h->FileName,
+		_countof(h->FileName)
+	);
+
+	if (len == 0) {
+		h->FileName[0] = L'\0';
+	}
+
+	return 0;
+}
+
+int __stdcall ProcessFile(HANDLE hArcData, int Operation, char* DestPath, char* DestName)
+{
+	wchar_t wideDestPath[MAX_PATH] = { 0 };
+	wchar_t wideDestName[MAX_PATH] = { 0 };
+
+	if (DestPath)
+		MultiByteToWideChar(CP_ACP, 0, DestPath, -1, wideDestPath, MAX_PATH);
+	if (DestName)
+		MultiByteToWideChar(CP_ACP, 0, DestName, -1, wideDestName, MAX_PATH);
+
+	return ProcessFileW(hArcData, Operation,
+		DestPath ? wideDestPath : nullptr,
+		DestName ? wideDestName : nullptr);
+}
+
+static PakEntry g_CurrentEntryForDialog;
+static PakArchive* g_CurrentArchiveForDialog = nullptr;
+
+static INT_PTR CALLBACK SettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam);
+
+// ============================
+// Viewer check
+// ============================
+static bool IsViewerRequest(const std::wstring& name) {
+	return name.find(L"\\_tc\\") != std::wstring::npos ||
+		   name.find(L"/_tc/") != std::wstring::npos;
+}
+
+// ============================
+// Folder copy detection
+// ============================
+static bool DetectFolderCopy(const std::wstring& wDestName, const PakEntry* entry, bool isViewer) {
+	if (wDestName.empty() || isViewer) return false;
+
+	fs::path pDest(wDestName);
+	fs::path pInternal(UTF8ToWString(entry->name));
+
+	if (pDest.has_parent_path() && pInternal.has_parent_path()) {
+		std::wstring destLast = pDest.parent_path().filename().wstring();
+		std::wstring intLast  = pInternal.parent_path().filename().wstring();
+
+		std::transform(destLast.begin(), destLast.end(), destLast.begin(), ::tolower);
+		std::transform(intLast.begin(), intLast.end(), intLast.begin(), ::tolower);
+
+		if (!destLast.empty() && destLast == intLast) {
+			LogInfo("[ProcessFileW][DEBUG] Folder copy detected (Parent match: " + ws2s(destLast) + ")");
+			return true;
+		}
+	}
+	return false;
+}
+
+// ============================================================================
+// 🔥 SETTINGS HANDLING
+// ============================================================================
+static int HandleSettingsFile(PakArchive* currentArchive, const PakEntry* entry, const wchar_t* DestName) {
+	LogInfo("[ProcessFileW] Settings file triggered via viewer.");
+	g_CurrentArchiveForDialog = currentArchive;
+
+	INT_PTR settingsResult = DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ARMAPAK_SETTINGS), NULL, SettingsDialogProc, 0);
+
+	if (settingsResult == IDOK) {
+		if (DestName) {
+			HANDLE hFile = CreateFileW(DestName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (hFile != INVALID_HANDLE_VALUE) {
+				std::string msg = "Settings applied successfully.";
+				DWORD written = 0;
+				WriteFile(hFile, msg.c_str(), (DWORD)msg.length(), &written, NULL);
+				CloseHandle(hFile);
+			}
+		}
+		return 0;
+	}
+	return E_EABORTED;
+}
+
+// ============================
+// WORKBENCH LAUNCH
+// ============================
+static int HandleWorkbenchLaunch(PakArchive* arc) {
+	LogInfo("[ProcessFileW] Workbench launch triggered.");
+
+	// Konverziós mentés eltávolítva
+
+	static std::atomic<uint64_t> counter{0};
+
+	auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	DWORD pid = GetCurrentProcessId();
+	uint64_t localCounter = counter.fetch_add(1, std::memory_order_relaxed);
+
+	std::string tempBase = "C:\\Temp\\ArmaPak_Preview_" +
+		std::to_string(pid) + "_" +
+		std::to_string(now) + "_" +
+		std::to_string(localCounter);
+
+	fs::create_directories(tempBase);
+
+	LogInfo("[Workbench] Using temp: " + tempBase);
+
+	std::string finalPath = (fs::path(tempBase) / g_CurrentEntryForDialog.name).string();
+
+	// Interactive: runs in the High lane ahead of any background extraction.
+	bool ok = SmartExtractor::ExtractWithDependencies(
+		arc,
+		arc->GetLastIndex(),
+		finalPath,
+		CancellationToken(),
+		ThreadPool::Priority::High
+	);
+
+	if (ok) {
+		OpenInWorkbench(g_CurrentEntryForDialog.name, tempBase);
+
+		std::thread([tempBase]() {
+			LogInfo("[Cleanup] Waiting before deletion: " + tempBase);
+
+			std::this_thread::sleep_for(std::chrono::seconds(10));
+
+			int safetyCounter = 0;
+			while (IsWorkbenchRunning()) {
+				std::this_thread::sleep_for(std::chrono::seconds(2));
+
+				if (++safetyCounter > 300) {
+					LogInfo("[Cleanup] Safety timeout reached, forcing cleanup.");
+					break;
+				}
+			}
+
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+
+			try {
+				if (fs::exists(tempBase)) {
+					fs::remove_all(tempBase);
+					LogInfo("[Cleanup] Deleted temp: " + tempBase);
+				}
+			} catch (...) {
+				LogError("[Cleanup] Failed to delete temp: " + tempBase);
+			}
+		}).detach();
+	}
+
+	return 0;
+}
+
+// ============================
+// TEST
+// ============================
+// While TC searches for text (SetSearchText), a test answers whether the
+// entry contains it instead of checking its integrity.
+static int HandleTest(PakArchive* arc, int entryIndex, const PakEntry* entry) {
+	if (entry->isDirectory) return 0;
+
+	std::wstring pattern;
+	{
+		std::lock_guard<std::mutex> lock(g_SearchTextMutex);
+		pattern = SearchTextW;
+	}
+	if (!pattern.empty()) return arc->MatchesSearchText(entryIndex, pattern) ? E_FILESEARCHOK : E_NO_MORE_FILES;
+
+	std::vector<uint8_t> data = arc->DecompressEntryData(entry);
+
+	auto cb = arc->GetProcessDataProc();
+	if (!cb) return 0;
+
+	const size_t CHUNK = 16384;
+
+	if (entry->originalSize == 0) {
+		std::lock_guard<std::mutex> lock(g_CallbackMutex);
+		cb(const_cast<char*>(entry->name.c_str()), 0);
+		return 0;
+	}
+
+	size_t pos = 0;
+	while (pos < data.size()) {
+		size_t chunkSize = std::min(CHUNK, data.size() - pos);
+
+		int result;
+		{
+			std::lock_guard<std::mutex> lock(g_CallbackMutex);
+			result = cb(const_cast<char*>(entry->name.c_str()), (int)chunkSize);
+		}
+
+		if (result == 0) {
+			LogError("[ProcessFileW] PK_TEST aborted.");
+			return E_EABORTED;
+		}
+
+		pos += chunkSize;
+	}
+
+	return 0;
+}
+
+// ============================
+// EXTRACT
+// ============================
+static int HandleExtract(
+	PakArchive* arc,
+	int entryIndex,
+	const PakEntry* entry,
+	const std::wstring& wDestPath,
+	const std::wstring& wDestName
+) {
+	if (entry && entry->name == "pak_plugin.ini") {
+		return 0;
+	}
+
+	bool isViewer = IsViewerRequest(wDestName);
+	bool isFolderCopy = DetectFolderCopy(wDestName, entry, isViewer);
+
+	fs::path fullTargetPath;
+	if (!wDestName.empty()) fullTargetPath = fs::path(wDestName);
+	else if (!wDestPath.empty()) fullTargetPath = fs::path(wDestPath);
+	else fullTargetPath = fs::current_path();
+
+	fullTargetPath = fullTargetPath.lexically_normal();
+	fs::path basePath = fullTargetPath;
+
+	if (isFolderCopy || (basePath.has_filename() && basePath.has_extension())) {
+		basePath = basePath.parent_path();
+	}
+
+	auto u8str = basePath.u8string();
+	std::string baseDest(reinterpret_cast<const char*>(u8str.c_str()));
+
+	if (entry->isDirectory) {
+		fs::path dirPath = isFolderCopy ? fullTargetPath :
+						   fs::path(PakArchive::BuildFinalPath(baseDest, entry->name));
+		try {
+			fs::create_directories(dirPath);
+			return 0;
+		} catch (...) {
+			auto u8err = dirPath.u8string();
+			LogError("[HandleExtract] Failed to create dir: " + std::string(reinterpret_cast<const char*>(u8err.c_str())));
+			return E_EWRITE;
+		}
+	}
+
+	bool success = false;
+	std::string finalPath;
+	CancellationToken cancel = CancellationToken::create();
+
+	// Konverziós logika eltávolítva (EDDS->DDS stb.)
+
+	if (isViewer || isFolderCopy) {
+		fs::path p = fullTargetPath;
+		auto u8dir = p.u8string();
+		std::string direct(reinterpret_cast<const char*>(u8dir.c_str()));
+		success = arc->ExtractFile(entryIndex, direct, nullptr, cancel);
+		finalPath = direct;
+	}
+	else {
+		if (g_EnableSmartExtract) {
+			auto u8final = PakArchive::BuildFinalPath(baseDest, entry->name).u8string();
+			finalPath = std::string(reinterpret_cast<const char*>(u8final.c_str()));
+			success = SmartExtractor::ExtractWithDependencies(arc, entryIndex, finalPath, cancel);
+		}
+
+		if (!success && !cancel.cancelled()) {
+			success = arc->ExtractFile(entryIndex, baseDest, nullptr, cancel);
+			auto u8final = PakArchive::BuildFinalPath(baseDest, entry->name).u8string();
+			finalPath = std::string(reinterpret_cast<const char*>(u8final.c_str()));
+		}
+	}
+
+	if (cancel.cancelled()) {
+		LogInfo("[HandleExtract] Aborted by user: " + entry->name);
+		return E_EABORTED;
+	}
+
+	if (!success) {
+		LogError("[HandleExtract] Extraction failed for: " + entry->name);
+		return E_EWRITE;
+	}
+
+	return 0;
+}
+
+// ============================================================================
+// 🔥 PROCESSFILEW
+// ============================================================================
+int __stdcall ProcessFileW(HANDLE hArcData, int Operation, const wchar_t* DestPath, const wchar_t* DestName)
+{
+	PakArchive* arc = GetArchive(hArcData);
+
+	try {
+		if (!arc) return E_BAD_ARCHIVE;
+
+		int idx = arc->GetLastIndex();
+		const PakEntry* entry = arc->GetEntry(idx);
+
+		if (entry && entry->name == "pak_plugin.ini") {
+			if (Operation == PK_EXTRACT) {
+				std::wstring wCheck = DestName ? DestName : L"";
+				bool isViewer = IsViewerRequest(wCheck);
+
+				if (isViewer) {
+					return HandleSettingsFile(arc, entry, DestName);
+				}
+				else {
+					LogInfo("[ProcessFileW] Skipping extraction of virtual file: pak_plugin.ini");
+					return 0;
+				}
+			}
+		}
+
+		if (Operation == PK_EXTRACT) {
+			std::wstring currentDestPath = DestPath ? DestPath : L"";
+			std::wstring wCheck = DestName ? DestName : L"";
+			bool isViewer = IsViewerRequest(wCheck);
+
+			if (!isViewer && currentDestPath != g_LastTargetDir) {
+				g_ExtractOptionsShown = false;
+				g_LastTargetDir = currentDestPath;
+			}
+
+			if (!g_ExtractOptionsShown) {
+				if (isViewer && entry && entry->name == "pak_plugin.ini") {
+					return HandleSettingsFile(arc, entry, DestName);
+				}
+
+				if (!isViewer) {
+					if (g_ShowExtractPrompt) {
+						g_CurrentArchiveForDialog = arc;
+						if (entry) g_CurrentEntryForDialog = *entry;
+
+						INT_PTR result = DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_EXTRACT_OPTIONS), NULL, SettingsDialogProc, 0);
+
+						if (result == IDC_OPEN_WORKBENCH) {
+							return HandleWorkbenchLaunch(arc);
+						}
+
+						if (result == IDCANCEL) {
+							return E_EABORTED;
+						}
+
+						if (result == IDOK) {
+							LogInfo("[ProcessFileW] Extract dialog finished.");
+						}
+					}
+					g_ExtractOptionsShown = true;
+				}
+			}
+		}
+
+		if (idx < 0 || idx >= (int)arc->GetEntryCount()) return E_NO_FILES;
+		if (!entry) return E_NO_FILES;
+
+		if (Operation == PK_TEST) {
+			return HandleTest(arc, idx, entry);
+		}
+
+		if (Operation == PK_EXTRACT) {
+			std::wstring wDestPath = DestPath ? DestPath : L"";
+			std::wstring wDestName = DestName ? DestName : L"";
+			return HandleExtract(arc, idx, entry, wDestPath, wDestName);
+		}
+
+		return 0;
+	}
+	catch (...) {
+		LogError("[ProcessFileW] Exception");
+		return E_EWRITE;
+	}
+}
+
+int __stdcall CloseArchive(HANDLE hArcData) {
+	if (!hArcData) {
+		LogError("CloseArchive: NULL handle.");
+		return E_ECLOSE;
+	}
+
+	PakArchive* archiveToClose = reinterpret_cast<PakArchive*>(hArcData);
+
+	g_LastOperationEndTime = std::chrono::steady_clock::now();
+
+	if (!g_OriginalArchivePath.empty() && (g_OriginalArchiveTime.dwLowDateTime != 0 || g_OriginalArchiveTime.dwHighDateTime != 0)) {
+
+		if (g_RequireReload) {
+			LogInfo("[CloseArchive] Refresh in progress, leaving touched timestamp for TC: " + g_OriginalArchivePath);
+		}
+		else {
+			HANDLE hRestore = CreateFileA(g_OriginalArchivePath.c_str(), FILE_WRITE_ATTRIBUTES,
+										 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+
+			if (hRestore != INVALID_HANDLE_VALUE) {
+				if (SetFileTime(hRestore, NULL, NULL, &g_OriginalArchiveTime)) {
+					LogInfo("[CloseArchive] Archive timestamp restored to exact original: " + g_OriginalArchivePath);
+				} else {
+					LogError("[CloseArchive] Failed to restore timestamp: " + std::to_string(GetLastError()));
+				}
+				CloseHandle(hRestore);
+			} else {
+				LogError("[CloseArchive] Failed to open archive for timestamp restoration: " + g_OriginalArchivePath);
+			}
+
+			g_OriginalArchiveTime = { 0 };
+			g_OriginalArchivePath = "";
+		}
+	}
+
+	try {
+		if (archiveToClose) {
+			delete archiveToClose;
+			LogInfo("Archive successfully closed and resources released.");
+			LogInfo("[CloseArchive] instance=" + std::to_string((uintptr_t)archiveToClose));
+		}
+	}
+	catch (const std::exception& ex) {
+		LogError(std::string("CloseArchive EXCEPTION during delete: ") + ex.what());
+		return E_ECLOSE;
+	}
+	catch (...) {
+		LogError("CloseArchive Unknown EXCEPTION during delete.");
+		return E_ECLOSE;
+	}
+
+	g_RequireReload = false;
+
+	return 0;
+}
+
+void __stdcall SetChangeVolProc(HANDLE hArcData, tChangeVolProc pChangeVolProc) {}
+
+void __stdcall SetProcessDataProc(HANDLE hArcData, tProcessDataProc pProcessDataProc) {
+	PakArchive* currentArchive = GetArchive(hArcData);
+	if (currentArchive) {
+		currentArchive->SetProcessDataProc(pProcessDataProc);
+	}
+}
+
+extern "C" __declspec(dllexport) void __stdcall SetSearchText(const char* SearchString) {
+	std::lock_guard<std::mutex> lock(g_SearchTextMutex);
+	if (SearchString) {
+		SearchTextW = UTF8ToWString(SearchString);
+		LogInfo("[SetSearchText] Search pattern set (A): " + WStringToUTF8(SearchTextW));
+	}
+	else {
+		SearchTextW.clear();
+		LogInfo("[SetSearchText] Search pattern cleared (A).");
+	}
+}
+
+extern "C" __declspec(dllexport) void __stdcall SetSearchTextW(const WCHAR* SearchString) {
+	std::lock_guard<std::mutex> lock(g_SearchTextMutex);
+	if (SearchString) {
+		SearchTextW = SearchString;
+		LogInfo("[SetSearchTextW] Search pattern set (W): " + WStringToUTF8(SearchTextW));
+	}
+	else {
+		SearchTextW.clear();
+		LogInfo("[SetSearchTextW] Search pattern cleared (W).");
+	}
+}
+
+// Streams the archive as a tar to hOut (stdout when NULL), e.g. for
+// "export data.pak | zstd > out.tar.zst". Filter is a ';'-separated wildcard list.
+// Returns E_BAD_DATA when the tar was written but some entries could not be
+// read and are missing from it.
+extern "C" __declspec(dllexport) int __stdcall ExportTarW(const WCHAR* ArcName, const WCHAR* Filter, HANDLE hOut) {
+	if (!ArcName) return E_BAD_ARCHIVE;
+	if (!hOut) hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	try {
+		PakArchive arc(WCharToUTF8(ArcName));
+		if (!arc.IsInitialized()) return E_EOPEN;
+		size_t skipped = 0;
+		if (!TarExporter::Export(&arc, hOut, Filter ? WCharToUTF8(Filter) : "", skipped)) return E_EWRITE;
+		return skipped ? E_BAD_DATA : 0;
+	}
+	catch (const std::exception& ex) {
+		LogError("[ExportTarW] EXCEPTION: " + std::string(ex.what()));
+		return E_EWRITE;
+	}
+}
+
+// Writes the smart-extract plan of one entry to hOut (stdout when NULL):
+// per-archive file counts and sizes, then every entry that would be written.
+// Nothing is extracted; only entries that carry references are inflated.
+extern "C" __declspec(dllexport) int __stdcall PlanSmartExtractW(const WCHAR* ArcName, const WCHAR* EntryName, HANDLE hOut) {
+	if (!ArcName || !EntryName) return E_BAD_ARCHIVE;
+	if (!hOut) hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	try {
+		PakArchive arc(WCharToUTF8(ArcName));
+		if (!arc.IsInitialized()) return E_EOPEN;
+
+		int index = arc.FindIndexByName(WCharToUTF8(EntryName));
+		if (index < 0) return E_NO_FILES;
+
+		SmartExtractor::Plan plan;
+		if (!SmartExtractor::PlanDependencies(&arc, index, ".\\", plan)) return E_BAD_DATA;
+
+		std::string text = SmartExtractor::DescribePlan(plan);
+		DWORD written = 0;
+		return WriteFile(hOut, text.data(), (DWORD)text.size(), &written, NULL) ? 0 : E_EWRITE;
+	}
+	catch (const std::exception& ex) {
+		LogError("[PlanSmartExtractW] EXCEPTION: " + std::string(ex.what()));
+		return E_EWRITE;
+	}
+}
+
+// Command-line front end for the I/O limits, in rundll32 form:
+//   rundll32 ArmaPAK.wcx64,IoLimit read=50 readiops=0 write=20 writeiops=200
+// Rates are MB/s and operations/s, 0 or "off" removes all limits. The values
+// are saved to pak_plugin.ini, where a running TC picks them up on the next
+// archive it opens, and echoed to the calling console.
+extern "C" __declspec(dllexport) void __stdcall IoLimitW(HWND hwnd, HINSTANCE hinst, LPWSTR CmdLine, int nCmdShow) {
+	std::wstringstream args(CmdLine ? CmdLine : L"");
+	std::wstring arg;
+	bool ok = true;
+	while (args >> arg) {
+		if (_wcsicmp(arg.c_str(), L"off") == 0) {
+			g_ReadLimitMBps = g_ReadLimitIops = g_WriteLimitMBps = g_WriteLimitIops = 0;
+			continue;
+		}
+
+		size_t eq = arg.find(L'=');
+		int value = eq == std::wstring::npos ? -1 : _wtoi(arg.c_str() + eq + 1);
+		std::wstring key = eq == std::wstring::npos ? arg : arg.substr(0, eq);
+		int* target = _wcsicmp(key.c_str(), L"read") == 0 ? &g_ReadLimitMBps :
+					  _wcsicmp(key.c_str(), L"readiops") == 0 ? &g_ReadLimitIops :
+					  _wcsicmp(key.c_str(), L"write") == 0 ? &g_WriteLimitMBps :
+					  _wcsicmp(key.c_str(), L"writeiops") == 0 ? &g_WriteLimitIops : nullptr;
+		if (!target || value < 0) {
+			LogError("[IoLimit] Bad argument: " + WStringToUTF8(arg));
+			ok = false;
+			continue;
+		}
+		*target = value;
+	}
+
+	if (ok) {
+		SaveIoLimits();
+		ApplyIoLimits();
+	}
+
+	std::string text = ok ? "" : "usage: IoLimit [read=MBps] [readiops=N] [write=MBps] [writeiops=N] | off\r\n";
+	text += "read " + std::to_string(g_ReadLimitMBps) + " MB/s, " + std::to_string(g_ReadLimitIops) + " IOPS; write " +
+			std::to_string(g_WriteLimitMBps) + " MB/s, " + std::to_string(g_WriteLimitIops) + " IOPS (0 = unlimited)\r\n";
+	LogInfo("[IoLimit] " + text.substr(0, text.size() - 2));
+	if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+		DWORD written = 0;
+		WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), text.data(), (DWORD)text.size(), &written, NULL);
+		FreeConsole();
+	}
+}
+
+const int SEARCH_CASE_SENSITIVE = 1;
+const int SEARCH_OFFSETS = 2;
+const int SEARCH_INDEXED = 4;
+const int SEARCH_TEXT_ONLY = 8;
+
+// Types an exported search looks at: text and scripts with
+// SEARCH_TEXT_ONLY, otherwise SearchTypes from the INI (0 = any).
+static uint32_t SearchTypeMask(int Flags) {
+	return (Flags & SEARCH_TEXT_ONLY) ? ContentClassifier::TEXTUAL : ContentClassifier::ParseMask(g_SearchTypes);
+}
+
+// grep over the inflated entries of an archive: writes the name of every
+// entry containing Pattern, as UTF-8 or UTF-16LE text, to hOut (stdout when
+// NULL). SEARCH_OFFSETS lists "name:offset" for every match instead, and
+// matching ignores ASCII case unless SEARCH_CASE_SENSITIVE is set.
+// SEARCH_INDEXED (or ContentIndex=1 in the INI) searches the text-like
+// entries through the archive's trigram index. SEARCH_TEXT_ONLY skips
+// every entry that isn't text or script without inflating it. Returns
+// E_NO_FILES when nothing matched.
+extern "C" __declspec(dllexport) int __stdcall SearchContentW(const WCHAR* ArcName, const WCHAR* Pattern, int Flags, HANDLE hOut) {
+	if (!ArcName || !Pattern) return E_BAD_ARCHIVE;
+	if (!hOut) hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	try {
+		ContentMatcher matcher(Pattern, (Flags & SEARCH_CASE_SENSITIVE) != 0);
+		if (matcher.Empty()) return E_BAD_DATA;
+
+		PakArchive arc(WCharToUTF8(ArcName));
+		if (!arc.IsInitialized()) return E_EOPEN;
+
+		std::vector<int> hits = arc.SearchContent(matcher, Pattern, (Flags & SEARCH_INDEXED) || g_UseContentIndex, SearchTypeMask(Flags));
+		std::string text;
+		for (int index : hits) {
+			const PakEntry* entry = arc.GetEntry(index);
+			if (!(Flags & SEARCH_OFFSETS)) {
+				text += entry->name + "\r\n";
+				continue;
+			}
+
+			// Only the matching entries are inflated a second time.
+			std::vector<uint8_t> data = arc.DecompressEntryData(entry);
+			for (size_t pos = matcher.Find(data.data(), data.size()); pos < data.size(); pos = matcher.Find(data.data(), data.size(), pos + 1)) {
+				text += entry->name + ":" + std::to_string(pos) + "\r\n";
+			}
+		}
+
+		DWORD written = 0;
+		if (!text.empty() && !WriteFile(hOut, text.data(), (DWORD)text.size(), &written, NULL)) return E_EWRITE;
+		return hits.empty() ? E_NO_FILES : 0;
+	}
+	catch (const std::exception& ex) {
+		LogError("[SearchContentW] EXCEPTION: " + std::string(ex.what()));
+		return E_EREAD;
+	}
+}
+
+// Multi-pattern grep: Patterns holds one pattern per line, or "@file" names
+// a UTF-8 file of them. A line written as /regex/ is a regular expression
+// (see PatternSet for the syntax), anything else a literal. Every match is
+// written to hOut (stdout when NULL) as "entry:offset:pattern". Takes the
+// same flags as SearchContentW; SEARCH_OFFSETS is implied. Returns
+// E_BAD_DATA for a pattern that doesn't compile (the reason is logged) and
+// E_NO_FILES when nothing matched.
+extern "C" __declspec(dllexport) int __stdcall SearchPatternsW(const WCHAR* ArcName, const WCHAR* Patterns, int Flags, HANDLE hOut) {
+	if (!ArcName || !Patterns) return E_BAD_ARCHIVE;
+	if (!hOut) hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	try {
+		std::string text = WCharToUTF8(Patterns);
+		if (!text.empty() && text[0] == '@') {
+			std::ifstream in(fs::path(UTF8ToWString(text.substr(1))), std::ios::binary);
+			if (!in) return E_EOPEN;
+			text.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);
+		}
+
+		PatternSet set((Flags & SEARCH_CASE_SENSITIVE) != 0);
+		std::vector<std::string> labels;
+		std::istringstream lines(text);
+		for (std::string line; std::getline(lines, line);) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty()) continue;
+
+			std::string error;
+			if (line.size() > 2 && line.front() == '/' && line.back() == '/') {
+				if (!set.AddRegex(std::string_view(line).substr(1, line.size() - 2), error)) {
+					LogError("[SearchPatternsW] " + error);
+					return E_BAD_DATA;
+				}
+			} else {
+				set.AddLiteral(line);
+			}
+			labels.push_back(line);
+		}
+
+		std::string error;
+		if (labels.empty()) return E_BAD_DATA;
+		if (!set.Compile(error)) {
+			LogError("[SearchPatternsW] " + error);
+			return E_BAD_DATA;
+		}
+
+		PakArchive arc(WCharToUTF8(ArcName));
+		if (!arc.IsInitialized()) return E_EOPEN;
+
+		auto t0 = std::chrono::steady_clock::now();
+		auto hits = arc.SearchPatterns(set, (Flags & SEARCH_INDEXED) || g_UseContentIndex, SearchTypeMask(Flags));
+		std::string out;
+		size_t count = 0;
+		for (const auto& [index, matches] : hits) {
+			const std::string& name = arc.GetEntry(index)->name;
+			for (const PatternSet::Match& m : matches) out += name + ":" + std::to_string(m.offset) + ":" + labels[m.pattern] + "\r\n";
+			count += matches.size();
+		}
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+		LogInfo("[SearchPatternsW] " + std::to_string(labels.size()) + " patterns, " + std::to_string(count) + " matches in " +
+				std::to_string(hits.size()) + " entries, " + std::to_string(ms) + " ms");
+
+		DWORD written = 0;
+		if (!out.empty() && !WriteFile(hOut, out.data(), (DWORD)out.size(), &written, NULL)) return E_EWRITE;
+		return hits.empty() ? E_NO_FILES : 0;
+	}
+	catch (const std::exception& ex) {
+		LogError("[SearchPatternsW] EXCEPTION: " + std::string(ex.what()));
+		return E_EREAD;
+	}
+}
+
+static INT_PTR CALLBACK AboutDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam) {
+	switch (message) {
+	case WM_INITDIALOG: {
+		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_ABOUT_LOGO);
+		if (hLogoCtrl) {
+			RECT rect;
+			GetClientRect(hLogoCtrl, &rect);
+			int width = rect.right - rect.left;
+			int height = rect.bottom - rect.top;
+
+			HBITMAP hBmp = (HBITMAP)LoadImage(g_hModule,
+											MAKEINTRESOURCE(IDB_LOGO),
+											IMAGE_BITMAP,
+											width,
+											height,
+											LR_CREATEDIBSECTION);
+
+			if (hBmp) {
+				SendMessage(hLogoCtrl, STM_SETIMAGE, IMAGE_BITMAP, (LPARAM)hBmp);
+			}
+		}
+
+		std::wstring versionText = L"ARMA PAK Plugin v" + UTF8ToWString(PLUGIN_VERSION_STRING);
+		SetDlgItemTextW(hDlg, IDC_ABOUT_VERSION_TEXT, versionText.c_str());
+		SetDlgItemTextW(hDlg, IDC_ABOUT_AUTHOR_TEXT, L"by Icebird");
+		SetDlgItemTextW(hDlg, IDC_ABOUT_SUPPORT_TEXT, L"\u00A9 2026 Icebird. All rights reserved.");
+
+		return TRUE;
+	}
+	case WM_COMMAND: {
+		if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL) {
+			EndDialog(hDlg, LOWORD(wParam));
+			return TRUE;
+		}
+		break;
+	}
+	case WM_DESTROY: {
+		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_ABOUT_LOGO);
+		if (hLogoCtrl) {
+			HBITMAP hBmp = (HBITMAP)SendMessage(hLogoCtrl, STM_GETIMAGE, IMAGE_BITMAP, 0);
+			if (hBmp) DeleteObject(hBmp);
+		}
+		return TRUE;
+	}
+	}
+	return FALSE;
+}
+
+// ============================================================================
+// 🔥 SETTINGS DIALOG PROC
+// ============================================================================
+static INT_PTR CALLBACK SettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam) {
+	static bool isSettingsOnlyMode = false;
+
+	switch (message) {
+	case WM_INITDIALOG: {
+		isSettingsOnlyMode = (lParam == 1);
+
+		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_LOGO);
+		if (hLogoCtrl) {
+			RECT rect = { 0 };
+			GetClientRect(hLogoCtrl, &rect);
+			int width = rect.right - rect.left;
+			int height = rect.bottom - rect.top;
+
+			HBITMAP hBmp = (HBITMAP)LoadImage(g_hModule,
+											MAKEINTRESOURCE(IDB_LOGO),
+											IMAGE_BITMAP,
+											width,
+											height,
+											LR_CREATEDIBSECTION);
+
+			if (hBmp) SendMessage(hLogoCtrl, STM_SETIMAGE, IMAGE_BITMAP, (LPARAM)hBmp);
+		}
+
+		CheckDlgButton(hDlg, IDC_ENABLE_SMART_EXTRACT, g_EnableSmartExtract ? BST_CHECKED : BST_UNCHECKED);
+		CheckDlgButton(hDlg, IDC_KEEP_STRUCT, g_KeepDirectoryStructure ? BST_CHECKED : BST_UNCHECKED);
+
+		if (GetDlgItem(hDlg, IDC_ENABLE_LOG_INFO)) {
+			CheckDlgButton(hDlg, IDC_ENABLE_LOG_INFO, g_EnableLogInfo ? BST_CHECKED : BST_UNCHECKED);
+		}
+
+		if (GetDlgItem(hDlg, IDC_SHOW_EXTRACT_PROMPT)) {
+			CheckDlgButton(hDlg, IDC_SHOW_EXTRACT_PROMPT, g_ShowExtractPrompt ? BST_CHECKED : BST_UNCHECKED);
+		}
+
+		HWND hWorkbenchBtn = GetDlgItem(hDlg, IDC_OPEN_WORKBENCH);
+		if (hWorkbenchBtn) {
+			bool shouldShow = false;
+			if (!g_CurrentEntryForDialog.name.empty() && !g_CurrentEntryForDialog.isDirectory) {
+				std::string ext = fs::path(g_CurrentEntryForDialog.name).extension().string();
+				std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+				if (IsWorkbenchSupported(ext)) shouldShow = true;
+			}
+			ShowWindow(hWorkbenchBtn, shouldShow ? SW_SHOW : SW_HIDE);
+		}
+
+		return TRUE;
+	}
+
+	case WM_COMMAND: {
+		WORD controlId = LOWORD(wParam);
+
+		switch (controlId) {
+		case IDOK: {
+			g_EnableSmartExtract = (IsDlgButtonChecked(hDlg, IDC_ENABLE_SMART_EXTRACT) == BST_CHECKED);
+			g_KeepDirectoryStructure = (IsDlgButtonChecked(hDlg, IDC_KEEP_STRUCT) == BST_CHECKED);
+
+			if (GetDlgItem(hDlg, IDC_ENABLE_LOG_INFO)) {
+				g_EnableLogInfo = (IsDlgButtonChecked(hDlg, IDC_ENABLE_LOG_INFO) == BST_CHECKED);
+			}
+
+			if (GetDlgItem(hDlg, IDC_SHOW_EXTRACT_PROMPT)) {
+				g_ShowExtractPrompt = (IsDlgButtonChecked(hDlg, IDC_SHOW_EXTRACT_PROMPT) == BST_CHECKED);
+			}
+
+			SaveSettings();
+			EndDialog(hDlg, IDOK);
+			return TRUE;
+		}
+		case IDC_OPEN_WORKBENCH: {
+			EndDialog(hDlg, IDC_OPEN_WORKBENCH);
+			return TRUE;
+		}
+		case IDCANCEL: {
+			EndDialog(hDlg, LOWORD(wParam));
+			return TRUE;
+		}
+		case IDC_ABOUT_BUTTON: {
+			DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ABOUTBOX), hDlg, AboutDialogProc, 0);
+			return TRUE;
+		}
+		}
+		break;
+	}
+
+	case WM_DESTROY: {
+		HWND hLogoCtrl = GetDlgItem(hDlg, IDC_LOGO);
+		if (hLogoCtrl) {
+			HBITMAP hBmp = (HBITMAP)SendMessage(hLogoCtrl, STM_GETIMAGE, IMAGE_BITMAP, 0);
+			if (hBmp) DeleteObject(hBmp);
+		}
+		return TRUE;
+	}
+	}
+	return FALSE;
+}
+
+extern "C" __declspec(dllexport) int __stdcall ConfigurePacker(HWND Parent, HINSTANCE DllInstance) {
+	g_LastOpenedArcName = "";
+	DialogBoxParam(DllInstance, MAKEINTRESOURCE(IDD_ARMAPAK_SETTINGS), Parent, SettingsDialogProc, 0);
+	return 0;
+}
+
+extern "C" __declspec(dllexport) void __stdcall About(HWND Parent) {
+	DialogBoxParam(g_hModule, MAKEINTRESOURCE(IDD_ABOUTBOX), Parent, AboutDialogProc, 0);
+}
+
+extern "C" __declspec(dllexport) int __stdcall GetPackerCaps() {
+	return PK_CAPS_MULTIPLE | PK_CAPS_BY_CONTENT | PK_CAPS_OPTIONS | PK_CAPS_SEARCHTEXT | PK_CAPS_MEMPACK;
+}
+
+static BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved) {
+	switch (ul_reason_for_call) {
+	case DLL_PROCESS_ATTACH:
+		g_hModule = hModule;
+		{
+			std::error_code ec;
+			if (!fs::exists(GetIniPath(), ec)) {
+				SaveSettings();
+				SaveIoLimits();
+			} else {
+				LoadSettings();
+			}
+		}
+
+		if (!g_ThreadPool) {
+			unsigned int numThreads = g_CpuThreads > 0 ? (unsigned int)g_CpuThreads : std::thread::hardware_concurrency();
+			if (numThreads == 0) numThreads = 4;
+			std::chrono::milliseconds idle = std::chrono::seconds(std::max(1, g_PoolIdleSeconds));
+			g_ThreadPool = std::make_unique<ThreadPool>(numThreads, idle);
+			g_IoPool = std::make_unique<ThreadPool>((size_t)std::max(1, g_IoThreads), idle);
+		}
+
+		{
+			std::string logFilePath = GetLogPath();
+			debugLog.open(logFilePath, std::ios::out | std::ios::app);
+			if (debugLog.is_open()) {
+				logInitialized = true;
+				time_t now = time(nullptr);
+				char timeStr[26];
+				ctime_s(timeStr, sizeof(timeStr), &now);
+				if (timeStr[strlen(timeStr) - 1] == '\n') timeStr[strlen(timeStr) - 1] = '\0';
+
+				debugLog << "\n\n=== DLL ATTACH: New session === " << timeStr << "\n";
+				debugLog << "Plugin version: " << PLUGIN_VERSION_STRING << "\n";
+				debugLog << "[INIT] Settings loaded.\n";
+				debugLog.flush();
+			}
+		}
+		break;
+	case DLL_PROCESS_DETACH:
+		GameCatalog::Shutdown();
+		DependencyCache::Shutdown();
+		ContentIndex::Shutdown();
+		if (g_ThreadPool) g_ThreadPool.reset();
+		if (g_IoPool) g_IoPool.reset();
+		if (logInitialized && debugLog.is_open()) {
+			debugLog << "[INFO] === DLL DETACH: Session end ===\n";
+			debugLog.close();
+		}
+		break;
+	}
+	return TRUE;
+}
+
+struct SmartExtractor::Graph {
+	fs::path baseExtractionDir;
+	fs::path rootParent;
+	uint64_t maxEntries = 0;
+	uint64_t maxBytes = 0;
+
+	// Visited (archive serial, entry index) pairs, sharded by key.
+	static constexpr size_t SHARDS = 64;
+	std::mutex visitedMutex[SHARDS];
+	std::unordered_set<uint64_t> visited[SHARDS];
+
+	std::mutex planMutex;
+	Plan* plan = nullptr;
+
+	std::atomic<uint64_t> entries{ 0 };
+	std::atomic<uint64_t> bytes{ 0 };
+	std::atomic<uint64_t> scanned{ 0 };
+	std::atomic<uint64_t> cached{ 0 };
+	std::atomic<uint64_t> kept{ 0 };
+	std::atomic<bool> budgetHit{ false };
+
+	ThreadPool::TaskGroup tasks;
+
+	explicit Graph(ThreadPool::Priority priority) : tasks(g_ThreadPool.get(), priority) {}
+};
+
+bool SmartExtractor::ExtractWithDependencies(PakArchive* sourceArc, int index, const std::string& destPath,
+											 const CancellationToken& cancel, ThreadPool::Priority priority)
+{
+	auto t0 = std::chrono::steady_clock::now();
+
+	Plan plan;
+	plan.cancel = cancel;
+	plan.priority = priority;
+	plan.keepScannedBytes = KEEP_SCANNED_BYTES;
+	if (!PlanDependencies(sourceArc, index, destPath, plan)) return false;
+	bool ok = ExecutePlan(plan);
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[SmartExtract] " + std::string(cancel.cancelled() ? "Cancelled after " : "Done in ") + std::to_string(ms) + " ms");
+	ResolveMemo::LogStats();
+	return ok;
+}
+
+bool SmartExtractor::PlanDependencies(PakArchive* sourceArc, int index, const std::string& destPath, Plan& plan)
+{
+	const PakEntry* rootEntry = sourceArc->GetEntry(index);
+	if (!rootEntry) return false;
+
+	auto t0 = std::chrono::steady_clock::now();
+	fs::path winDestFile(destPath);
+
+	bool isViewer = winDestFile.has_filename() && winDestFile.extension() != "";
+
+	Graph graph(plan.priority);
+	graph.plan = &plan;
+	graph.baseExtractionDir = winDestFile.parent_path();
+	graph.rootParent = fs::path(rootEntry->name).parent_path();
+	graph.maxEntries = (uint64_t)std::max(1, g_SmartExtractMaxFiles);
+	graph.maxBytes = (uint64_t)std::max(1, g_SmartExtractMaxMB) * 1024 * 1024;
+
+	fs::path finalRootPath;
+	if (isViewer) {
+		finalRootPath = winDestFile;
+	} else {
+		finalRootPath = PakArchive::BuildFinalPath(graph.baseExtractionDir.string(), rootEntry->name);
+	}
+
+	// Loaded up front, so no task of the walk has to wait for them.
+	GuidIndex::Prepare();
+	GameCatalog::Prepare();
+	Spawn(graph, sourceArc, index, finalRootPath.string());
+	graph.tasks.wait();
+
+	if (plan.cancel.cancelled()) {
+		LogInfo("[SmartExtract] Planning cancelled.");
+		return false;
+	}
+
+	plan.truncated = graph.budgetHit;
+	if (graph.budgetHit) {
+		LogInfo("[LIMIT] Budget of " + std::to_string(graph.maxEntries) + " files / " +
+				std::to_string(graph.maxBytes / (1024 * 1024)) + " MB reached, dependency chain truncated.");
+	}
+
+	// Two archives may ship an entry under the same name; the first one planned wins the target path.
+	std::unordered_set<std::string> targets;
+	std::vector<PlanItem> items;
+	items.reserve(plan.items.size());
+	for (auto& item : plan.items) {
+		if (!targets.insert(item.targetPath).second) {
+			LogInfo("[SKIP] Duplicate target: " + item.targetPath);
+			continue;
+		}
+
+		const PakEntry* entry = item.archive->GetEntry(item.index);
+		for (ArchiveTotals* totals : { &plan.archives[item.archive->GetFilename()], &plan.total }) {
+			totals->files++;
+			totals->packedBytes += entry->size;
+			totals->bytes += entry->originalSize;
+		}
+		items.push_back(std::move(item));
+	}
+	plan.items = std::move(items);
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[SmartExtract] Planned " + std::to_string(plan.total.files) + " entries, " +
+			std::to_string(plan.total.bytes / 1024) + " KB from " + std::to_string(plan.archives.size()) + " archives in " +
+			std::to_string(ms) + " ms, " + std::to_string(graph.scanned.load()) + " scanned, " +
+			std::to_string(graph.cached.load()) + " from dependency cache");
+	DependencyCache::Flush();
+	return true;
+}
+
+// Entries are grouped per archive and sorted by offset, then dispatched in
+// that order, so every archive is read front to back. Each entry is inflated
+// on the CPU pool and written on the I/O pool, so inflation keeps the cores
+// busy while writers block on the disk. How many entries are in flight at
+// once is tuned while the plan runs (AdaptiveConcurrency); together with the
+// plan's cap on kept scan data that bounds the inflated bytes held in memory.
+bool SmartExtractor::ExecutePlan(Plan& plan)
+{
+	std::map<PakArchive*, std::vector<PlanItem*>> byArchive;
+	for (auto& item : plan.items) byArchive[item.archive].push_back(&item);
+
+	std::vector<PlanItem*> order;
+	for (auto& [arc, items] : byArchive) {
+		std::sort(items.begin(), items.end(), [arc = arc](const PlanItem* a, const PlanItem* b) {
+			return arc->GetEntry(a->index)->offset < arc->GetEntry(b->index)->offset;
+		});
+		order.insert(order.end(), items.begin(), items.end());
+	}
+
+	const CancellationToken& cancel = plan.cancel;
+	AdaptiveConcurrency limit(4, g_IoPool ? g_IoPool->size() : 1);
+	std::atomic<uint64_t> failed{ 0 };
+
+	std::mutex slotMutex;
+	std::condition_variable slotFreed;
+	size_t inFlight = 0;
+	size_t completed = 0;
+	auto finish = [&] {
+		{
+			std::lock_guard<std::mutex> lock(slotMutex);
+			inFlight--;
+			completed++;
+		}
+		slotFreed.notify_one();
+	};
+
+	ThreadPool::TaskGroup inflates(g_ThreadPool.get(), plan.priority);
+	ThreadPool::TaskGroup writes(g_IoPool.get(), plan.priority);
+
+	auto write = [&](PlanItem* item, AdaptiveConcurrency::Clock::time_point start) {
+		uint64_t bytes = 0;
+		try {
+			LogInfo("[EXTRACT] " + item->archive->GetEntry(item->index)->name);
+			if (!item->archive->ExtractFile(item->index, item->targetPath, item->data.empty() ? nullptr : &item->data, cancel)) failed++;
+			bytes = item->archive->GetEntry(item->index)->originalSize;
+
+			// Scanned bytes are no longer needed once written.
+			std::vector<uint8_t>().swap(item->data);
+		}
+		catch (...) {
+			failed++;
+		}
+		limit.Release(bytes, AdaptiveConcurrency::Clock::now() - start);
+		finish();
+	};
+
+	auto inflate = [&](PlanItem* item, AdaptiveConcurrency::Clock::time_point start) {
+		bool pending = !cancel.cancelled();
+		try {
+			if (pending && fs::exists(item->targetPath)) {
+				LogInfo("[SKIP] Already exists: " + item->targetPath);
+				pending = false;
+			}
+
+			// Entries that fail to inflate here are retried, and reported, by ExtractFile.
+			if (pending && item->data.empty()) {
+				item->data = item->archive->DecompressEntryData(item->archive->GetEntry(item->index), cancel);
+			}
+		}
+		catch (const CancellationToken::OperationCancelled&) {
+			pending = false;
+		}
+		catch (...) {}
+
+		if (!pending) {
+			limit.Release();
+			finish();
+			return;
+		}
+		writes.run([&write, item, start] { write(item, start); });
+	};
+
+	// A slot is taken before an entry is handed to the pools and given back
+	// once it is written or dropped; the limit can change on every release.
+	size_t next = 0;
+	size_t seen = 0;
+	for (;;) {
+		while (next < order.size() && !cancel.cancelled() && limit.TryAcquire()) {
+			{
+				std::lock_guard<std::mutex> lock(slotMutex);
+				inFlight++;
+			}
+			PlanItem* item = order[next++];
+			inflates.run([&inflate, item, start = AdaptiveConcurrency::Clock::now()] { inflate(item, start); });
+		}
+
+		std::unique_lock<std::mutex> lock(slotMutex);
+		if (inFlight == 0 && (next == order.size() || cancel.cancelled())) break;
+		slotFreed.wait(lock, [&] { return completed != seen; });
+		seen = completed;
+	}
+
+	for (ThreadPool::TaskGroup* stage : { &inflates, &writes }) {
+		try {
+			stage->wait();
+		}
+		catch (const std::exception& ex) {
+			LogError("[SmartExtract] Run failed: " + std::string(ex.what()));
+		}
+	}
+
+	LogInfo("[SmartExtract] Wrote " + std::to_string(plan.items.size() - failed) + " of " + std::to_string(plan.items.size()) +
+			" planned entries (" + std::to_string(failed.load()) + " failed), concurrency " + limit.Summary());
+	return !cancel.cancelled();
+}
+
+std::string SmartExtractor::DescribePlan(const Plan& plan) {
+	auto line = [](const std::string& name, const ArchiveTotals& t) {
+		return std::to_string(t.files) + " files, " + std::to_string(t.bytes / 1024) + " KB (" +
+			   std::to_string(t.packedBytes / 1024) + " KB packed)  " + name + "\r\n";
+	};
+
+	std::string text;
+	for (const auto& [name, totals] : plan.archives) text += line(name, totals);
+	text += line("total", plan.total);
+	if (plan.truncated) text += "budget reached, dependency chain truncated\r\n";
+	text += "\r\n";
+	for (const auto& item : plan.items) text += item.archive->GetEntry(item.index)->name + "\r\n";
+	return text;
+}
+
+void SmartExtractor::Spawn(Graph& graph, PakArchive* arc, int index, std::string targetPath) {
+	uint64_t key = ((uint64_t)arc->GetSerial() << 32) | (uint32_t)index;
+	size_t shard = std::hash<uint64_t>{}(key) % Graph::SHARDS;
+	{
+		std::lock_guard<std::mutex> lock(graph.visitedMutex[shard]);
+		if (!graph.visited[shard].insert(key).second) return;
+	}
+
+	if (graph.entries.fetch_add(1) >= graph.maxEntries) {
+		graph.budgetHit = true;
+		return;
+	}
+
+	graph.tasks.run([&graph, arc, index, path = std::move(targetPath)]() {
+		try {
+			Visit(graph, arc, index, path);
+		}
+		catch (...) {
+			LogInfo("[DEP ERROR] Failed to process: " + path);
+		}
+	});
+}
+
+void SmartExtractor::Visit(Graph& graph, PakArchive* arc, int index, const std::string& targetPath) {
+	const PakEntry* entry = arc->GetEntry(index);
+	if (!entry || entry->isDirectory || graph.plan->cancel.cancelled()) return;
+
+	if (graph.bytes.fetch_add(entry->originalSize) + entry->originalSize > graph.maxBytes) {
+		graph.budgetHit = true;
+		return;
+	}
+
+	std::vector<uint8_t> data;
+	std::vector<std::string> deps;
+
+	try {
+		if (CollectReferences(arc, index, deps, data, graph.plan->cancel)) {
+			if (data.empty()) graph.cached++;
+			else graph.scanned++;
+		}
+
+		for (const auto& ref : deps) {
+			PakArchive* targetArchive = nullptr;
+			int depIndex = -1;
+			const PakEntry* depEntry = ResolveReference(arc, ref, targetArchive, depIndex) ? targetArchive->GetEntry(depIndex) : nullptr;
+
+			if (depEntry) {
+				fs::path relDep = fs::relative(depEntry->name, graph.rootParent);
+				Spawn(graph, targetArchive, depIndex, (graph.baseExtractionDir / relDep).string());
+			}
+			else {
+				LogInfo("[DEP NOT FOUND] " + ref);
+			}
+		}
+	}
+	catch (...) {
+		LogInfo("[DEP ERROR] Failed to process dependencies for: " + entry->name);
+	}
+
+	// Scanned bytes are kept only within the plan's budget; the rest is
+	// inflated again when the plan runs.
+	if (!data.empty() && graph.kept.fetch_add(data.size()) + data.size() > graph.plan->keepScannedBytes) {
+		graph.kept.fetch_sub(data.size());
+		std::vector<uint8_t>().swap(data);
+	}
+
+	std::lock_guard<std::mutex> lock(graph.planMutex);
+	graph.plan->items.push_back({ arc, index, targetPath, std::move(data) });
+}
+
+bool SmartExtractor::CollectReferences(PakArchive* arc, int index, std::vector<std::string>& refs, std::vector<uint8_t>& data,
+										const CancellationToken& cancel) {
+	const PakEntry* entry = arc->GetEntry(index);
+	if (!entry || entry->isDirectory) return false;
+
+	// Textures, sounds and other binary data never reference anything.
+	ContentType type = arc->GetEntryType(index);
+	if (type == ContentType::Texture || type == ContentType::Audio || type == ContentType::Binary) return false;
+
+	std::string ext = fs::path(entry->name).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	if (!Parsers().count(ext)) return false;
+
+	if (DependencyCache::Lookup(arc, index, refs)) return true;
+
+	data = arc->DecompressEntryData(entry, cancel);
+	for (const auto& depLine : FindDependencies(arc, ext, data)) {
+		LogInfo("[DEP RAW] " + std::string(depLine));
+		refs.emplace_back(depLine);
+	}
+	DependencyCache::Store(arc, index, refs);
+	return true;
+}
+
+// A GUID survives the resource being moved; the path is the fallback.
+bool SmartExtractor::ResolveReference(PakArchive* requester, const std::string& ref, PakArchive*& owner, int& index) {
+	uint64_t guid;
+	if (GuidIndex::ParseGuid(ref, guid) && GuidIndex::Resolve(guid, requester, owner, index)) return true;
+
+	std::string cleanPath = CleanDependencyPath(ref);
+	return !cleanPath.empty() && requester->ResolveEntry(cleanPath, owner, index);
+}
+
+std::string SmartExtractor::CleanDependencyPath(std::string_view depLine) {
+	std::string cleanPath(depLine);
+
+	size_t bracePos = cleanPath.find('}');
+	if (bracePos != std::string::npos) cleanPath = cleanPath.substr(bracePos + 1);
+
+	auto startIdx = cleanPath.find_first_not_of(" \t\n\r");
+	auto endIdx = cleanPath.find_last_not_of(" \t\n\r");
+	if (startIdx == std::string::npos || endIdx == std::string::npos) return {};
+	cleanPath = cleanPath.substr(startIdx, endIdx - startIdx + 1);
+
+	std::replace(cleanPath.begin(), cleanPath.end(), '/', '\\');
+	std::transform(cleanPath.begin(), cleanPath.end(), cleanPath.begin(), ::tolower);
+
+	size_t assetsPos = cleanPath.find("assets\\");
+	if (assetsPos != std::string::npos) cleanPath = cleanPath.substr(assetsPos);
+	size_t commonPos = cleanPath.find("common\\");
+	if (commonPos != std::string::npos) cleanPath = cleanPath.substr(commonPos);
+
+	return cleanPath;
+}
+
+std::vector<std::string_view> SmartExtractor::FindDependencies(PakArchive* sourceArc, const std::string& ext, const std::vector<uint8_t>& data) {
+	if (data.empty()) return {};
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::vector<std::string_view> results;
+	size_t touched = 0;
+	const char* method = PathScanner::Backend();
+
+	auto parser = Parsers().find(ext);
+	if (parser != Parsers().end() && parser->second(data, results, touched)) {
+		method = "parser";
+	} else {
+		results = PathScanner::Scan(data.data(), data.size());
+		touched = data.size();
+	}
+
+	// The scanners match from "assets/" or "common/"; take a "{GUID}" right
+	// in front of the path along, so the reference can be resolved by GUID.
+	const char* base = reinterpret_cast<const char*>(data.data());
+	for (auto& r : results) {
+		uint64_t guid;
+		if (r.data() - base >= 18 && GuidIndex::ParseGuid(std::string_view(r.data() - 18, 18), guid)) {
+			r = std::string_view(r.data() - 18, r.size() + 18);
+		}
+	}
+	std::sort(results.begin(), results.end());
+	results.erase(std::unique(results.begin(), results.end()), results.end());
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+	LogInfo("[DepScan] " + ext + ": touched " + std::to_string(touched / 1024) + " of " + std::to_string(data.size() / 1024) +
+			" KB in " + std::to_string(us) + " us (" + method + "), " + std::to_string(results.size()) + " paths");
+	return results;
+}
+
+const std::unordered_map<std::string, SmartExtractor::DependencyParser>& SmartExtractor::Parsers() {
+	static const std::unordered_map<std::string, DependencyParser> parsers = {
+		{ ".xob", &SmartExtractor::ParseXob },
+		{ ".emat", &SmartExtractor::ParseEnfusionText },
+		{ ".et", &SmartExtractor::ParseEnfusionText },
+		{ ".conf", &SmartExtractor::ParseEnfusionText },
+		{ ".layout", &SmartExtractor::ParseEnfusionText },
+	};
+	return parsers;
+}
+
+// XOB models are IFF: "FORM" <u32 BE size> "XOB?" followed by chunks. The
+// material paths live in the HEAD chunk; the LOD and collision chunks that
+// make up the bulk of the file are skipped by their headers alone.
+bool SmartExtractor::ParseXob(const std::vector<uint8_t>& data, std::vector<std::string_view>& paths, size_t& bytesTouched) {
+	auto readU32BE = [&data](size_t pos) {
+		return ((uint32_t)data[pos] << 24) | ((uint32_t)data[pos + 1] << 16) | ((uint32_t)data[pos + 2] << 8) | (uint32_t)data[pos + 3];
+	};
+
+	if (data.size() < 12 || memcmp(data.data(), "FORM", 4) != 0 || memcmp(data.data() + 8, "XOB", 3) != 0) return false;
+
+	size_t end = std::min<size_t>(data.size(), 8 + (size_t)readU32BE(4));
+	bytesTouched = 12;
+
+	for (size_t pos = 12; pos + 8 <= end;) {
+		uint32_t size = readU32BE(pos + 4);
+		size_t dataStart = pos + 8;
+		if (size > end - dataStart) return false;
+		bytesTouched += 8;
+
+		if (memcmp(data.data() + pos, "HEAD", 4) == 0) {
+			for (std::string_view p : PathScanner::Scan(data.data() + dataStart, size)) paths.push_back(p);
+			bytesTouched += size;
+		}
+		pos = dataStart + size;
+	}
+
+	// A model always references at least one material; anything else means
+	// the layout is not what we expect, so let the full scan decide.
+	return !paths.empty();
+}
+
+// Materials, prefabs, configs and layouts are Enfusion text: references are
+// quoted literals such as "{GUID}Assets/Path/Texture_BCR.edds". Only string
+// literals are considered, so names in comments or property keys can't turn
+// into bogus lookups. GUID-prefixed literals (and bare GUIDs) are resource
+// references of any type; plain literals need a known dependency extension.
+bool SmartExtractor::ParseEnfusionText(const std::vector<uint8_t>& data, std::vector<std::string_view>& paths, size_t& bytesTouched) {
+	size_t probe = std::min<size_t>(data.size(), 512);
+	if (std::find(data.begin(), data.begin() + probe, 0) != data.begin() + probe) return false;
+
+	const char* text = reinterpret_cast<const char*>(data.data());
+	for (size_t i = 0; i < data.size(); ++i) {
+		if (text[i] != '"') continue;
+
+		size_t close = i + 1;
+		while (close < data.size() && text[close] != '"' && text[close] != '\n') close++;
+		if (close >= data.size() || text[close] != '"') {
+			i = close;
+			continue;
+		}
+
+		std::string_view literal(text + i + 1, close - i - 1);
+		uint64_t guid;
+		size_t guidLen = GuidIndex::ParseGuid(literal, guid);
+		std::string_view path = literal.substr(guidLen);
+
+		bool isPath = path.find_first_of("/\\") != std::string_view::npos;
+		if (guidLen && path.empty()) {
+			isPath = true;
+		} else if (guidLen) {
+			isPath = isPath && path.find('.') != std::string_view::npos && path.find_first_of(" \t") == std::string_view::npos;
+		} else {
+			isPath = isPath && PathScanner::PathLength(reinterpret_cast<const uint8_t*>(path.data()), path.size()) == path.size();
+		}
+		if (isPath) paths.push_back(literal);
+		i = close;
+	}
+
+	bytesTouched = data.size();
+	return true;
+}
+
+// ============================================================================
+// 📦 TAR EXPORT
+// ============================================================================
+bool TarExporter::Export(PakArchive* arc, HANDLE hOut, const std::string& filter, size_t& skipped) {
+	skipped = 0;
+	if (!arc || hOut == INVALID_HANDLE_VALUE || hOut == NULL) return false;
+
+	std::vector<std::string> patterns;
+	{
+		std::stringstream ss(filter);
+		std::string item;
+		while (std::getline(ss, item, ';')) {
+			if (item.empty()) continue;
+			std::replace(item.begin(), item.end(), '/', '\\');
+			std::transform(item.begin(), item.end(), item.begin(), ::tolower);
+			patterns.push_back(item);
+		}
+	}
+
+	std::vector<const PakEntry*> selected;
+	for (int i = 0; i < arc->GetEntryCount(); ++i) {
+		const PakEntry* entry = arc->GetEntry(i);
+		if (!entry || entry->isDirectory) continue;
+		if (!patterns.empty() && !MatchesFilter(entry->name, patterns)) continue;
+		selected.push_back(entry);
+	}
+
+	LogInfo("[TarExport] " + std::to_string(selected.size()) + " entries selected from " + arc->GetFilename());
+
+	// Reorder window: bounded both by entry count and by inflated bytes in flight,
+	// so memory stays constant regardless of archive size. How many entries are
+	// read at once is tuned to the archive's device while the export runs.
+	const size_t maxWindow = 256;
+	const uint64_t maxBytesInFlight = 256ull * 1024 * 1024;
+	AdaptiveConcurrency reads(2, g_ThreadPool ? g_ThreadPool->size() : 1);
+
+	struct Slot {
+		const PakEntry* entry;
+		std::future<std::vector<uint8_t>> data;
+	};
+	std::deque<Slot> window;
+	uint64_t bytesInFlight = 0;
+	size_t next = 0;
+	bool ok = true;
+
+	auto submit = [&](const PakEntry* entry) {
+		std::future<std::vector<uint8_t>> fut;
+		if (g_ThreadPool) {
+			fut = g_ThreadPool->enqueue([arc, entry, &reads]() {
+				AdaptiveConcurrency::Clock::time_point start = AdaptiveConcurrency::Clock::now();
+				try {
+					std::vector<uint8_t> data = arc->DecompressEntryData(entry);
+					reads.Release(entry->size, AdaptiveConcurrency::Clock::now() - start);
+					return data;
+				} catch (...) {
+					reads.Release();
+					throw;
+				}
+			});
+		} else {
+			std::promise<std::vector<uint8_t>> p;
+			try { p.set_value(arc->DecompressEntryData(entry)); }
+			catch (...) { p.set_exception(std::current_exception()); }
+			fut = p.get_future();
+		}
+		window.push_back({ entry, std::move(fut) });
+		bytesInFlight += entry->originalSize;
+	};
+
+	static const uint8_t zeros[1024] = {};
+
+	while (ok && (next < selected.size() || !window.empty())) {
+		while (next < selected.size() && window.size() < maxWindow &&
+			   (window.empty() || bytesInFlight + selected[next]->originalSize <= maxBytesInFlight)) {
+			if (g_ThreadPool && !reads.TryAcquire()) break;
+			submit(selected[next++]);
+		}
+
+		Slot slot = std::move(window.front());
+		window.pop_front();
+		bytesInFlight -= slot.entry->originalSize;
+
+		std::vector<uint8_t> data;
+		try {
+			data = slot.data.get();
+		} catch (const std::exception& ex) {
+			LogError("[TarExport] Skipping " + slot.entry->name + ": " + ex.what());
+			skipped++;
+			continue;
+		}
+
+		std::string tarName = slot.entry->name;
+		std::replace(tarName.begin(), tarName.end(), '\\', '/');
+
+		if (tarName.size() > 100) {
+			// GNU long name record: the real name travels as the payload of a
+			// "././@LongLink" pseudo-entry preceding the actual header.
+			std::vector<uint8_t> lh = BuildHeader("././@LongLink", tarName.size() + 1, 0, 'L');
+			ok = WriteAll(hOut, lh.data(), lh.size()) &&
+				 WriteAll(hOut, reinterpret_cast<const uint8_t*>(tarName.c_str()), tarName.size() + 1) &&
+				 WriteAll(hOut, zeros, (512 - (tarName.size() + 1) % 512) % 512);
+			if (!ok) break;
+		}
+
+		// One write operation per entry; the header and padding ride along.
+		g_WriteLimiter.Acquire(data.size(), 1);
+
+		std::vector<uint8_t> header = BuildHeader(tarName, data.size(), slot.entry->timestamp, '0');
+		ok = WriteAll(hOut, header.data(), header.size()) &&
+			 WriteAll(hOut, data.data(), data.size()) &&
+			 WriteAll(hOut, zeros, (512 - data.size() % 512) % 512);
+	}
+
+	// Drain anything still in flight so no task outlives the archive handle.
+	for (auto& slot : window) {
+		try { if (slot.data.valid()) slot.data.get(); } catch (...) {}
+	}
+
+	if (ok) ok = WriteAll(hOut, zeros, sizeof(zeros));
+
+	if (!ok) LogError("[TarExport] Output stream closed or write failed.");
+	else if (skipped) LogError("[TarExport] " + std::to_string(skipped) + " entries could not be read and are missing from the tar.");
+	LogInfo("[TarExport] Read concurrency " + reads.Summary());
+	return ok;
+}
+
+bool TarExporter::MatchesFilter(const std::string& name, const std::vector<std::string>& patterns) {
+	std::string norm = name;
+	std::transform(norm.begin(), norm.end(), norm.begin(), ::tolower);
+	for (const auto& p : patterns) {
+		if (WildcardMatch(p.c_str(), norm.c_str())) return true;
+	}
+	return false;
+}
+
+bool TarExporter::WildcardMatch(const char* pattern, const char* text) {
+	const char* star = nullptr;
+	const char* resume = nullptr;
+	while (*text) {
+		if (*pattern == '?' || *pattern == *text) { ++pattern; ++text; }
+		else if (*pattern == '*') { star = pattern++; resume = text; }
+		else if (star) { pattern = star + 1; text = ++resume; }
+		else return false;
+	}
+	while (*pattern == '*') ++pattern;
+	return *pattern == '\0';
+}
+
+std::vector<uint8_t> TarExporter::BuildHeader(const std::string& tarName, uint64_t size, uint32_t mtime, char type) {
+	std::vector<uint8_t> h(512, 0);
+	char* b = reinterpret_cast<char*>(h.data());
+
+	// Names up to 100 bytes go straight into the name field; longer ones are
+	// preceded by a LongLink record and truncated here.
+	std::memcpy(b, tarName.c_str(), std::min<size_t>(tarName.size(), 100));
+
+	snprintf(b + 100, 8, "%07o", 0644);
+	snprintf(b + 108, 8, "%07o", 0);
+	snprintf(b + 116, 8, "%07o", 0);
+	snprintf(b + 124, 12, "%011llo", (unsigned long long)size);
+	snprintf(b + 136, 12, "%011llo", (unsigned long long)mtime);
+	b[156] = type;
+	std::memcpy(b + 257, "ustar", 6);
+	std::memcpy(b + 263, "00", 2);
+
+	std::memset(b + 148, ' ', 8);
+	uint32_t sum = 0;
+	for (uint8_t c : h) sum += c;
+	snprintf(b + 148, 8, "%06o", sum);
+	b[155] = ' ';
+
+	return h;
+}
+
+bool TarExporter::WriteAll(HANDLE hOut, const uint8_t* data, size_t size) {
+	while (size > 0) {
+		DWORD chunk = (DWORD)std::min<size_t>(size, 1 << 20);
+		DWORD written = 0;
+		if (!WriteFile(hOut, data, chunk, &written, NULL) || written == 0) return false;
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+// ============================================================================
+// 🕸️ DEPENDENCY GRAPH
+// ============================================================================
+uint32_t DependencyGraph::Intern(const std::string& path, const std::string& archive) {
+	std::string key = path;
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)PakIndex::FoldChar((unsigned char)c); });
+
+	auto it = m_NodeIds.find(key);
+	if (it != m_NodeIds.end()) return it->second;
+
+	uint32_t id = (uint32_t)m_Nodes.size();
+	m_Nodes.push_back({ path, archive });
+	m_NodeIds.emplace(std::move(key), id);
+	return id;
+}
+
+void DependencyGraph::Update(const std::vector<PakArchive*>& archives) {
+	auto t0 = std::chrono::steady_clock::now();
+	GuidIndex::Prepare();
+	GameCatalog::Prepare();
+
+	// A reference may resolve into any archive of the set, so when one archive
+	// changes, joins or leaves, edges of the others can change too (a path
+	// now overridden, a target gone). Every archive is then resolved again;
+	// unchanged ones come from the dependency cache without inflating.
+	std::vector<std::pair<PakArchive*, std::string>> scan;
+	size_t changed = 0;
+	for (PakArchive* arc : archives) {
+		std::string fingerprint = DependencyCache::Fingerprint(arc->GetFilename());
+		auto it = m_Archives.find(arc->GetFilename());
+		if (it == m_Archives.end() || it->second.fingerprint != fingerprint) changed++;
+		scan.push_back({ arc, std::move(fingerprint) });
+	}
+	if (changed == 0 && scan.size() == m_Archives.size()) {
+		LogInfo("[DepGraph] " + std::to_string(archives.size()) + " archives unchanged");
+		return;
+	}
+	m_Archives.clear();
+	m_Nodes.clear();
+	m_NodeIds.clear();
+
+	// One parallel pass over the entries of every archive.
+	struct Edge {
+		int from;
+		PakArchive* owner;
+		int to;
+	};
+	struct Range {
+		size_t archive;
+		int begin;
+		int end;
+	};
+
+	const int RANGE_SIZE = 512;
+	std::vector<Range> ranges;
+	for (size_t a = 0; a < scan.size(); ++a) {
+		int count = scan[a].first->GetEntryCount();
+		for (int begin = 0; begin < count; begin += RANGE_SIZE) ranges.push_back({ a, begin, std::min(count, begin + RANGE_SIZE) });
+	}
+
+	auto scanRange = [&scan](Range r) {
+		PakArchive* arc = scan[r.archive].first;
+		std::vector<Edge> out;
+		for (int i = r.begin; i < r.end; ++i) {
+			std::vector<std::string> refs;
+			std::vector<uint8_t> data;
+			try {
+				if (!SmartExtractor::CollectReferences(arc, i, refs, data)) continue;
+			}
+			catch (...) {
+				continue;
+			}
+			for (const auto& ref : refs) {
+				PakArchive* owner = nullptr;
+				int to = -1;
+				if (SmartExtractor::ResolveReference(arc, ref, owner, to)) out.push_back({ i, owner, to });
+			}
+		}
+		return out;
+	};
+
+	std::vector<std::vector<Edge>> results(ranges.size());
+	auto scanAt = [&](size_t k) { results[k] = scanRange(ranges[k]); };
+	// Isolated: runs under g_DependencyGraphMutex.
+	if (g_ThreadPool) g_ThreadPool->parallel_for_isolated(ranges.size(), scanAt);
+	else for (size_t k = 0; k < ranges.size(); ++k) scanAt(k);
+
+	for (auto& [arc, fingerprint] : scan) m_Archives[arc->GetFilename()] = { fingerprint, {} };
+	for (size_t k = 0; k < ranges.size(); ++k) {
+		PakArchive* arc = scan[ranges[k].archive].first;
+		auto& edges = m_Archives[arc->GetFilename()].edges;
+		for (const Edge& e : results[k]) {
+			uint32_t from = Intern(arc->GetEntry(e.from)->name, arc->GetFilename());
+			uint32_t to = Intern(e.owner->GetEntry(e.to)->name, e.owner->GetFilename());
+			if (from != to) edges.push_back({ from, to });
+		}
+	}
+
+	Link();
+	DependencyCache::Flush();
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+	LogInfo("[DepGraph] " + std::to_string(changed) + " of " + std::to_string(archives.size()) + " archives changed, " +
+			std::to_string(m_Nodes.size()) + " nodes, " + std::to_string(m_Fwd.size()) + " edges in " + std::to_string(ms) + " ms");
+}
+
+void DependencyGraph::Link() {
+	std::vector<std::pair<uint32_t, uint32_t>> all;
+	for (const auto& [name, archive] : m_Archives) all.insert(all.end(), archive.edges.begin(), archive.edges.end());
+	std::sort(all.begin(), all.end());
+	all.erase(std::unique(all.begin(), all.end()), all.end());
+
+	auto build = [this, &all](std::vector<uint32_t>& starts, std::vector<uint32_t>& adjacency, bool reverse) {
+		starts.assign(m_Nodes.size() + 1, 0);
+		adjacency.resize(all.size());
+		for (const auto& [from, to] : all) starts[(reverse ? to : from) + 1]++;
+		for (size_t i = 1; i < starts.size(); ++i) starts[i] += starts[i - 1];
+
+		std::vector<uint32_t> fill(starts.begin(), starts.end() - 1);
+		for (const auto& [from, to] : all) adjacency[fill[reverse ? to : from]++] = reverse ? from : to;
+	};
+	build(m_FwdStart, m_Fwd, false);
+	build(m_RevStart, m_Rev, true);
+}
+
+std::vector<uint32_t> DependencyGraph::Walk(std::string_view path, bool transitive, const std::vector<uint32_t>& starts,
+											const std::vector<uint32_t>& adjacency) const {
+	std::string key(path);
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)PakIndex::FoldChar((unsigned char)c); });
+	auto it = m_NodeIds.find(key);
+	if (it == m_NodeIds.end()) return {};
+
+	std::vector<uint32_t> result;
+	std::vector<uint8_t> seen(m_Nodes.size(), 0);
+	std::vector<uint32_t> queue = { it->second };
+	seen[it->second] = 1;
+
+	for (size_t q = 0; q < queue.size(); ++q) {
+		uint32_t node = queue[q];
+		for (uint32_t k = starts[node]; k < starts[node + 1]; ++k) {
+			uint32_t next = adjacency[k];
+			if (seen[next]) continue;
+			seen[next] = 1;
+			result.push_back(next);
+			if (transitive) queue.push_back(next);
+		}
+	}
+	std::sort(result.begin(), result.end(), [this](uint32_t a, uint32_t b) { return m_Nodes[a].path < m_Nodes[b].path; });
+	return result;
+}
+
+std::vector<uint32_t> DependencyGraph::Users(std::string_view path, bool transitive) const {
+	return Walk(path, transitive, m_RevStart, m_Rev);
+}
+
+std::vector<uint32_t> DependencyGraph::Uses(std::string_view path, bool transitive) const {
+	return Walk(path, transitive, m_FwdStart, m_Fwd);
+}
+
+static std::string JsonEscape(const std::string& s) {
+	std::string out;
+	out.reserve(s.size() + 2);
+	for (char c : s) {
+		if (c == '"' || c == '\\') out += '\\';
+		if ((unsigned char)c < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+			out += buf;
+			continue;
+		}
+		out += c;
+	}
+	return out;
+}
+
+bool DependencyGraph::WriteJson(const std::wstring& file) const {
+	std::ofstream out(fs::path(file), std::ios::binary | std::ios::trunc);
+	if (!out) return false;
+
+	out << "{\n  \"nodes\": [";
+	for (size_t i = 0; i < m_Nodes.size(); ++i) {
+		out << (i ? ",\n    " : "\n    ") << "{\"path\": \"" << JsonEscape(m_Nodes[i].path) << "\", \"archive\": \""
+			<< JsonEscape(m_Nodes[i].archive) << "\"}";
+	}
+	out << "\n  ],\n  \"edges\": [";
+	bool first = true;
+	for (uint32_t from = 0; from < (uint32_t)m_Nodes.size(); ++from) {
+		for (uint32_t k = m_FwdStart[from]; k < m_FwdStart[from + 1]; ++k) {
+			out << (first ? "\n    " : ",\n    ") << "[" << from << ", " << m_Fwd[k] << "]";
+			first = false;
+		}
+	}
+	out << "\n  ]\n}\n";
+	return out.good();
+}
+
+// "PAKDEPG1", u32 archive/node/edge counts, the archive names, every node as
+// (u32 archive, u16 length, path) and the forward adjacency in CSR form.
+bool DependencyGraph::WriteBinary(const std::wstring& file) const {
+	std::vector<std::string> archives;
+	std::unordered_map<std::string, uint32_t> archiveIds;
+	for (const Node& n : m_Nodes) {
+		if (archiveIds.emplace(n.archive, (uint32_t)archives.size()).second) archives.push_back(n.archive);
+	}
+
+	std::string buf("PAKDEPG1", 8);
+	auto put = [&buf](const void* src, size_t n) { buf.append(static_cast<const char*>(src), n); };
+	auto putString = [&put](const std::string& s) {
+		uint16_t len = (uint16_t)std::min<size_t>(s.size(), 0xFFFF);
+		put(&len, 2);
+		put(s.data(), len);
+	};
+
+	uint32_t counts[3] = { (uint32_t)archives.size(), (uint32_t)m_Nodes.size(), (uint32_t)m_Fwd.size() };
+	put(counts, sizeof(counts));
+	for (const auto& a : archives) putString(a);
+	for (const Node& n : m_Nodes) {
+		uint32_t archive = archiveIds[n.archive];
+		put(&archive, 4);
+		putString(n.path);
+	}
+	put(m_FwdStart.data(), m_FwdStart.size() * sizeof(uint32_t));
+	put(m_Fwd.data(), m_Fwd.size() * sizeof(uint32_t));
+
+	std::ofstream out(fs::path(file), std::ios::binary | std::ios::trunc);
+	return out && out.write(buf.data(), buf.size()).good();
+}
+
+// The graph is kept for the whole session, so repeated queries only rescan
+// archives that changed in between.
+static DependencyGraph g_DependencyGraph;
+static std::mutex g_DependencyGraphMutex;
+
+static bool UpdateDependencyGraph(const WCHAR* ArcNames) {
+	std::vector<std::unique_ptr<PakArchive>> opened;
+	std::vector<PakArchive*> archives;
+
+	std::stringstream ss(WCharToUTF8(ArcNames));
+	std::string name;
+	while (std::getline(ss, name, ';')) {
+		if (name.empty()) continue;
+		auto arc = std::make_unique<PakArchive>(name);
+		if (!arc->IsInitialized()) {
+			LogError("[DepGraph] Cannot open archive: " + name);
+			return false;
+		}
+		archives.push_back(arc.get());
+		opened.push_back(std::move(arc));
+	}
+	if (archives.empty()) return false;
+
+	g_DependencyGraph.Update(archives);
+	return true;
+}
+
+// Builds the dependency graph of the ';'-separated archives and writes it to
+// OutFile: JSON, or the compact binary form when the name ends in ".bin".
+extern "C" __declspec(dllexport) int __stdcall ExportDependencyGraphW(const WCHAR* ArcNames, const WCHAR* OutFile) {
+	if (!ArcNames || !OutFile) return E_BAD_ARCHIVE;
+
+	try {
+		std::lock_guard<std::mutex> lock(g_DependencyGraphMutex);
+		if (!UpdateDependencyGraph(ArcNames)) return E_EOPEN;
+
+		std::wstring file(OutFile);
+		bool binary = file.size() > 4 && _wcsicmp(file.c_str() + file.size() - 4, L".bin") == 0;
+		bool ok = binary ? g_DependencyGraph.WriteBinary(file) : g_DependencyGraph.WriteJson(file);
+		return ok ? 0 : E_ECREATE;
+	}
+	catch (const std::exception& ex) {
+		LogError("[ExportDependencyGraphW] EXCEPTION: " + std::string(ex.what()));
+		return E_EWRITE;
+	}
+}
+
+// Writes the entries that use Asset, one "archive|path" per line, to hOut
+// (stdout when NULL). Transitive also lists users of users.
+extern "C" __declspec(dllexport) int __stdcall FindAssetUsersW(const WCHAR* ArcNames, const WCHAR* Asset, BOOL Transitive, HANDLE hOut) {
+	if (!ArcNames || !Asset) return E_BAD_ARCHIVE;
+	if (!hOut) hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	try {
+		std::lock_guard<std::mutex> lock(g_DependencyGraphMutex);
+		if (!UpdateDependencyGraph(ArcNames)) return E_EOPEN;
+
+		std::string text;
+		for (uint32_t id : g_DependencyGraph.Users(WCharToUTF8(Asset), Transitive != FALSE)) {
+			const auto& node = g_DependencyGraph.NodeAt(id);
+			text += node.archive + "|" + node.path + "\r\n";
+		}
+
+		DWORD written = 0;
+		if (!text.empty() && !WriteFile(hOut, text.data(), (DWORD)text.size(), &written, NULL)) return E_EWRITE;
+		return 0;
+	}
+	catch (const std::exception& ex) {
+		LogError("[FindAssetUsersW] EXCEPTION: " + std::string(ex.what()));
+		return E_EWRITE;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include "ThreadPool.h"
+
+class PakArchive;
+
+// Persistent trigram index over the text-like entries of an archive
+// (scripts, configs, prefabs, layouts...). For every three-byte sequence of
+// the inflated text, with ASCII letters folded, it lists the entries that
+// contain it. A search takes the trigrams of its pattern and intersects
+// their lists, so only the few candidate entries have to be inflated and
+// verified. Like DependencyCache, the index is stored next to the plugin
+// under the archive's fingerprint and built on the first indexed search.
+// Only entries classified as text or script (see ContentType.h) are
+// covered; the index cannot rule out the rest, so they always come back as
+// candidates and the caller's type filter decides whether they are read.
+class ContentIndex {
+public:
+    // Candidate entries for a pattern, ascending. Builds (and saves) the
+    // index when the archive has none; false if that was cancelled.
+    static bool Candidates(PakArchive* arc, std::wstring_view pattern, std::vector<int>& entries,
+                           const CancellationToken& cancel = CancellationToken());
+    static void Shutdown();
+
+private:
+    struct Table {
+        uint32_t entryCount = 0;
+        uint64_t corpusBytes = 0;
+        std::vector<uint32_t> covered;
+        std::vector<uint32_t> trigrams;   // sorted
+        std::vector<uint32_t> offsets;    // into postings, trigrams.size() + 1
+        std::string postings;             // per trigram: varint deltas of entry + 1
+    };
+
+    // Bumped whenever the indexed content or the file layout changes.
+    static constexpr uint32_t VERSION = 2;
+
+    static std::shared_ptr<const Table> Build(PakArchive* arc, const CancellationToken& cancel);
+    static std::shared_ptr<const Table> Load(const std::string& file, uint32_t entryCount);
+    static bool Save(const Table& table, const std::string& file);
+    static size_t Find(const Table& table, uint32_t trigram);
+    static std::vector<uint32_t> Postings(const Table& table, size_t slot);
+
+    static std::mutex s_Mutex;
+    // One build at a time; each runs on the whole pool, isolated, so it
+    // never picks up a task that could be waiting for this lock.
+    static std::mutex s_BuildMutex;
+    static std::unordered_map<std::string, std::shared_ptr<const Table>> s_Tables;
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#define CONTENTMATCHER_SIMD 1
+#endif
+
+// Literal search for a text pattern in raw entry data, looking for its UTF-8
+// and its UTF-16LE encoding in the same pass. Case-insensitive matching folds
+// ASCII letters; other characters have to match exactly. Candidates are found
+// with a vectorised two-byte filter per encoding (first byte and last non-zero
+// byte, letters folded with | 0x20) and verified in place, as in PathScanner.
+class ContentMatcher {
+public:
+    ContentMatcher(std::wstring_view pattern, bool caseSensitive) {
+        std::vector<uint32_t> chars = Decode(pattern);
+        if (chars.empty()) return;
+
+        Needle& utf8 = m_Needles[m_Count++];
+        Needle& utf16 = m_Needles[m_Count++];
+        for (uint32_t c : chars) {
+            bool fold = !caseSensitive && ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+            EncodeUtf8(c, fold, utf8);
+            EncodeUtf16(c, fold, utf16);
+        }
+        for (size_t i = 0; i < m_Count; ++i) {
+            Needle& n = m_Needles[i];
+            n.anchor = n.bytes.size() - 1;
+            while (n.anchor > 0 && n.bytes[n.anchor] == 0) n.anchor--;
+            m_Span = std::max(m_Span, n.anchor);
+        }
+    }
+
+    bool Empty() const { return m_Count == 0; }
+
+    // Offset of the first match at or after `from`, or `size` when there is
+    // none; `length` receives the byte length of the encoding that matched.
+    size_t Find(const uint8_t* data, size_t size, size_t from = 0, size_t* length = nullptr) const {
+        if (Empty() || from >= size) return size;
+#ifdef CONTENTMATCHER_SIMD
+        return UseAvx2() ? FindAvx2(data, size, from, length) : FindSse2(data, size, from, length);
+#else
+        return FindScalar(data, size, from, length);
+#endif
+    }
+
+    bool Contains(const uint8_t* data, size_t size) const { return Find(data, size) < size; }
+
+private:
+    struct Needle {
+        std::vector<uint8_t> bytes;   // letters lowercased where folded
+        std::vector<uint8_t> fold;    // 0x20 for folded letters, else 0
+        size_t anchor = 0;
+    };
+
+    static std::vector<uint32_t> Decode(std::wstring_view text) {
+        std::vector<uint32_t> chars;
+        for (size_t i = 0; i < text.size(); ++i) {
+            uint32_t c = (uint32_t)text[i];
+            if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < text.size()) {
+                uint32_t low = (uint32_t)text[i + 1];
+                if (low >= 0xDC00 && low < 0xE000) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i++;
+                }
+            }
+            chars.push_back(c);
+        }
+        return chars;
+    }
+
+    static void Push(Needle& n, uint32_t byte, bool fold) {
+        n.bytes.push_back((uint8_t)(fold ? (byte | 0x20) : byte));
+        n.fold.push_back(fold ? 0x20 : 0);
+    }
+
+    static void EncodeUtf8(uint32_t c, bool fold, Needle& n) {
+        if (c < 0x80) {
+            Push(n, c, fold);
+        } else if (c < 0x800) {
+            Push(n, 0xC0 | (c >> 6), false);
+            Push(n, 0x80 | (c & 0x3F), false);
+        } else if (c < 0x10000) {
+            Push(n, 0xE0 | (c >> 12), false);
+            Push(n, 0x80 | ((c >> 6) & 0x3F), false);
+            Push(n, 0x80 | (c & 0x3F), false);
+        } else {
+            Push(n, 0xF0 | (c >> 18), false);
+            Push(n, 0x80 | ((c >> 12) & 0x3F), false);
+            Push(n, 0x80 | ((c >> 6) & 0x3F), false);
+            Push(n, 0x80 | (c & 0x3F), false);
+        }
+    }
+
+    static void EncodeUtf16(uint32_t c, bool fold, Needle& n) {
+        if (c >= 0x10000) {
+            c -= 0x10000;
+            EncodeUtf16(0xD800 + (c >> 10), false, n);
+            EncodeUtf16(0xDC00 + (c & 0x3FF), false, n);
+            return;
+        }
+        Push(n, c & 0xFF, fold);
+        Push(n, c >> 8, false);
+    }
+
+    static bool Equals(const Needle& n, const uint8_t* p) {
+        for (size_t i = 0; i < n.bytes.size(); ++i) {
+            if ((p[i] | n.fold[i]) != n.bytes[i]) return false;
+        }
+        return true;
+    }
+
+    // Byte length of the first needle found at p, or 0.
+    size_t MatchAt(const uint8_t* data, size_t size, size_t p) const {
+        for (size_t i = 0; i < m_Count; ++i) {
+            const Needle& n = m_Needles[i];
+            if (p + n.bytes.size() <= size && Equals(n, data + p)) return n.bytes.size();
+        }
+        return 0;
+    }
+
+    size_t FindScalar(const uint8_t* data, size_t size, size_t pos, size_t* length) const {
+        for (; pos < size; ++pos) {
+            if (size_t len = MatchAt(data, size, pos)) {
+                if (length) *length = len;
+                return pos;
+            }
+        }
+        return size;
+    }
+
+#ifdef CONTENTMATCHER_SIMD
+    static bool UseAvx2() {
+        static const bool avx2 = [] {
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+        }();
+        return avx2;
+    }
+
+    // Verifies the candidate bits of one block in order; the first hit wins.
+    size_t Verify(const uint8_t* data, size_t size, size_t pos, unsigned mask, size_t* length) const {
+        for (; mask; mask &= mask - 1) {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (size_t len = MatchAt(data, size, pos + bit)) {
+                if (length) *length = len;
+                return pos + bit;
+            }
+        }
+        return size;
+    }
+
+    size_t FindSse2(const uint8_t* data, size_t size, size_t pos, size_t* length) const {
+        __m128i first[2], firstFold[2], last[2], lastFold[2];
+        for (size_t i = 0; i < m_Count; ++i) {
+            const Needle& n = m_Needles[i];
+            first[i] = _mm_set1_epi8((char)n.bytes[0]);
+            firstFold[i] = _mm_set1_epi8((char)n.fold[0]);
+            last[i] = _mm_set1_epi8((char)n.bytes[n.anchor]);
+            lastFold[i] = _mm_set1_epi8((char)n.fold[n.anchor]);
+        }
+        for (; pos + m_Span + 16 <= size; pos += 16) {
+            unsigned mask = 0;
+            for (size_t i = 0; i < m_Count; ++i) {
+                __m128i a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), firstFold[i]);
+                __m128i b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + m_Needles[i].anchor)), lastFold[i]);
+                mask |= (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first[i]), _mm_cmpeq_epi8(b, last[i])));
+            }
+            if (mask) {
+                size_t hit = Verify(data, size, pos, mask, length);
+                if (hit < size) return hit;
+            }
+        }
+        return FindScalar(data, size, pos, length);
+    }
+
+    size_t FindAvx2(const uint8_t* data, size_t size, size_t pos, size_t* length) const {
+        __m256i first[2], firstFold[2], last[2], lastFold[2];
+        for (size_t i = 0; i < m_Count; ++i) {
+            const Needle& n = m_Needles[i];
+            first[i] = _mm256_set1_epi8((char)n.bytes[0]);
+            firstFold[i] = _mm256_set1_epi8((char)n.fold[0]);
+            last[i] = _mm256_set1_epi8((char)n.bytes[n.anchor]);
+            lastFold[i] = _mm256_set1_epi8((char)n.fold[n.anchor]);
+        }
+        for (; pos + m_Span + 32 <= size; pos += 32) {
+            unsigned mask = 0;
+            for (size_t i = 0; i < m_Count; ++i) {
+                __m256i a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)), firstFold[i]);
+                __m256i b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + m_Needles[i].anchor)), lastFold[i]);
+                mask |= (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first[i]), _mm256_cmpeq_epi8(b, last[i])));
+            }
+            if (mask) {
+                size_t hit = Verify(data, size, pos, mask, length);
+                if (hit < size) return hit;
+            }
+        }
+        return FindSse2(data, size, pos, length);
+    }
+#endif
+
+    Needle m_Needles[2];
+    size_t m_Count = 0;
+    size_t m_Span = 0;
+};
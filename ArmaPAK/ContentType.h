@@ -0,0 +1,133 @@
+#pragma once
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// What an entry holds, as far as searching and scanning care. Kept as one
+// byte per entry, so a search can drop textures, meshes and sounds before
+// anything is read or inflated.
+enum class ContentType : uint8_t {
+    Unknown,   // extension says nothing and not sniffed (yet)
+    Text,      // configs, prefabs, layouts, materials, metadata
+    Script,    // Enforce script
+    Texture,
+    Model,
+    Audio,
+    Binary,    // any other binary data
+    Count
+};
+
+class ContentClassifier {
+public:
+    static constexpr uint32_t Bit(ContentType type) { return 1u << (uint32_t)type; }
+    static constexpr uint32_t ALL = (1u << (uint32_t)ContentType::Count) - 1;
+    static constexpr uint32_t TEXTUAL = (1u << (uint32_t)ContentType::Text) | (1u << (uint32_t)ContentType::Script);
+
+    // Bytes of inflated data Sniff wants to see.
+    static constexpr size_t SNIFF_BYTES = 512;
+
+    static const char* Name(ContentType type) {
+        static const char* const names[] = { "unknown", "text", "script", "texture", "model", "audio", "binary" };
+        return type < ContentType::Count ? names[(size_t)type] : "unknown";
+    }
+
+    // Type names separated by ',', ';' or spaces ("text, script") as a mask
+    // of Bit()s; 0 for an empty list or unknown names only.
+    static uint32_t ParseMask(std::string_view list) {
+        uint32_t mask = 0;
+        while (!list.empty()) {
+            size_t end = list.find_first_of(",; ");
+            std::string_view word = list.substr(0, end);
+            for (uint32_t t = 0; t < (uint32_t)ContentType::Count; ++t) {
+                if (EqualsFolded(word, Name((ContentType)t))) mask |= 1u << t;
+            }
+            list = end == std::string_view::npos ? std::string_view() : list.substr(end + 1);
+        }
+        return mask;
+    }
+
+    static ContentType FromExtension(std::string_view name) {
+        struct Rule {
+            const char* ext;
+            ContentType type;
+        };
+        static constexpr Rule rules[] = {
+            { ".c", ContentType::Script },
+            { ".et", ContentType::Text }, { ".ent", ContentType::Text }, { ".layer", ContentType::Text },
+            { ".conf", ContentType::Text }, { ".layout", ContentType::Text }, { ".styles", ContentType::Text },
+            { ".imageset", ContentType::Text }, { ".emat", ContentType::Text }, { ".gamemat", ContentType::Text },
+            { ".physmat", ContentType::Text }, { ".meta", ContentType::Text }, { ".st", ContentType::Text },
+            { ".gproj", ContentType::Text }, { ".txt", ContentType::Text }, { ".json", ContentType::Text },
+            { ".xml", ContentType::Text }, { ".csv", ContentType::Text }, { ".ini", ContentType::Text },
+            { ".cfg", ContentType::Text }, { ".hlsl", ContentType::Text }, { ".fx", ContentType::Text },
+            { ".edds", ContentType::Texture }, { ".dds", ContentType::Texture }, { ".png", ContentType::Texture },
+            { ".tga", ContentType::Texture }, { ".jpg", ContentType::Texture }, { ".tif", ContentType::Texture },
+            { ".paa", ContentType::Texture },
+            { ".xob", ContentType::Model }, { ".fbx", ContentType::Model }, { ".p3d", ContentType::Model },
+            { ".wav", ContentType::Audio }, { ".ogg", ContentType::Audio }, { ".wem", ContentType::Audio },
+            { ".bnk", ContentType::Audio }, { ".mp3", ContentType::Audio }, { ".flac", ContentType::Audio },
+            { ".anm", ContentType::Binary }, { ".ttf", ContentType::Binary }, { ".otf", ContentType::Binary },
+            { ".nmn", ContentType::Binary }, { ".bin", ContentType::Binary }, { ".pak", ContentType::Binary },
+            { ".ragdoll", ContentType::Binary },
+        };
+
+        size_t dot = name.find_last_of("./\\");
+        if (dot == std::string_view::npos || name[dot] != '.') return ContentType::Unknown;
+        std::string_view ext = name.substr(dot);
+        for (const Rule& rule : rules) {
+            if (EqualsFolded(ext, rule.ext)) return rule.type;
+        }
+        return ContentType::Unknown;
+    }
+
+    // Classifies the first inflated bytes of an entry: known magic numbers
+    // first, then the byte mix. Text has no NUL bytes and almost nothing
+    // outside printable ASCII, whitespace and well-formed UTF-8; compressed
+    // or packed data has plenty of both.
+    static ContentType Sniff(const uint8_t* data, size_t size) {
+        auto magic = [&](size_t at, const char* sig) {
+            size_t n = strlen(sig);
+            return size >= at + n && memcmp(data + at, sig, n) == 0;
+        };
+        if (size == 0) return ContentType::Unknown;
+        if (magic(0, "DDS ") || magic(0, "\x89PNG") || magic(0, "\xFF\xD8\xFF")) return ContentType::Texture;
+        if (magic(0, "FORM") && magic(8, "XOB")) return ContentType::Model;
+        if ((magic(0, "RIFF") && magic(8, "WAVE")) || magic(0, "OggS") || magic(0, "fLaC") || magic(0, "ID3") || magic(0, "BKHD"))
+            return ContentType::Audio;
+        if (magic(0, "FORM")) return ContentType::Binary;
+        if (magic(0, "\xEF\xBB\xBF") || magic(0, "\xFF\xFE") || magic(0, "\xFE\xFF")) return ContentType::Text;
+
+        size_t odd = 0;
+        for (size_t i = 0; i < size;) {
+            uint8_t c = data[i];
+            if (c == 0) return ContentType::Binary;
+            if (c >= 0x80) {
+                size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+                bool valid = len > 0;
+                for (size_t k = 1; valid && k < len; ++k) {
+                    // A sequence cut off by the end of the sample counts as valid.
+                    valid = i + k >= size || (data[i + k] & 0xC0) == 0x80;
+                }
+                if (!valid) {
+                    odd++;
+                    len = 1;
+                }
+                i += len;
+                continue;
+            }
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f') odd++;
+            i++;
+        }
+        return odd * 32 <= size ? ContentType::Text : ContentType::Binary;
+    }
+
+private:
+    static bool EqualsFolded(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            if (x >= 'A' && x <= 'Z') x += 32;
+            if (y >= 'A' && y <= 'Z') y += 32;
+            return x == y;
+        });
+    }
+};
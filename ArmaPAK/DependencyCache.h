@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+class PakArchive;
+
+// Persistent per-archive cache of the dependency paths SmartExtractor found
+// in each scanned entry. An archive's contents never change while its
+// fingerprint (path, size, mtime) stays the same, so a warm run can walk a
+// model's whole dependency closure without inflating anything.
+class DependencyCache {
+public:
+    static bool Lookup(PakArchive* arc, int index, std::vector<std::string>& deps);
+    static void Store(PakArchive* arc, int index, const std::vector<std::string>& deps);
+    static void Flush();
+    static void Shutdown();
+
+    // Identifies one version of an archive file: path hash, size and mtime.
+    static std::string Fingerprint(const std::string& archivePath);
+
+private:
+    struct ArchiveCache {
+        std::mutex mutex;
+        std::string file;
+        bool loaded = false;
+        bool dirty = false;
+        std::unordered_map<uint32_t, std::vector<std::string>> deps;
+    };
+
+    // Bumped whenever the dependency scanner changes what it reports.
+    static constexpr uint32_t VERSION = 4;
+
+    static ArchiveCache& For(PakArchive* arc);
+    static void Load(ArchiveCache& cache);
+    static bool Save(ArchiveCache& cache);
+
+    static std::mutex s_Mutex;
+    static std::unordered_map<std::string, std::unique_ptr<ArchiveCache>> s_Caches;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class PakArchive;
+
+// Forward and reverse dependency edges between the models, materials,
+// textures and prefabs of a set of archives. Nodes are folded entry paths,
+// so an asset is one node no matter which archive provides it.
+//
+// Edges are kept per archive together with the archive's fingerprint, so
+// Update() does nothing while the set of archives is unchanged. Otherwise
+// every archive is resolved again, since a change in one can redirect the
+// references of the others; only changed archives are inflated, the rest
+// are answered from the dependency cache.
+class DependencyGraph {
+public:
+    struct Node {
+        std::string path;
+        std::string archive;
+    };
+
+    // Rebuilds the edges when any archive changed, joined or left the set,
+    // in parallel on the thread pool.
+    void Update(const std::vector<PakArchive*>& archives);
+
+    // Entries that reference path directly, or through any chain when transitive.
+    std::vector<uint32_t> Users(std::string_view path, bool transitive) const;
+    std::vector<uint32_t> Uses(std::string_view path, bool transitive) const;
+    const Node& NodeAt(uint32_t id) const { return m_Nodes[id]; }
+
+    bool WriteJson(const std::wstring& file) const;
+    bool WriteBinary(const std::wstring& file) const;
+
+private:
+    struct ArchiveEdges {
+        std::string fingerprint;
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+    };
+
+    uint32_t Intern(const std::string& path, const std::string& archive);
+    std::vector<uint32_t> Walk(std::string_view path, bool transitive, const std::vector<uint32_t>& starts,
+                               const std::vector<uint32_t>& adjacency) const;
+    void Link();
+
+    std::vector<Node> m_Nodes;
+    std::unordered_map<std::string, uint32_t> m_NodeIds;
+    std::unordered_map<std::string, ArchiveEdges> m_Archives;
+
+    // Compressed adjacency lists, rebuilt from m_Archives after every update.
+    std::vector<uint32_t> m_FwdStart, m_Fwd;
+    std::vector<uint32_t> m_RevStart, m_Rev;
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+#include "pak_index.h"
+
+class PakArchive;
+
+// Persistent catalog of every entry in the configured PAK directories
+// (CatalogDirs in pak_plugin.ini), so dependencies can be resolved in
+// archives TC never opened. The catalog file is memory mapped and queried in
+// place; archives are only opened when one of their entries is extracted.
+class GameCatalog {
+public:
+    struct Hit {
+        PakArchive* archive = nullptr;
+        int index = -1;
+    };
+
+    // Never blocks on a refresh running on another thread; a walk calls
+    // Prepare first, so the catalog is loaded before its tasks start.
+    static Hit Resolve(std::string_view path, std::string_view prefix = {});
+    static void Prepare();
+    static void Invalidate();
+    static void Shutdown();
+
+private:
+#pragma pack(push, 1)
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t archiveCount;
+        uint32_t entryCount;
+        uint32_t slotCount;
+        uint64_t stringsSize;
+    };
+
+    struct ArchiveRecord {
+        uint64_t mtime;
+        uint64_t size;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t firstEntry;
+        uint32_t entryCount;
+    };
+
+    struct EntryRecord {
+        uint64_t hash;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t archive;
+        uint32_t entryIndex;
+    };
+#pragma pack(pop)
+
+    // A mapped catalog file; all pointers refer into the view. Every refresh
+    // writes a new generation (pak_catalog.<n>.bin) instead of replacing the
+    // file, since a file with a mapped view cannot be replaced.
+    struct Mapping {
+        HANDLE hFile = INVALID_HANDLE_VALUE;
+        HANDLE hMap = NULL;
+        const uint8_t* view = nullptr;
+        const FileHeader* header = nullptr;
+        const ArchiveRecord* archives = nullptr;
+        const EntryRecord* entries = nullptr;
+        const uint32_t* slots = nullptr;
+        const char* strings = nullptr;
+        PathBloom filter;
+        std::wstring file;
+        // Set once a newer generation is published; the file is deleted
+        // when the last reference goes.
+        mutable std::atomic<bool> superseded{ false };
+
+        ~Mapping();
+        std::string_view String(uint32_t offset, uint32_t length) const { return std::string_view(strings + offset, length); }
+    };
+
+    struct ScannedArchive {
+        std::string path;
+        uint64_t mtime = 0;
+        uint64_t size = 0;
+        std::vector<std::pair<std::string, uint32_t>> entries;
+    };
+
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+    static constexpr uint32_t VERSION = 1;
+
+    static std::shared_ptr<const Mapping> Current(bool wait);
+    static std::shared_ptr<const Mapping> Load(const std::wstring& file);
+    static bool Refresh(std::shared_ptr<const Mapping> old);
+    static bool Write(const std::wstring& file, const std::vector<ScannedArchive>& archives);
+    // A lazily opened archive with the catalog's size and mtime for it.
+    struct Opened {
+        uint64_t size = 0;
+        uint64_t mtime = 0;
+        std::shared_future<std::shared_ptr<PakArchive>> archive;
+    };
+
+    static PakArchive* OpenLazily(const std::string& path, uint64_t size, uint64_t mtime);
+    static bool Stat(const std::string& path, uint64_t& size, uint64_t& mtime);
+    static void Retire(const Opened& opened);
+
+    static std::mutex s_WriterMutex;
+    static std::atomic<std::shared_ptr<const Mapping>> s_Current;
+    static std::atomic<bool> s_Checked;
+    // Lazily opened archives by path; a slot is inserted before the archive
+    // is opened, so every archive is opened once. Retired archives (changed
+    // on disk) are closed but kept until Shutdown.
+    static std::mutex s_OpenMutex;
+    static std::unordered_map<std::string, Opened> s_Opened;
+    static std::vector<std::shared_future<std::shared_ptr<PakArchive>>> s_Retired;
+};
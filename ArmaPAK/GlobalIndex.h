@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "pak_index.h"
+
+class PakArchive;
+
+// Game-wide path -> (archive, entry) index over every opened archive.
+//
+// Published as an immutable snapshot: readers resolve a path with a single
+// probe, writers copy the current snapshot, apply one archive open/close and
+// swap it in. When several archives provide the same path the overlay rules
+// mirror the game's load order: base game data < workshop addons < anything
+// else, and within a layer the later opened archive wins.
+class GlobalIndex {
+public:
+    enum class Layer : int {
+        Game = 0,
+        Addon = 1,
+        Loose = 2
+    };
+
+    struct Hit {
+        PakArchive* archive = nullptr;
+        int index = -1;
+    };
+
+    static void OnArchiveOpened(PakArchive* arc);
+    static void OnArchiveClosed(PakArchive* arc);
+    static Hit Resolve(std::string_view path, std::string_view prefix = {});
+    // Nearest entry by file name and folders (PakIndex::FindNearest) that
+    // scores below bestScore; bestScore is lowered to the hit's score.
+    static Hit ResolveNearest(std::string_view path, int& bestScore);
+    static Layer ClassifyArchive(const std::string& filename);
+
+private:
+    struct Source {
+        PakArchive* archive;
+        std::shared_ptr<const PakIndex> index;
+        Layer layer;
+        uint64_t order;
+    };
+
+    struct Slot {
+        uint32_t hash;
+        uint32_t entry;
+        uint32_t source;
+    };
+
+    struct Snapshot {
+        std::vector<Source> sources;
+        std::vector<Slot> slots;
+        PathBloom filter;
+        uint32_t mask = 0;
+        size_t count = 0;
+    };
+
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+
+    static bool Outranks(const Source& a, const Source& b);
+    static void Reserve(Snapshot& snap, size_t count);
+    static void Insert(Snapshot& snap, uint64_t hash, uint32_t entry, uint32_t source);
+    static uint64_t RemoveSource(Snapshot& snap, PakArchive* arc);
+    static void RebuildFilter(Snapshot& snap);
+
+    static std::mutex s_WriterMutex;
+    static std::atomic<std::shared_ptr<const Snapshot>> s_Current;
+    static uint64_t s_NextOrder;
+};
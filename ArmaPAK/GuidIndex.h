@@ -0,0 +1,36 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+class PakArchive;
+
+// GUID -> entry index built from the .meta files of the opened archives.
+// Enfusion references resources as "{GUID}path"; the GUID survives a file
+// being moved, so it is tried before any path heuristics.
+class GuidIndex {
+public:
+    // Builds the tables of opened archives that don't have one yet, parsing
+    // the .meta files in parallel on the thread pool.
+    static void Prepare();
+    static bool Resolve(uint64_t guid, const PakArchive* requester, PakArchive*& owner, int& index);
+    static void OnArchiveClosed(PakArchive* arc);
+
+    // Parses a leading "{0123456789ABCDEF}"; returns the length consumed, or 0.
+    static size_t ParseGuid(std::string_view text, uint64_t& guid);
+
+private:
+    struct Table {
+        PakArchive* archive;
+        std::unordered_map<uint64_t, int> entries;
+    };
+
+    static std::shared_ptr<const Table> Build(PakArchive* arc);
+
+    static std::mutex s_Mutex;
+    static std::mutex s_BuildMutex;   // held while a table is built and published
+    static std::vector<std::shared_ptr<const Table>> s_Tables;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "ThreadPool.h"
+
+// Token bucket on the bytes and the operations per second of one I/O
+// direction. Each bucket is kept in the GCRA form: instead of a token count
+// it stores the time at which everything charged so far has been paid for.
+// A request waits until the bucket has paid for it and everything queued
+// in front of it, so large writes never have to be split to fit the bucket
+// and the wait is an exact deadline instead of a polling sleep. Up to BURST
+// of unused time carries over, which bounds the overshoot on an
+// idle-then-busy device to BURST * rate.
+class IoRateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 0 leaves that dimension unlimited.
+    void Configure(uint64_t bytesPerSecond, uint64_t opsPerSecond) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bytes = Bucket(bytesPerSecond);
+        ops = Bucket(opsPerSecond);
+        enabled.store(bytesPerSecond > 0 || opsPerSecond > 0);
+    }
+
+    bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Charges `count` operations moving `size` bytes and returns once they
+    // fit the configured rates; false if the token was cancelled meanwhile.
+    bool Acquire(uint64_t size, uint64_t count = 1, const CancellationToken& cancel = CancellationToken()) {
+        if (!Enabled()) return true;
+
+        Clock::time_point start;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Clock::time_point now = Clock::now();
+            start = std::max(bytes.Charge(size, now), ops.Charge(count, now));
+        }
+
+        // Checked in short steps so a cancelled extraction does not sit out its debt.
+        for (Clock::time_point now = Clock::now(); now < start; now = Clock::now()) {
+            if (cancel.cancelled()) return false;
+            std::this_thread::sleep_until(std::min(start, now + std::chrono::milliseconds(50)));
+        }
+        return !cancel.cancelled();
+    }
+
+private:
+    static constexpr Clock::duration BURST = std::chrono::milliseconds(50);
+
+    struct Bucket {
+        explicit Bucket(uint64_t rate = 0) : rate((double)rate) {}
+
+        // Earliest time `units` may go: once they and everything before them
+        // are paid for. An idle bucket counts at most BURST as paid in
+        // advance, which is the whole burst allowance. Later requests queue
+        // behind them.
+        Clock::time_point Charge(uint64_t units, Clock::time_point now) {
+            if (rate <= 0) return now;
+            paid = std::max(paid, now - BURST) + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(units / rate));
+            return paid;
+        }
+
+        double rate;
+        Clock::time_point paid{};
+    };
+
+    std::mutex mutex;
+    Bucket bytes, ops;
+    std::atomic<bool> enabled{ false };
+};
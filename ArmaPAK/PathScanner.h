@@ -0,0 +1,144 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#define PATHSCANNER_SIMD 1
+#endif
+
+// Finds "assets/..." and "common/..." references with a known extension in
+// raw file data. Candidate starts are located with a vectorised first/last
+// byte filter ('a'/'c' folded, '/' six bytes later) and verified in place,
+// so the data is never copied or lowercased; results point into the buffer.
+class PathScanner {
+public:
+    static std::vector<std::string_view> Scan(const uint8_t* data, size_t size) {
+        std::vector<std::string_view> results;
+        size_t pos = 0;
+        while ((pos = NextPrefix(data, size, pos)) < size) {
+            size_t len = PathLength(data + pos, size - pos);
+            if (len) {
+                results.emplace_back(reinterpret_cast<const char*>(data + pos), len);
+                pos += len;
+            } else {
+                pos++;
+            }
+        }
+        std::sort(results.begin(), results.end());
+        results.erase(std::unique(results.begin(), results.end()), results.end());
+        return results;
+    }
+
+    static const char* Backend() {
+        static const char* name = UseAvx2() ? "AVX2" : (Simd() ? "SSE2" : "scalar");
+        return name;
+    }
+
+    // Length of the path starting at p if it ends in a dependency extension, otherwise 0.
+    static size_t PathLength(const uint8_t* p, size_t avail) {
+        size_t end = 0;
+        while (end < avail && !IsTerminator(p[end])) end++;
+        if (end < 5 || end > 260) return 0;
+
+        static constexpr std::string_view extensions[] = { ".emat", ".edds", ".xob", ".gamemat" };
+        for (std::string_view ext : extensions) {
+            if (end >= ext.size() && EqualsFolded(p + end - ext.size(), ext)) return end;
+        }
+        return 0;
+    }
+
+private:
+    static bool IsTerminator(unsigned char c) {
+        return c <= 32 || c > 126 || c == '"' || c == '\'' || c == '<' || c == '>' || c == '{' || c == '}' ||
+               c == '(' || c == ')' || c == '[' || c == ']' || c == '|';
+    }
+
+    // Compares against lowercase text; only ASCII letters are folded.
+    static bool EqualsFolded(const uint8_t* p, std::string_view lower) {
+        for (size_t i = 0; i < lower.size(); ++i) {
+            unsigned char c = p[i];
+            if (c >= 'A' && c <= 'Z') c += 32;
+            if (c != (unsigned char)lower[i]) return false;
+        }
+        return true;
+    }
+
+    static bool IsPrefixAt(const uint8_t* p) {
+        return p[6] == '/' && (EqualsFolded(p, "assets") || EqualsFolded(p, "common"));
+    }
+
+    static size_t NextScalar(const uint8_t* data, size_t size, size_t pos) {
+        for (; pos + 7 <= size; ++pos) {
+            unsigned char c = data[pos] | 0x20;
+            if ((c == 'a' || c == 'c') && IsPrefixAt(data + pos)) return pos;
+        }
+        return size;
+    }
+
+#ifdef PATHSCANNER_SIMD
+    static bool Simd() { return true; }
+
+    static bool UseAvx2() {
+        static const bool avx2 = [] {
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+        }();
+        return avx2;
+    }
+
+    static size_t NextSse2(const uint8_t* data, size_t size, size_t pos) {
+        const __m128i fold = _mm_set1_epi8(0x20);
+        const __m128i a = _mm_set1_epi8('a'), c = _mm_set1_epi8('c'), slash = _mm_set1_epi8('/');
+        for (; pos + 6 + 16 <= size; pos += 16) {
+            __m128i first = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), fold);
+            __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 6));
+            __m128i hit = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(first, a), _mm_cmpeq_epi8(first, c)), _mm_cmpeq_epi8(last, slash));
+            for (unsigned mask = (unsigned)_mm_movemask_epi8(hit); mask; mask &= mask - 1) {
+                unsigned long bit;
+                _BitScanForward(&bit, mask);
+                if (IsPrefixAt(data + pos + bit)) return pos + bit;
+            }
+        }
+        return NextScalar(data, size, pos);
+    }
+
+    static size_t NextAvx2(const uint8_t* data, size_t size, size_t pos) {
+        const __m256i fold = _mm256_set1_epi8(0x20);
+        const __m256i a = _mm256_set1_epi8('a'), c = _mm256_set1_epi8('c'), slash = _mm256_set1_epi8('/');
+        for (; pos + 6 + 32 <= size; pos += 32) {
+            __m256i first = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)), fold);
+            __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 6));
+            __m256i hit = _mm256_and_si256(_mm256_or_si256(_mm256_cmpeq_epi8(first, a), _mm256_cmpeq_epi8(first, c)), _mm256_cmpeq_epi8(last, slash));
+            for (unsigned mask = (unsigned)_mm256_movemask_epi8(hit); mask; mask &= mask - 1) {
+                unsigned long bit;
+                _BitScanForward(&bit, mask);
+                if (IsPrefixAt(data + pos + bit)) return pos + bit;
+            }
+        }
+        return NextSse2(data, size, pos);
+    }
+
+    static size_t NextPrefix(const uint8_t* data, size_t size, size_t pos) {
+        return UseAvx2() ? NextAvx2(data, size, pos) : NextSse2(data, size, pos);
+    }
+#else
+    static bool Simd() { return false; }
+    static bool UseAvx2() { return false; }
+
+    static size_t NextPrefix(const uint8_t* data, size_t size, size_t pos) {
+        return NextScalar(data, size, pos);
+    }
+#endif
+};
@@ -0,0 +1,829 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <bitset>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// A set of literals and regular expressions matched against raw entry data
+// in one scan per entry, for auditing a mod for dozens of class names, GUIDs
+// or patterns at once.
+//
+// Literals (in their UTF-8 and UTF-16LE form) and a required substring of
+// each regex go into one Aho-Corasick automaton. The regexes are compiled
+// into a single DFA over their union, which is only run over an entry when
+// the automaton saw the required substring of one of them (or one of them
+// has none). Only if that DFA finds a match does a reverse DFA of the union
+// go back over the data to mark where matches start; from each start an
+// anchored DFA of that regex finds the longest match.
+//
+// Literals report every occurrence; a regex reports leftmost-longest,
+// non-overlapping matches. Regexes work on bytes and support . [] [^] \d \w
+// \s (and their negations), \xHH, | () (?:) * + ? {n} {n,} {n,m}. Anchors,
+// backreferences and lookaround have no DFA form and are rejected. Without
+// case sensitivity ASCII letters are folded.
+class PatternSet {
+public:
+    struct Match {
+        uint32_t pattern;   // in the order the patterns were added
+        size_t offset;
+        size_t length;
+    };
+
+    explicit PatternSet(bool caseSensitive) : caseSensitive(caseSensitive) {}
+
+    void AddLiteral(std::string_view utf8) {
+        uint32_t id = count++;
+        if (utf8.empty()) return;
+        AddNeedle(std::string(utf8), id, -1, false);
+        AddNeedle(ToUtf16Le(utf8), id, -1, true);
+        prefilter.push_back(std::string(utf8));
+    }
+
+    bool AddRegex(std::string_view utf8, std::string& error) {
+        Regex re;
+        re.pattern = count;
+        Parser parser{ utf8, re.nodes, caseSensitive };
+        re.root = parser.Parse(error);
+        if (re.root < 0) return false;
+        count++;
+        re.factor = Required(re, re.root);
+        if (re.factor.size() < 3) re.factor.clear();
+        if (!re.factor.empty()) AddNeedle(re.factor, re.pattern, (int)regexes.size(), false);
+        prefilter.push_back(re.factor);
+        regexes.push_back(std::move(re));
+        return true;
+    }
+
+    // Builds the automata; false with a message when a regex matches empty
+    // text or needs too many DFA states.
+    bool Compile(std::string& error) {
+        BuildAhoCorasick();
+        for (Regex& re : regexes) {
+            Nfa forward;
+            int f = Emit(re, re.root, forward.AddMatch(re.pattern), false, forward);
+            if (!BuildDfa(forward, f, false, re.forward)) {
+                error = "pattern " + std::to_string(re.pattern + 1) + " needs too many DFA states";
+                return false;
+            }
+            if (re.forward.Accepting(re.forward.start)) {
+                error = "pattern " + std::to_string(re.pattern + 1) + " matches empty text";
+                return false;
+            }
+        }
+
+        // One DFA for all regexes when it fits, otherwise as few as it takes.
+        groups.clear();
+        std::vector<uint32_t> all(regexes.size());
+        for (uint32_t i = 0; i < all.size(); ++i) all[i] = i;
+        if (all.empty()) return true;
+        Group whole;
+        if (BuildGroup(all, whole)) {
+            groups.push_back(std::move(whole));
+            return true;
+        }
+        std::vector<uint32_t> members;
+        Group group;
+        for (uint32_t i : all) {
+            members.push_back(i);
+            Group attempt;
+            if (BuildGroup(members, attempt)) {
+                group = std::move(attempt);
+                continue;
+            }
+            groups.push_back(std::move(group));
+            members = { i };
+            if (!BuildGroup(members, group)) {
+                error = "pattern " + std::to_string(regexes[i].pattern + 1) + " needs too many DFA states";
+                return false;
+            }
+        }
+        groups.push_back(std::move(group));
+        return true;
+    }
+
+    size_t Size() const { return count; }
+
+    // Strings of which every match contains at least one, for narrowing the
+    // entries down through a ContentIndex; "" stands for "any entry".
+    const std::vector<std::string>& Prefilter() const { return prefilter; }
+
+    // Appends the matches in data, ordered by offset.
+    void Scan(const uint8_t* data, size_t size, std::vector<Match>& matches) const {
+        size_t first = matches.size();
+        std::vector<uint8_t> active(regexes.size(), 0);
+        if (!needles.empty()) ScanAhoCorasick(data, size, matches, active);
+
+        std::vector<size_t> lastEnd(regexes.size(), 0);
+        for (const Group& group : groups) {
+            bool run = false;
+            for (uint32_t r : group.members) run |= regexes[r].factor.empty() || active[r];
+            if (run) ScanGroup(group, data, size, matches, lastEnd);
+        }
+        std::sort(matches.begin() + first, matches.end(), [](const Match& a, const Match& b) {
+            return a.offset != b.offset ? a.offset < b.offset : a.pattern < b.pattern;
+        });
+    }
+
+private:
+    static constexpr size_t MAX_STATES = 10000;
+    static constexpr uint32_t DEAD = 0;
+    static constexpr int MAX_REPEAT = 255;
+
+    using ByteSet = std::bitset<256>;
+
+    struct Node {
+        enum Kind { Bytes, Concat, Alt, Repeat } kind;
+        ByteSet set;
+        std::vector<int> children;
+        int min = 0, max = 0;   // max < 0: unbounded
+    };
+
+    // Dense transition table over byte classes; state 0 is the dead state.
+    // Once built, states are kept as their row offset with ACCEPT set for
+    // accepting ones, so a step is one load and no multiply.
+    struct Dfa {
+        static constexpr uint32_t ACCEPT = 0x80000000u;
+
+        uint16_t classOf[256] = {};
+        uint32_t classes = 1;
+        uint32_t start = DEAD;
+        std::vector<uint32_t> next;
+        std::vector<uint32_t> matchBegin;   // states + 1 offsets into matchIds
+        std::vector<uint32_t> matchIds;
+
+        static bool Accepting(uint32_t s) { return (s & ACCEPT) != 0; }
+        uint32_t Step(uint32_t s, uint8_t byte) const { return next[(s & ~ACCEPT) + classOf[byte]]; }
+
+        // Match ids of an accepting state.
+        const uint32_t* IdsBegin(uint32_t s) const { return matchIds.data() + matchBegin[(s & ~ACCEPT) / classes]; }
+        const uint32_t* IdsEnd(uint32_t s) const { return matchIds.data() + matchBegin[(s & ~ACCEPT) / classes + 1]; }
+
+        // From state numbers to the encoded form, after matchBegin is filled in.
+        void Encode() {
+            auto encode = [this](uint32_t t) { return t * classes | (matchBegin[t + 1] != matchBegin[t] ? ACCEPT : 0); };
+            for (uint32_t& t : next) t = encode(t);
+            start = encode(start);
+        }
+    };
+
+    struct Regex {
+        uint32_t pattern = 0;
+        std::vector<Node> nodes;
+        int root = -1;
+        std::string factor;   // required substring, folded; empty if none
+        Dfa forward;          // anchored, for the longest match from a start
+    };
+
+    // Unanchored DFAs over the union of some regexes; matchIds are regex indices.
+    struct Group {
+        std::vector<uint32_t> members;
+        Dfa forward, reverse;
+    };
+
+    struct Needle {
+        std::string bytes;
+        std::string fold;   // 0x20 where a letter was folded
+        uint32_t pattern;
+        int regex;          // >= 0: prefilter for that regex, not reported
+    };
+
+    // ------------------------------------------------------------------
+    // Regex parser: bytes in, syntax tree out.
+    // ------------------------------------------------------------------
+    struct Parser {
+        std::string_view text;
+        std::vector<Node>& nodes;
+        bool caseSensitive;
+        size_t pos = 0;
+        std::string error;
+
+        int Parse(std::string& message) {
+            int root = ParseAlt();
+            if (root >= 0 && pos < text.size()) Fail(text[pos] == ')' ? "unbalanced ')'" : "unexpected character");
+            if (!error.empty()) {
+                message = error + " at offset " + std::to_string(pos) + " in \"" + std::string(text) + "\"";
+                return -1;
+            }
+            return root;
+        }
+
+        int Fail(const char* message) {
+            if (error.empty()) error = message;
+            return -1;
+        }
+
+        int Add(Node node) {
+            nodes.push_back(std::move(node));
+            return (int)nodes.size() - 1;
+        }
+
+        ByteSet Folded(ByteSet set) const {
+            if (!caseSensitive) {
+                for (int c = 'a'; c <= 'z'; ++c) {
+                    if (set[c] || set[c - 32]) set.set(c).set(c - 32);
+                }
+            }
+            return set;
+        }
+
+        int AddSet(const ByteSet& set) {
+            Node node{ Node::Bytes };
+            node.set = Folded(set);
+            return Add(std::move(node));
+        }
+
+        int ParseAlt() {
+            Node alt{ Node::Alt };
+            for (;;) {
+                int branch = ParseConcat();
+                if (branch < 0) return -1;
+                alt.children.push_back(branch);
+                if (pos >= text.size() || text[pos] != '|') break;
+                pos++;
+            }
+            return alt.children.size() == 1 ? alt.children[0] : Add(std::move(alt));
+        }
+
+        int ParseConcat() {
+            Node concat{ Node::Concat };
+            while (pos < text.size() && text[pos] != '|' && text[pos] != ')') {
+                int item = ParseRepeat();
+                if (item < 0) return -1;
+                concat.children.push_back(item);
+            }
+            return concat.children.size() == 1 ? concat.children[0] : Add(std::move(concat));
+        }
+
+        int ParseRepeat() {
+            int atom = ParseAtom();
+            while (atom >= 0 && pos < text.size()) {
+                int min, max;
+                char c = text[pos];
+                if (c == '*') { min = 0; max = -1; pos++; }
+                else if (c == '+') { min = 1; max = -1; pos++; }
+                else if (c == '?') { min = 0; max = 1; pos++; }
+                else if (c != '{' || !ParseBounds(min, max)) break;
+                if (min > MAX_REPEAT || max > MAX_REPEAT) return Fail("repeat count above 255");
+                if (max >= 0 && max < min) return Fail("bad repeat bounds");
+
+                // A lazy suffix ("*?") changes nothing for leftmost-longest matching.
+                if (pos < text.size() && text[pos] == '?') pos++;
+                Node repeat{ Node::Repeat };
+                repeat.children = { atom };
+                repeat.min = min;
+                repeat.max = max;
+                atom = Add(std::move(repeat));
+            }
+            return atom;
+        }
+
+        // {n} {n,} {n,m}; anything else leaves '{' a literal, as in GUIDs.
+        bool ParseBounds(int& min, int& max) {
+            size_t p = pos + 1;
+            auto number = [&](int& value) {
+                size_t begin = p;
+                value = 0;
+                while (p < text.size() && text[p] >= '0' && text[p] <= '9' && p - begin < 6) value = value * 10 + (text[p++] - '0');
+                return p > begin;
+            };
+            if (!number(min)) return false;
+            max = min;
+            if (p < text.size() && text[p] == ',') {
+                p++;
+                if (!number(max)) max = -1;
+            }
+            if (p >= text.size() || text[p] != '}') return false;
+            pos = p + 1;
+            return true;
+        }
+
+        int ParseAtom() {
+            char c = text[pos++];
+            switch (c) {
+            case '(': {
+                if (text.substr(pos, 2) == "?:") pos += 2;
+                else if (pos < text.size() && text[pos] == '?') return Fail("unsupported group");
+                int inner = ParseAlt();
+                if (inner < 0) return -1;
+                if (pos >= text.size() || text[pos] != ')') return Fail("missing ')'");
+                pos++;
+                return inner;
+            }
+            case '[':
+                return ParseClass();
+            case '.': {
+                ByteSet set;
+                set.set().reset('\n');
+                return AddSet(set);
+            }
+            case '\\': {
+                ByteSet set;
+                if (!ParseEscape(set)) return -1;
+                return AddSet(set);
+            }
+            case '*': case '+': case '?':
+                return Fail("nothing to repeat");
+            case '^': case '$':
+                return Fail("anchors are not supported");
+            default: {
+                ByteSet set;
+                set.set((uint8_t)c);
+                return AddSet(set);
+            }
+            }
+        }
+
+        static ByteSet Shorthand(char c) {
+            ByteSet set;
+            auto range = [&set](int from, int to) { for (int b = from; b <= to; ++b) set.set(b); };
+            if (c == 'd' || c == 'w') range('0', '9');
+            if (c == 'w') {
+                range('a', 'z');
+                range('A', 'Z');
+                set.set('_');
+            }
+            if (c == 's') {
+                for (char s : std::string_view(" \t\r\n\f\v")) set.set((uint8_t)s);
+            }
+            return set;
+        }
+
+        bool ParseEscape(ByteSet& set) {
+            if (pos >= text.size()) {
+                Fail("trailing '\\'");
+                return false;
+            }
+            char c = text[pos++];
+            switch (c) {
+            case 'd': case 'w': case 's': set |= Shorthand(c); break;
+            case 'D': case 'W': case 'S': set |= ~Shorthand((char)(c | 0x20)); break;
+            case 't': set.set('\t'); break;
+            case 'n': set.set('\n'); break;
+            case 'r': set.set('\r'); break;
+            case 'f': set.set('\f'); break;
+            case 'v': set.set('\v'); break;
+            case '0': set.set(0); break;
+            case 'x': {
+                int value = 0;
+                for (int i = 0; i < 2; ++i) {
+                    int digit = pos < text.size() ? HexDigit(text[pos]) : -1;
+                    if (digit < 0) {
+                        Fail("bad \\x escape");
+                        return false;
+                    }
+                    value = value * 16 + digit;
+                    pos++;
+                }
+                set.set(value);
+                break;
+            }
+            default:
+                if ((c >= '1' && c <= '9') || c == 'b' || c == 'B' || c == 'A' || c == 'z' || c == 'Z') {
+                    Fail("backreferences and assertions are not supported");
+                    return false;
+                }
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                    Fail("unknown escape");
+                    return false;
+                }
+                set.set((uint8_t)c);
+            }
+            return true;
+        }
+
+        static int HexDigit(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+            return -1;
+        }
+
+        int ParseClass() {
+            ByteSet set;
+            bool negate = pos < text.size() && text[pos] == '^';
+            if (negate) pos++;
+            bool first = true;
+            while (pos < text.size() && (text[pos] != ']' || first)) {
+                first = false;
+                ByteSet item;
+                int low = -1;
+                if (!ParseClassItem(item, low)) return -1;
+                if (low >= 0 && pos + 1 < text.size() && text[pos] == '-' && text[pos + 1] != ']') {
+                    pos++;
+                    ByteSet end;
+                    int high = -1;
+                    if (!ParseClassItem(end, high)) return -1;
+                    if (high < low) return Fail("bad class range");
+                    for (int b = low; b <= high; ++b) item.set(b);
+                }
+                set |= item;
+            }
+            if (pos >= text.size()) return Fail("missing ']'");
+            pos++;
+            // Folded before the negation, so [^a] excludes 'A' as well.
+            return AddSet(negate ? ~Folded(set) : set);
+        }
+
+        // One class member; `single` receives its byte when it is one.
+        bool ParseClassItem(ByteSet& item, int& single) {
+            uint8_t c = (uint8_t)text[pos++];
+            if (c >= 0x80) {
+                Fail("non-ASCII characters in classes are not supported");
+                return false;
+            }
+            if (c != '\\') {
+                item.set(c);
+                single = c;
+                return true;
+            }
+            if (!ParseEscape(item)) return false;
+            if (item.count() == 1) {
+                for (int b = 0; b < 256; ++b) {
+                    if (item[b]) single = b;
+                }
+            }
+            return true;
+        }
+    };
+
+    // ------------------------------------------------------------------
+    // Thompson NFA built from the tree, forwards or backwards.
+    // ------------------------------------------------------------------
+    struct Nfa {
+        struct State {
+            int set = -1;             // consumes a byte of sets[set], then goes to out
+            int out = -1;
+            std::vector<int> eps;     // epsilon moves
+            int match = -1;
+        };
+        std::vector<State> states;
+        std::vector<ByteSet> sets;
+
+        int Add(State state) {
+            states.push_back(std::move(state));
+            return (int)states.size() - 1;
+        }
+
+        int AddMatch(uint32_t id) {
+            State state;
+            state.match = (int)id;
+            return Add(std::move(state));
+        }
+    };
+
+    // Start state of `node` followed by `next`.
+    static int Emit(const Regex& re, int index, int next, bool reverse, Nfa& nfa) {
+        const Node& node = re.nodes[index];
+        switch (node.kind) {
+        case Node::Bytes: {
+            Nfa::State state;
+            state.set = (int)nfa.sets.size();
+            state.out = next;
+            nfa.sets.push_back(node.set);
+            return nfa.Add(std::move(state));
+        }
+        case Node::Concat: {
+            int cur = next;
+            if (reverse) {
+                for (int child : node.children) cur = Emit(re, child, cur, reverse, nfa);
+            } else {
+                for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) cur = Emit(re, *it, cur, reverse, nfa);
+            }
+            return cur;
+        }
+        case Node::Alt: {
+            Nfa::State split;
+            for (int child : node.children) split.eps.push_back(Emit(re, child, next, reverse, nfa));
+            return nfa.Add(std::move(split));
+        }
+        case Node::Repeat: {
+            int cur = next;
+            if (node.max < 0) {
+                int loop = nfa.Add(Nfa::State());
+                int body = Emit(re, node.children[0], loop, reverse, nfa);
+                nfa.states[loop].eps = { body, next };
+                cur = loop;
+            } else {
+                for (int i = node.min; i < node.max; ++i) {
+                    int body = Emit(re, node.children[0], cur, reverse, nfa);
+                    Nfa::State optional;
+                    optional.eps = { body, next };
+                    cur = nfa.Add(std::move(optional));
+                }
+            }
+            for (int i = 0; i < node.min; ++i) cur = Emit(re, node.children[0], cur, reverse, nfa);
+            return cur;
+        }
+        }
+        return next;
+    }
+
+    // ------------------------------------------------------------------
+    // Subset construction. Unanchored DFAs restart the NFA at every byte.
+    // ------------------------------------------------------------------
+    static void Closure(const Nfa& nfa, std::vector<int>& states) {
+        std::vector<int> stack(states.begin(), states.end());
+        std::vector<uint8_t> seen(nfa.states.size(), 0);
+        states.clear();
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            if (seen[s]) continue;
+            seen[s] = 1;
+            const Nfa::State& state = nfa.states[s];
+            if (state.set >= 0 || state.match >= 0) states.push_back(s);
+            for (int e : state.eps) stack.push_back(e);
+        }
+        std::sort(states.begin(), states.end());
+    }
+
+    static bool BuildDfa(const Nfa& nfa, int startState, bool unanchored, Dfa& dfa) {
+        // Bytes no set tells apart share a class.
+        uint16_t classOf[256] = {};
+        uint32_t classes = 1;
+        for (const ByteSet& set : nfa.sets) {
+            uint32_t remap[512];
+            std::fill(std::begin(remap), std::end(remap), UINT32_MAX);
+            uint32_t fresh = 0;
+            for (int b = 0; b < 256; ++b) {
+                uint32_t key = classOf[b] * 2 + (set[b] ? 1 : 0);
+                if (remap[key] == UINT32_MAX) remap[key] = fresh++;
+                classOf[b] = (uint16_t)remap[key];
+            }
+            classes = fresh;
+        }
+        std::vector<int> representative(classes, 0);
+        for (int b = 255; b >= 0; --b) representative[classOf[b]] = b;
+        memcpy(dfa.classOf, classOf, sizeof(classOf));
+        dfa.classes = classes;
+
+        std::vector<int> startSet = { startState };
+        Closure(nfa, startSet);
+
+        std::map<std::vector<int>, uint32_t> ids;
+        std::vector<std::vector<int>> sets;
+        auto intern = [&](std::vector<int>&& set) {
+            auto it = ids.find(set);
+            if (it != ids.end()) return it->second;
+            uint32_t id = (uint32_t)sets.size();
+            ids.emplace(set, id);
+            sets.push_back(std::move(set));
+            return id;
+        };
+        intern({});   // DEAD
+        dfa.start = intern(std::vector<int>(startSet));
+
+        dfa.next.clear();
+        for (size_t s = 0; s < sets.size(); ++s) {
+            if (sets.size() > MAX_STATES) return false;
+            for (uint32_t c = 0; c < classes; ++c) {
+                std::vector<int> target;
+                for (int n : sets[s]) {
+                    const Nfa::State& state = nfa.states[n];
+                    if (state.set >= 0 && nfa.sets[state.set][representative[c]]) target.push_back(state.out);
+                }
+                if (unanchored) target.insert(target.end(), startSet.begin(), startSet.end());
+                Closure(nfa, target);
+                dfa.next.push_back(intern(std::move(target)));
+            }
+        }
+
+        dfa.matchBegin.assign(1, 0);
+        dfa.matchIds.clear();
+        for (const auto& set : sets) {
+            size_t begin = dfa.matchIds.size();
+            for (int n : set) {
+                if (nfa.states[n].match >= 0) dfa.matchIds.push_back((uint32_t)nfa.states[n].match);
+            }
+            std::sort(dfa.matchIds.begin() + begin, dfa.matchIds.end());
+            dfa.matchIds.erase(std::unique(dfa.matchIds.begin() + begin, dfa.matchIds.end()), dfa.matchIds.end());
+            dfa.matchBegin.push_back((uint32_t)dfa.matchIds.size());
+        }
+        dfa.Encode();
+        return true;
+    }
+
+    bool BuildGroup(const std::vector<uint32_t>& members, Group& group) const {
+        for (int direction = 0; direction < 2; ++direction) {
+            Nfa nfa;
+            Nfa::State split;
+            for (uint32_t r : members) split.eps.push_back(Emit(regexes[r], regexes[r].root, nfa.AddMatch(r), direction == 1, nfa));
+            int start = nfa.Add(std::move(split));
+            if (!BuildDfa(nfa, start, true, direction == 1 ? group.reverse : group.forward)) return false;
+        }
+        group.members = members;
+        return true;
+    }
+
+    void ScanGroup(const Group& group, const uint8_t* data, size_t size, std::vector<Match>& matches, std::vector<size_t>& lastEnd) const {
+        // Forward: where does the last match end, if there is any?
+        size_t last = 0;
+        uint32_t s = group.forward.start;
+        for (size_t i = 0; i < size; ++i) {
+            s = group.forward.Step(s, data[i]);
+            if (group.forward.Accepting(s)) last = i + 1;
+        }
+        if (!last) return;
+
+        // Backward from there: every position where a match of some regex starts.
+        std::vector<std::pair<size_t, uint32_t>> starts;
+        s = group.reverse.start;
+        for (size_t p = last; p > 0;) {
+            s = group.reverse.Step(s, data[--p]);
+            if (!group.reverse.Accepting(s)) continue;
+            for (const uint32_t* id = group.reverse.IdsBegin(s); id != group.reverse.IdsEnd(s); ++id) starts.push_back({ p, *id });
+        }
+
+        // Leftmost-longest: take each start past the previous match of its regex.
+        for (auto it = starts.rbegin(); it != starts.rend(); ++it) {
+            const Regex& re = regexes[it->second];
+            size_t start = it->first;
+            if (start < lastEnd[it->second]) continue;
+
+            size_t stop = start;
+            s = re.forward.start;
+            for (size_t p = start; p < size; ++p) {
+                s = re.forward.Step(s, data[p]);
+                if (s == DEAD) break;
+                if (re.forward.Accepting(s)) stop = p + 1;
+            }
+            matches.push_back({ re.pattern, start, stop - start });
+            lastEnd[it->second] = stop;
+        }
+    }
+
+    // Longest byte string every match of the node contains, letters folded.
+    std::string Required(const Regex& re, int index) const {
+        const Node& node = re.nodes[index];
+        switch (node.kind) {
+        case Node::Bytes: {
+            int c = SingleByte(node.set);
+            return c >= 0 ? std::string(1, (char)c) : std::string();
+        }
+        case Node::Concat: {
+            std::string best, run;
+            auto consider = [&best](const std::string& candidate) {
+                if (candidate.size() > best.size()) best = candidate;
+            };
+            for (int child : node.children) {
+                const Node& c = re.nodes[child];
+                int byte = c.kind == Node::Bytes ? SingleByte(c.set) : -1;
+                if (byte >= 0) {
+                    run.push_back((char)byte);
+                    continue;
+                }
+                consider(run);
+                run.clear();
+                consider(Required(re, child));
+            }
+            consider(run);
+            return best;
+        }
+        case Node::Repeat:
+            return node.min > 0 ? Required(re, node.children[0]) : std::string();
+        case Node::Alt:
+            break;
+        }
+        return std::string();
+    }
+
+    // The byte a set stands for (lowercase for a folded letter pair), or -1.
+    int SingleByte(const ByteSet& set) const {
+        size_t n = set.count();
+        if (n != 1 && (n != 2 || caseSensitive)) return -1;
+        for (int b = 0; b < 256; ++b) {
+            if (!set[b]) continue;
+            if (n == 1) return b;
+            return (b >= 'A' && b <= 'Z' && set[b + 32]) ? b + 32 : -1;
+        }
+        return -1;
+    }
+
+    // ------------------------------------------------------------------
+    // Aho-Corasick over the literals and the regex prefilters.
+    // ------------------------------------------------------------------
+    uint8_t Fold(uint8_t c) const { return (!caseSensitive && c >= 'A' && c <= 'Z') ? c | 0x20 : c; }
+
+    void AddNeedle(const std::string& bytes, uint32_t pattern, int regex, bool utf16) {
+        Needle needle{ std::string(), std::string(), pattern, regex };
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            uint8_t c = (uint8_t)bytes[i];
+            // In UTF-16 only ASCII letters are folded, not bytes of other characters.
+            bool letter = !caseSensitive && (c | 0x20) >= 'a' && (c | 0x20) <= 'z' && (!utf16 || (i % 2 == 0 && bytes[i + 1] == 0));
+            needle.bytes.push_back((char)(letter ? (c | 0x20) : c));
+            needle.fold.push_back(letter ? 0x20 : 0);
+        }
+        needles.push_back(std::move(needle));
+    }
+
+    static std::string ToUtf16Le(std::string_view utf8) {
+        std::string out;
+        for (size_t i = 0; i < utf8.size();) {
+            uint8_t c = (uint8_t)utf8[i];
+            uint32_t cp = c;
+            size_t len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+            if (len > 1) {
+                cp = c & (0xFF >> (len + 1));
+                for (size_t k = 1; k < len && i + k < utf8.size(); ++k) cp = (cp << 6) | ((uint8_t)utf8[i + k] & 0x3F);
+            }
+            i += len;
+            if (cp >= 0x10000) {
+                cp -= 0x10000;
+                uint32_t high = 0xD800 + (cp >> 10), low = 0xDC00 + (cp & 0x3FF);
+                out += { (char)(high & 0xFF), (char)(high >> 8), (char)(low & 0xFF), (char)(low >> 8) };
+            } else {
+                out += { (char)(cp & 0xFF), (char)(cp >> 8) };
+            }
+        }
+        return out;
+    }
+
+    void BuildAhoCorasick() {
+        ac = Dfa();
+        uint32_t classes = 1;
+        for (const Needle& n : needles) {
+            for (char c : n.bytes) {
+                uint8_t b = Fold((uint8_t)c);
+                if (!ac.classOf[b]) ac.classOf[b] = (uint16_t)classes++;
+            }
+        }
+        for (int b = 0; b < 256; ++b) ac.classOf[b] = ac.classOf[Fold((uint8_t)b)];
+        ac.classes = classes;
+
+        // Trie first (state 0 is the root here), then failure links in BFS order.
+        std::vector<std::vector<uint32_t>> outputs(1);
+        ac.next.assign(classes, 0);
+        for (uint32_t i = 0; i < needles.size(); ++i) {
+            uint32_t s = 0;
+            for (char c : needles[i].bytes) {
+                uint32_t cls = ac.classOf[(uint8_t)c];
+                uint32_t& slot = ac.next[(size_t)s * classes + cls];
+                if (!slot) {
+                    slot = (uint32_t)outputs.size();
+                    outputs.emplace_back();
+                    ac.next.resize(ac.next.size() + classes, 0);
+                }
+                s = ac.next[(size_t)s * classes + cls];
+            }
+            outputs[s].push_back(i);
+        }
+
+        std::vector<uint32_t> fail(outputs.size(), 0), queue;
+        for (uint32_t c = 1; c < classes; ++c) {
+            if (uint32_t child = ac.next[c]) queue.push_back(child);
+        }
+        for (size_t q = 0; q < queue.size(); ++q) {
+            uint32_t s = queue[q];
+            outputs[s].insert(outputs[s].end(), outputs[fail[s]].begin(), outputs[fail[s]].end());
+            for (uint32_t c = 1; c < classes; ++c) {
+                uint32_t& slot = ac.next[(size_t)s * classes + c];
+                uint32_t fallback = ac.next[(size_t)fail[s] * classes + c];
+                if (slot) {
+                    fail[slot] = fallback;
+                    queue.push_back(slot);
+                } else {
+                    slot = fallback;
+                }
+            }
+        }
+
+        ac.matchBegin.assign(1, 0);
+        for (const auto& out : outputs) {
+            ac.matchIds.insert(ac.matchIds.end(), out.begin(), out.end());
+            ac.matchBegin.push_back((uint32_t)ac.matchIds.size());
+        }
+        ac.Encode();
+    }
+
+    void ScanAhoCorasick(const uint8_t* data, size_t size, std::vector<Match>& matches, std::vector<uint8_t>& active) const {
+        uint32_t s = 0;
+        for (size_t i = 0; i < size; ++i) {
+            s = ac.Step(s, data[i]);
+            if (!ac.Accepting(s)) continue;
+            for (const uint32_t* id = ac.IdsBegin(s); id != ac.IdsEnd(s); ++id) {
+                const Needle& n = needles[*id];
+                size_t start = i + 1 - n.bytes.size();
+                if (n.regex >= 0) active[n.regex] = 1;
+                else if (caseSensitive || Equals(n, data + start)) matches.push_back({ n.pattern, start, n.bytes.size() });
+            }
+        }
+    }
+
+    static bool Equals(const Needle& n, const uint8_t* p) {
+        for (size_t i = 0; i < n.bytes.size(); ++i) {
+            if ((p[i] | (uint8_t)n.fold[i]) != (uint8_t)n.bytes[i]) return false;
+        }
+        return true;
+    }
+
+    bool caseSensitive;
+    uint32_t count = 0;
+    std::vector<Needle> needles;
+    std::vector<Regex> regexes;
+    std::vector<Group> groups;
+    std::vector<std::string> prefilter;
+    Dfa ac;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+class PakArchive;
+
+// Session memo of dependency lookups. SmartExtractor meets the same engine
+// paths in thousands of files and most of them are in no archive at all, so
+// both hits and misses are remembered. Entries are keyed by the requesting
+// archive and the folded path, and tagged with a generation that is bumped
+// whenever the set of searchable archives changes.
+class ResolveMemo {
+public:
+    struct Result {
+        PakArchive* archive = nullptr;
+        int index = -1;
+    };
+
+    static bool Lookup(const PakArchive* requester, std::string_view path, Result& out);
+    static void Store(const PakArchive* requester, std::string_view path, uint64_t generation, const Result& result);
+
+    static uint64_t Generation() { return s_Generation.load(std::memory_order_acquire); }
+    static void Invalidate() { s_Generation.fetch_add(1, std::memory_order_acq_rel); }
+
+    // A probe that a Bloom filter proved unnecessary.
+    static void CountFiltered() { s_Filtered.fetch_add(1, std::memory_order_relaxed); }
+    static void LogStats();
+
+private:
+    struct Cached {
+        Result result;
+        uint64_t generation;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Cached> entries;
+    };
+
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t MAX_SHARD_ENTRIES = 16384;
+
+    static std::string MakeKey(const PakArchive* requester, std::string_view path);
+
+    static Shard s_Shards[SHARD_COUNT];
+    static std::atomic<uint64_t> s_Generation;
+    static std::atomic<uint64_t> s_Hits;
+    static std::atomic<uint64_t> s_Negative;
+    static std::atomic<uint64_t> s_Misses;
+    static std::atomic<uint64_t> s_Filtered;
+};
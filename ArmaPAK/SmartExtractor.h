@@ -1,16 +1,83 @@
-#pragma once
-#include <string>
-#include <unordered_set>
-#include <vector>
-#include <cstdint>
-
-class PakArchive;
-
-class SmartExtractor {
-public:
-    static bool ExtractWithDependencies(PakArchive* sourceArc, int index, const std::string& destPath, std::unordered_set<std::string>& processed);
-
-private:
-    static std::vector<std::string> FindDependencies(PakArchive* sourceArc, const std::vector<uint8_t>& data);
-    static bool LooksLikePath(const std::string& s);
-};
\ No newline at end of file
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include "ThreadPool.h"
+
+class PakArchive;
+
+class SmartExtractor {
+public:
+    // Scanned bytes ExtractWithDependencies lets a plan keep.
+    static constexpr uint64_t KEEP_SCANNED_BYTES = 64ull * 1024 * 1024;
+
+    struct PlanItem {
+        PakArchive* archive;
+        int index;
+        std::string targetPath;
+        std::vector<uint8_t> data;   // inflated bytes kept from scanning, if any
+    };
+
+    // Sizes come from the entry table; nothing is inflated to compute them.
+    struct ArchiveTotals {
+        uint64_t files = 0;
+        uint64_t packedBytes = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Plan {
+        std::vector<PlanItem> items;
+        std::map<std::string, ArchiveTotals> archives;
+        ArchiveTotals total;
+        bool truncated = false;
+
+        // Bytes of scanned entries the plan may keep so ExecutePlan does not
+        // inflate them twice. 0, the default, keeps nothing (dry runs).
+        uint64_t keepScannedBytes = 0;
+
+        // Set by the caller; every planning and writing task checks the
+        // token and runs in the given lane of the pool.
+        CancellationToken cancel;
+        ThreadPool::Priority priority = ThreadPool::Priority::Normal;
+    };
+
+    // Interactive requests pass Priority::High so they overtake background extractions.
+    static bool ExtractWithDependencies(PakArchive* sourceArc, int index, const std::string& destPath,
+                                        const CancellationToken& cancel = CancellationToken(),
+                                        ThreadPool::Priority priority = ThreadPool::Priority::Normal);
+
+    // Resolves the full dependency closure without writing anything; only
+    // entries that have to be scanned for references are inflated.
+    static bool PlanDependencies(PakArchive* sourceArc, int index, const std::string& destPath, Plan& plan);
+    // Writes a plan as one bulk job, reading each archive in offset order.
+    static bool ExecutePlan(Plan& plan);
+    static std::string DescribePlan(const Plan& plan);
+
+    // References of one entry, from the dependency cache or by inflating and
+    // scanning it; returns false for entry types that have no references.
+    // When the entry had to be inflated its bytes are left in data.
+    static bool CollectReferences(PakArchive* arc, int index, std::vector<std::string>& refs, std::vector<uint8_t>& data,
+                                  const CancellationToken& cancel = CancellationToken());
+    static bool ResolveReference(PakArchive* requester, const std::string& ref, PakArchive*& owner, int& index);
+
+private:
+    // Shared state of one planning walk; every entry is a task on the pool that
+    // scans it and spawns tasks for its dependencies.
+    struct Graph;
+
+    static void Spawn(Graph& graph, PakArchive* arc, int index, std::string targetPath);
+    static void Visit(Graph& graph, PakArchive* arc, int index, const std::string& targetPath);
+    static std::string CleanDependencyPath(std::string_view depLine);
+    static std::vector<std::string_view> FindDependencies(PakArchive* sourceArc, const std::string& ext, const std::vector<uint8_t>& data);
+
+    // Structure-aware reference extractors by extension. A parser returns
+    // false when it does not recognise the data; the raw scanner is used then.
+    using DependencyParser = std::function<bool(const std::vector<uint8_t>& data, std::vector<std::string_view>& paths, size_t& bytesTouched)>;
+    static const std::unordered_map<std::string, DependencyParser>& Parsers();
+    static bool ParseXob(const std::vector<uint8_t>& data, std::vector<std::string_view>& paths, size_t& bytesTouched);
+    static bool ParseEnfusionText(const std::vector<uint8_t>& data, std::vector<std::string_view>& paths, size_t& bytesTouched);
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class PakArchive;
+
+// Streams the flattened entries of an archive as a ustar stream into a file,
+// pipe or console handle. Entries are inflated on the thread pool but written
+// strictly in archive order through a bounded reorder window.
+class TarExporter {
+public:
+    // False when the output could not be written. Entries that fail to
+    // inflate are left out of the tar and counted in skipped.
+    static bool Export(PakArchive* arc, HANDLE hOut, const std::string& filter, size_t& skipped);
+
+private:
+    static bool MatchesFilter(const std::string& name, const std::vector<std::string>& patterns);
+    static bool WildcardMatch(const char* pattern, const char* text);
+    static std::vector<uint8_t> BuildHeader(const std::string& tarName, uint64_t size, uint32_t mtime, char type);
+    static bool WriteAll(HANDLE hOut, const uint8_t* data, size_t size);
+};
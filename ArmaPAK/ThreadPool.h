@@ -1,67 +1,514 @@
-#pragma once
-#include <vector>
-#include <queue>
-#include <memory>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <future>
-#include <functional>
-#include <stdexcept>
-#include <type_traits>
-
-class ThreadPool {
-public:
-    ThreadPool(size_t threads) : stop(false) {
-        for (size_t i = 0; i < threads; ++i)
-            workers.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
-                        if (this->stop && this->tasks.empty()) return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
-    }
-
-    template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args)
-        -> std::future<typename std::invoke_result<F, Args...>::type> {
-        using return_type = typename std::invoke_result<F, Args...>::type;
-
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop) throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace([task]() { (*task)(); });
-        }
-        condition.notify_one();
-        return res;
-    }
-
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers) {
-            if (worker.joinable()) worker.join();
-        }
-    }
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
-};
\ No newline at end of file
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <exception>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <chrono>
+#include <system_error>
+
+// Cooperative cancellation shared by an operation and everything it spawned.
+// Copies observe the same flag; a default-constructed token never fires.
+class CancellationToken {
+public:
+    static CancellationToken create() {
+        CancellationToken token;
+        token.state = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void cancel() const {
+        if (state) state->store(true, std::memory_order_relaxed);
+    }
+
+    bool cancelled() const { return state && state->load(std::memory_order_relaxed); }
+
+    void throw_if_cancelled() const {
+        if (cancelled()) throw OperationCancelled();
+    }
+
+    struct OperationCancelled : std::runtime_error {
+        OperationCancelled() : std::runtime_error("Operation cancelled") {}
+    };
+
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+// Work-stealing pool. Every worker owns a deque: tasks submitted from a
+// worker go to the back of its own deque and are popped LIFO, tasks from
+// outside are dealt round-robin. An idle worker steals from the front of
+// the others. Tasks are stored in small-buffer objects, so submit() of a
+// small callable does not allocate beyond the deque's own blocks.
+//
+// Every deque has two lanes. Workers take High tasks from anywhere before
+// any Normal task, so interactive work overtakes queued background work.
+// Tasks submitted from inside a task default to that task's lane.
+//
+// The pool is elastic: no thread exists until the first task is queued, a
+// worker is started whenever work arrives and none is idle (up to the
+// configured maximum), and a worker that stays idle for the idle timeout
+// exits again.
+//
+// Blocking on a future from inside a task can starve the pool; code that
+// fans out and waits should use a TaskGroup (or parallel_for), whose wait
+// runs queued tasks on the waiting thread. Those may be any queued tasks,
+// so code that holds a lock, or that other threads block on, fans out with
+// parallel_for_isolated instead.
+class ThreadPool {
+public:
+    class TaskGroup;
+
+    enum class Priority : size_t {
+        High = 0,
+        Normal = 1
+    };
+
+    // Up to `threads` workers, none of which is started yet.
+    explicit ThreadPool(size_t threads, std::chrono::milliseconds idle = std::chrono::seconds(30))
+        : workers(threads ? threads : 1), idle_timeout(idle) {
+        for (size_t i = 0; i < workers.size(); ++i) queues.push_back(std::make_unique<Queue>());
+    }
+
+    // Fire-and-forget; an exception escaping f is dropped.
+    template<class F>
+    void submit(F&& f, Priority priority = current_priority()) {
+        Push(Task(std::forward<F>(f)), priority);
+    }
+
+    template<class F, class... Args>
+    auto enqueue(F&& f, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
+        using return_type = typename std::invoke_result<F, Args...>::type;
+
+        std::packaged_task<return_type()> task(
+            [f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable {
+                return std::invoke(std::move(f), std::move(args)...);
+            });
+
+        std::future<return_type> res = task.get_future();
+        Push(Task(std::move(task)), current_priority());
+        return res;
+    }
+
+    // Calls fn(i) for every i in [0, count); the calling thread takes part.
+    template<class Fn>
+    void parallel_for(size_t count, Fn&& fn);
+
+    // Same, but the calling thread only ever runs fn: the caller and helper
+    // tasks claim indices from a shared counter, and the caller then waits
+    // for the indices already claimed, which are running. It never runs an
+    // unrelated task, so it may be called with a lock held and finishes even
+    // when every worker is blocked (the caller then does all the work).
+    template<class Fn>
+    void parallel_for_isolated(size_t count, Fn&& fn);
+
+    // Maximum number of workers, and the number currently started.
+    size_t size() const { return workers.size(); }
+    size_t running() const { return live.load(); }
+
+    // Lane of the task running on this thread; Normal outside the pool.
+    static Priority current_priority() { return current_lane; }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        high_condition.notify_all();
+        for (Worker& worker : workers) {
+            if (worker.thread.joinable()) worker.thread.join();
+        }
+    }
+
+private:
+    // Move-only type-erased callable with inline storage for small captures.
+    class Task {
+    public:
+        Task() = default;
+
+        template<class F, class D = std::decay_t<F>>
+            requires (!std::is_same_v<D, Task>)
+        explicit Task(F&& f) {
+            if constexpr (sizeof(D) <= INLINE_SIZE && alignof(D) <= alignof(std::max_align_t) &&
+                          std::is_nothrow_move_constructible_v<D>) {
+                new (storage) D(std::forward<F>(f));
+                ops = &InlineOps<D>;
+            } else {
+                new (storage) D*(new D(std::forward<F>(f)));
+                ops = &HeapOps<D>;
+            }
+        }
+
+        Task(Task&& other) noexcept : ops(other.ops) {
+            if (ops) ops->relocate(other.storage, storage);
+            other.ops = nullptr;
+        }
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (ops) ops->destroy(storage);
+                ops = other.ops;
+                if (ops) ops->relocate(other.storage, storage);
+                other.ops = nullptr;
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            if (ops) ops->destroy(storage);
+        }
+
+        void operator()() { ops->invoke(storage); }
+
+    private:
+        // Fits a capture of a few pointers plus a std::string (the smart-extract visit task).
+        static constexpr size_t INLINE_SIZE = 64;
+
+        struct Ops {
+            void (*invoke)(void*);
+            void (*relocate)(void* from, void* to);
+            void (*destroy)(void*);
+        };
+
+        template<class D>
+        static constexpr Ops InlineOps = {
+            [](void* p) { (*static_cast<D*>(p))(); },
+            [](void* from, void* to) {
+                new (to) D(std::move(*static_cast<D*>(from)));
+                static_cast<D*>(from)->~D();
+            },
+            [](void* p) { static_cast<D*>(p)->~D(); }
+        };
+
+        template<class D>
+        static constexpr Ops HeapOps = {
+            [](void* p) { (**static_cast<D**>(p))(); },
+            [](void* from, void* to) { new (to) D*(*static_cast<D**>(from)); },
+            [](void* p) { delete *static_cast<D**>(p); }
+        };
+
+        alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+        const Ops* ops = nullptr;
+    };
+
+    static constexpr size_t LANES = 2;
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks[LANES];
+    };
+
+    // Worker slot i owns queues[i]; guarded by sleep_mutex.
+    struct Worker {
+        std::thread thread;
+        bool running = false;
+    };
+
+    size_t Pending(size_t lanes = LANES) const {
+        size_t count = 0;
+        for (size_t lane = 0; lane < lanes; ++lane) count += pending[lane].load();
+        return count;
+    }
+
+    void Push(Task&& task, Priority priority) {
+        const size_t lane = (size_t)priority;
+
+        // Counted before stop is checked and before the task becomes visible:
+        // a worker only exits once stop is set and nothing is pending, and a
+        // thief can never take the count below zero.
+        pending[lane].fetch_add(1);
+        if (stop) {
+            pending[lane].fetch_sub(1);
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+
+        size_t target = current_pool == this ? current_index : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[target]->mutex);
+            queues[target]->tasks[lane].push_back(std::move(task));
+        }
+
+        // Paired with the sleeper's increment before it re-checks pending:
+        // either it sees the task, or this sees the sleeper and wakes it. A
+        // retiring worker gives up its slot before it stops counting as a
+        // sleeper, so seeing neither a sleeper nor a free slot means every
+        // worker is running and will come back for the task.
+        if (sleeping.load() > 0 || live.load() < workers.size()) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            if (idle_workers == 0 && live.load() < workers.size()) Grow();
+            condition.notify_one();
+            if (priority == Priority::High) high_condition.notify_one();
+        }
+    }
+
+    // Starts a worker in a free slot; called with sleep_mutex held.
+    void Grow() {
+        if (stop) return;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            Worker& worker = workers[i];
+            if (worker.running) continue;
+
+            // A retired worker only has to return from Run().
+            if (worker.thread.joinable()) worker.thread.join();
+            try {
+                worker.thread = std::thread([this, i] { Run(i); });
+            } catch (const std::system_error&) {
+                // Out of threads: the running workers, or a group waiter, take it.
+                return;
+            }
+            worker.running = true;
+            live.fetch_add(1);
+            return;
+        }
+    }
+
+    static constexpr size_t NO_QUEUE = ~size_t(0);
+
+    // Per lane, highest first: own deque from the back, then the others from
+    // the front. Threads outside the pool (NO_QUEUE) only steal. Lanes below
+    // `lanes` are left alone, so a High waiter never picks up Normal work.
+    bool Pop(size_t self, size_t lanes, Task& out, size_t& lane) {
+        for (lane = 0; lane < lanes; ++lane) {
+            if (pending[lane].load() == 0) continue;
+
+            if (self != NO_QUEUE) {
+                Queue& own = *queues[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks[lane].empty()) {
+                    out = std::move(own.tasks[lane].back());
+                    own.tasks[lane].pop_back();
+                    return true;
+                }
+            }
+            size_t first = self == NO_QUEUE ? 0 : self + 1;
+            for (size_t k = 0; k < queues.size(); ++k) {
+                size_t v = (first + k) % queues.size();
+                if (v == self) continue;
+                Queue& victim = *queues[v];
+                std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+                if (lock && !victim.tasks[lane].empty()) {
+                    out = std::move(victim.tasks[lane].front());
+                    victim.tasks[lane].pop_front();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Runs one queued task from the first `lanes` lanes on the calling
+    // thread; false if none was found.
+    bool RunPending(size_t lanes = LANES) {
+        Task task;
+        size_t lane;
+        if (!Pop(current_pool == this ? current_index : NO_QUEUE, lanes, task, lane)) return false;
+        pending[lane].fetch_sub(1);
+
+        Priority outer = current_lane;
+        current_lane = (Priority)lane;
+        try {
+            task();
+        } catch (...) {}
+        current_lane = outer;
+        return true;
+    }
+
+    // Sleeps until a task is queued in one of the first `lanes` lanes, the
+    // pool stops or done() holds. Waiters restricted to the High lane sleep on
+    // their own condition so a Normal push is never handed to one of them.
+    template<class Done>
+    void Idle(size_t lanes, Done done) {
+        std::condition_variable& cv = lanes == LANES ? condition : high_condition;
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleeping.fetch_add(1);
+        cv.wait(lock, [&] { return stop || Pending(lanes) > 0 || done(); });
+        sleeping.fetch_sub(1);
+
+        // A group waiter that leaves because its group finished may have
+        // consumed the wakeup of a push; pass it on.
+        if (done() && Pending(lanes) > 0) cv.notify_one();
+    }
+
+    void WakeAll() {
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        condition.notify_all();
+        high_condition.notify_all();
+    }
+
+    // Worker sleep; false once the worker has been idle for idle_timeout and
+    // has given up its slot.
+    bool Rest(size_t self) {
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleeping.fetch_add(1);
+        idle_workers++;
+        bool woken = condition.wait_for(lock, idle_timeout, [&] { return stop || Pending() > 0; });
+        idle_workers--;
+        if (!woken) {
+            workers[self].running = false;
+            live.fetch_sub(1);
+        }
+        sleeping.fetch_sub(1);
+        return woken;
+    }
+
+    void Run(size_t self) {
+        current_pool = this;
+        current_index = self;
+
+        for (;;) {
+            if (RunPending()) continue;
+
+            // Queued somewhere but not visible yet, or a victim was busy.
+            if (Pending() > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (stop || !Rest(self)) return;
+        }
+    }
+
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    static inline thread_local size_t current_index = 0;
+    static inline thread_local Priority current_lane = Priority::Normal;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<Worker> workers;
+    std::atomic<size_t> live{ 0 };
+    size_t idle_workers = 0;
+    const std::chrono::milliseconds idle_timeout;
+    std::atomic<size_t> pending[LANES] = {};
+    std::atomic<size_t> next_queue{ 0 };
+    std::atomic<int> sleeping{ 0 };
+    std::mutex sleep_mutex;
+    std::condition_variable condition;
+    std::condition_variable high_condition;
+    std::atomic<bool> stop{ false };
+};
+
+// Fork-join scope: run() queues subtasks and wait() returns once all of them
+// finished, rethrowing the first exception one of them threw. The waiting
+// thread executes queued tasks meanwhile, so a pool task may open a group and
+// wait on it; nested groups make progress even on a single worker. A High
+// group's waiter only helps with High tasks. Without a pool, or once it is
+// stopping, subtasks run inline.
+class ThreadPool::TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool* pool, Priority priority = current_priority()) : pool(pool), priority(priority) {}
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        try {
+            wait();
+        } catch (...) {}
+    }
+
+    template<class F>
+    void run(F&& f) {
+        outstanding.fetch_add(1);
+        Task task([this, f = std::forward<F>(f)]() mutable {
+            try {
+                f();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+            }
+            // The group may be gone as soon as the count reaches zero.
+            ThreadPool* owner = pool;
+            if (outstanding.fetch_sub(1) == 1 && owner) owner->WakeAll();
+        });
+
+        if (pool) {
+            try {
+                pool->Push(std::move(task), priority);
+                return;
+            } catch (const std::runtime_error&) {}
+        }
+        task();
+    }
+
+    void wait() {
+        size_t lanes = (size_t)priority + 1;
+        while (outstanding.load() > 0) {
+            if (pool->RunPending(lanes)) continue;
+            if (pool->Pending(lanes) > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            pool->Idle(lanes, [this] { return outstanding.load() == 0; });
+        }
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+private:
+    ThreadPool* pool;
+    Priority priority;
+    std::atomic<size_t> outstanding{ 0 };
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+template<class Fn>
+void ThreadPool::parallel_for(size_t count, Fn&& fn) {
+    TaskGroup group(this);
+    for (size_t i = 1; i < count; ++i) group.run([&fn, i] { fn(i); });
+    if (count) fn(0);
+    group.wait();
+}
+
+template<class Fn>
+void ThreadPool::parallel_for_isolated(size_t count, Fn&& fn) {
+    // Helpers may start after the caller returned; they only touch the
+    // shared state then, never fn.
+    struct State {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    auto drain = [count](State& s, Fn& f) {
+        for (size_t i; (i = s.next.fetch_add(1)) < count;) {
+            try {
+                f(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.error) s.error = std::current_exception();
+            }
+            if (s.done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(count, workers.size() + 1) - (count ? 1 : 0);
+    for (size_t h = 0; h < helpers; ++h) {
+        try {
+            submit([state, drain, f = &fn] { drain(*state, *f); });
+        } catch (const std::runtime_error&) {
+            break;
+        }
+    }
+    drain(*state, fn);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == count; });
+    if (state->error) std::rethrow_exception(state->error);
+}
@@ -2,182 +2,682 @@
 #define PAK_INDEX_H
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <memory>
 #include <algorithm>
-#include <shared_mutex>
+#include <atomic>
+#include <mutex>
 #include <future>
 #include <functional>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <climits>
 
 class PakEntry;
 class ThreadPool;
 extern std::unique_ptr<ThreadPool> g_ThreadPool;
+void LogInfo(const std::string& message);
+
+// Blocked Bloom filter over folded path hashes. Every key sets a few bits in a
+// single 64-bit word, so a negative answer costs one memory access and lets
+// lookups of absent paths skip the hash table probe.
+class PathBloom {
+public:
+	void Reset(size_t keys) {
+		size_t words = 1;
+		while (words * 64 < keys * BITS_PER_KEY) words <<= 1;
+		m_Words.assign(words, 0);
+	}
+
+	void Add(uint64_t h) { m_Words[Word(h)] |= Mask(h); }
+
+	// Always true for a filter that was never sized.
+	bool MayContain(uint64_t h) const {
+		if (m_Words.empty()) return true;
+		uint64_t m = Mask(h);
+		return (m_Words[Word(h)] & m) == m;
+	}
+
+	size_t MemoryUsage() const { return m_Words.capacity() * sizeof(uint64_t); }
 
-class PakIndex {
 private:
-	mutable std::shared_mutex m_IndexMutex;
+	static constexpr size_t BITS_PER_KEY = 16;
+	static constexpr int BITS_SET = 6;
 
-	std::unordered_map<std::string, int> m_PathToIndex;
-	std::unordered_map<std::string, std::vector<int>> m_FileNameToIndex;
+	// The low hash bits already pick table slots; the filter uses the top 36
+	// bits for bit positions and a remix of the whole hash for the word.
+	size_t Word(uint64_t h) const { return (size_t)((h * 0x9E3779B97F4A7C15ull) >> 32) & (m_Words.size() - 1); }
 
-	inline std::string Normalize(const std::string& s) const {
-		std::string res = s;
-		std::transform(res.begin(), res.end(), res.begin(), ::tolower);
-		std::replace(res.begin(), res.end(), '/', '\\');
-		return res;
+	static uint64_t Mask(uint64_t h) {
+		uint64_t m = 0;
+		h >>= 28;
+		for (int k = 0; k < BITS_SET; ++k, h >>= 6) m |= 1ull << (h & 63);
+		return m;
 	}
 
-	inline std::string GetFileName(const std::string& path) const {
+	std::vector<uint64_t> m_Words;
+};
+
+// Flat, arena-backed path index.
+//
+// Every entry name is folded (lowercase, '/' -> '\\') once into a shared
+// arena; the hash tables only hold 32-bit entry ids plus a 32-bit slice of
+// the precomputed hash. Queries are hashed and compared with the same folding
+// applied on the fly, so lookups never allocate.
+class PakIndex {
+public:
+	static constexpr uint32_t NPOS = 0xFFFFFFFFu;
+
+	static inline unsigned char FoldChar(unsigned char c) {
+		if (c >= 'A' && c <= 'Z') return (unsigned char)(c + 32);
+		if (c == '/') return '\\';
+		return c;
+	}
+
+	static inline uint64_t HashStep(uint64_t h, unsigned char c) {
+		return (h ^ FoldChar(c)) * 0x100000001B3ull;
+	}
+
+	static constexpr uint64_t HASH_SEED = 0xCBF29CE484222325ull;
+
+	static inline uint64_t HashFolded(std::string_view s, uint64_t h = HASH_SEED) {
+		for (char c : s) h = HashStep(h, (unsigned char)c);
+		return h;
+	}
+
+	static inline std::string_view FileNamePart(std::string_view path) {
 		size_t lastSlash = path.find_last_of("\\/");
-		if (lastSlash == std::string::npos) return path;
-		return path.substr(lastSlash + 1);
+		return lastSlash == std::string_view::npos ? path : path.substr(lastSlash + 1);
+	}
+
+	// Arena strings are already folded, so only the query side is folded here.
+	static bool EqualsFolded(std::string_view prefix, std::string_view query, std::string_view stored) {
+		if (prefix.size() + query.size() != stored.size()) return false;
+		size_t i = 0;
+		for (char c : prefix) if (FoldChar((unsigned char)c) != (unsigned char)stored[i++]) return false;
+		for (char c : query) if (FoldChar((unsigned char)c) != (unsigned char)stored[i++]) return false;
+		return true;
+	}
+
+private:
+	struct Slot {
+		uint32_t hash;
+		uint32_t id;
+	};
+
+	struct EntryRef {
+		uint32_t offset;
+		uint16_t length;
+		uint16_t nameStart;
+	};
+
+	// Open-addressing table split into power-of-two partitions selected by the
+	// top hash bits, so every partition can be filled by its own worker.
+	struct Table {
+		std::vector<Slot> slots;
+		std::vector<uint32_t> base;
+		std::vector<uint32_t> mask;
+		uint32_t partitionShift = 64;
+
+		uint32_t Partition(uint64_t h) const {
+			return partitionShift >= 64 ? 0 : (uint32_t)(h >> partitionShift);
+		}
+	};
+
+	// Trigram postings over distinct file names plus all paths in sorted
+	// order. Only substring and subtree queries need them, so they are built
+	// on first use rather than with every archive open.
+	struct NameGrams {
+		std::vector<uint32_t> keys;
+		std::vector<uint32_t> starts;
+		std::vector<uint32_t> postings;
+		std::vector<uint32_t> sortedPaths;
+	};
+
+	mutable std::mutex m_GramsMutex;
+	mutable std::atomic<std::shared_ptr<const NameGrams>> m_Grams;
+
+	std::vector<char> m_Arena;
+	std::vector<EntryRef> m_Refs;
+	std::vector<uint32_t> m_NextSameName;
+	std::vector<uint64_t> m_PathHashes;
+	Table m_Paths;
+	Table m_Names;
+	PathBloom m_Bloom;
+	size_t m_PathCount = 0;
+
+	std::string_view PathOf(uint32_t id) const {
+		const EntryRef& r = m_Refs[id];
+		return std::string_view(m_Arena.data() + r.offset, r.length);
 	}
 
-	int GetPriority(const std::string& path) const {
-		if (path.find("_bcr.edds") != std::string::npos) return 1;
-		if (path.find("_mcr.edds") != std::string::npos) return 2;
-		if (path.find("_co.edds") != std::string::npos) return 3;
-		if (path.find("_nohq.edds") != std::string::npos) return 4;
+	std::string_view NameOf(uint32_t id) const {
+		const EntryRef& r = m_Refs[id];
+		return std::string_view(m_Arena.data() + r.offset + r.nameStart, r.length - r.nameStart);
+	}
+
+	static int GetPriority(std::string_view path) {
+		if (path.find("_bcr.edds") != std::string_view::npos) return 1;
+		if (path.find("_mcr.edds") != std::string_view::npos) return 2;
+		if (path.find("_co.edds") != std::string_view::npos) return 3;
+		if (path.find("_nohq.edds") != std::string_view::npos) return 4;
 		return 10;
 	}
 
-	void BuildSerial(const std::vector<std::shared_ptr<PakEntry>>& entries) {
-		m_PathToIndex.reserve(entries.size());
-		m_FileNameToIndex.reserve(entries.size() / 2);
+	template <typename KeyOf>
+	uint32_t Probe(const Table& t, uint64_t h, std::string_view prefix, std::string_view query, KeyOf keyOf) const {
+		if (t.slots.empty()) return NPOS;
+		uint32_t p = t.Partition(h);
+		uint32_t base = t.base[p], mask = t.mask[p];
+		for (uint32_t i = (uint32_t)h & mask;; i = (i + 1) & mask) {
+			const Slot& s = t.slots[base + i];
+			if (s.id == NPOS) return NPOS;
+			if (s.hash == (uint32_t)h && EqualsFolded(prefix, query, keyOf(s.id))) return s.id;
+		}
+	}
 
-		for (int i = 0; i < (int)entries.size(); ++i) {
-			if (!entries[i] || entries[i]->isDirectory) continue;
+	static void SizeTable(Table& t, const std::vector<uint64_t>& hashes, const std::vector<uint8_t>& use, uint32_t partitionBits) {
+		uint32_t partitions = 1u << partitionBits;
+		t.partitionShift = partitionBits == 0 ? 64 : 64 - partitionBits;
 
-			std::string normPath = Normalize(entries[i]->name);
-			std::string fName = GetFileName(normPath);
+		std::vector<uint32_t> counts(partitions, 0);
+		for (size_t i = 0; i < hashes.size(); ++i) {
+			if (use[i]) counts[t.Partition(hashes[i])]++;
+		}
+
+		t.base.assign(partitions, 0);
+		t.mask.assign(partitions, 0);
+		uint32_t total = 0;
+		for (uint32_t p = 0; p < partitions; ++p) {
+			uint32_t cap = 8;
+			while (cap < counts[p] * 2 + 1) cap <<= 1;
+			t.base[p] = total;
+			t.mask[p] = cap - 1;
+			total += cap;
+		}
+		t.slots.assign(total, Slot{ 0, NPOS });
+	}
+
+	void FillPartition(uint32_t p, const std::vector<std::shared_ptr<PakEntry>>& entries,
+					   const std::vector<uint64_t>& nameHashes) {
+		const uint32_t base = m_Paths.base[p], mask = m_Paths.mask[p];
+		const uint32_t nbase = m_Names.base[p], nmask = m_Names.mask[p];
+
+		// Walk ids downwards: file-name chains are prepended and come out in
+		// ascending order, and duplicate paths resolve to the earliest best entry.
+		for (size_t k = m_Refs.size(); k-- > 0;) {
+			uint32_t id = (uint32_t)k;
+			if (m_Refs[id].offset == NPOS) continue;
+
+			uint64_t h = m_PathHashes[id];
+			if (m_Paths.Partition(h) == p) {
+				for (uint32_t i = (uint32_t)h & mask;; i = (i + 1) & mask) {
+					Slot& s = m_Paths.slots[base + i];
+					if (s.id == NPOS) { s = { (uint32_t)h, id }; break; }
+					if (s.hash == (uint32_t)h && PathOf(s.id) == PathOf(id)) {
+						bool curDir = entries[s.id]->isDirectory, newDir = entries[id]->isDirectory;
+						if (curDir != newDir ? !newDir : GetPriority(PathOf(id)) <= GetPriority(PathOf(s.id))) s.id = id;
+						break;
+					}
+				}
+			}
+
+			if (entries[id]->isDirectory) continue;
 
-			auto it = m_PathToIndex.find(normPath);
-			if (it != m_PathToIndex.end()) {
-				if (GetPriority(entries[i]->name) < GetPriority(entries[it->second]->name)) {
-					m_PathToIndex[normPath] = i;
+			uint64_t nh = nameHashes[id];
+			if (m_Names.Partition(nh) == p) {
+				for (uint32_t i = (uint32_t)nh & nmask;; i = (i + 1) & nmask) {
+					Slot& s = m_Names.slots[nbase + i];
+					if (s.id == NPOS) { s = { (uint32_t)nh, id }; break; }
+					if (s.hash == (uint32_t)nh && NameOf(s.id) == NameOf(id)) {
+						m_NextSameName[id] = s.id;
+						s.id = id;
+						break;
+					}
 				}
-			} else {
-				m_PathToIndex[normPath] = i;
 			}
-			m_FileNameToIndex[fName].push_back(i);
 		}
 	}
 
-public:
-	PakIndex() = default;
+	template <typename Fn>
+	static void ParallelFor(size_t count, bool parallel, Fn fn) {
+		if (!parallel || count < 2) {
+			for (size_t i = 0; i < count; ++i) fn(i);
+			return;
+		}
+		// Isolated: callers build under locks (Grams) or while other threads
+		// wait for the archive (GameCatalog::OpenLazily), so the builder must
+		// not pick up unrelated pool tasks that could need the same.
+		g_ThreadPool->parallel_for_isolated(count, fn);
+	}
 
-	void Build(const std::vector<std::shared_ptr<PakEntry>>& entries) {
-		std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
-		m_PathToIndex.clear();
-		m_FileNameToIndex.clear();
+	static inline uint32_t Trigram(std::string_view s, size_t i) {
+		return ((uint32_t)FoldChar((unsigned char)s[i]) << 16) |
+			   ((uint32_t)FoldChar((unsigned char)s[i + 1]) << 8) |
+			   (uint32_t)FoldChar((unsigned char)s[i + 2]);
+	}
 
-		if (entries.empty()) return;
+	std::shared_ptr<const NameGrams> BuildGrams() const {
+		auto g = std::make_shared<NameGrams>();
 
-		if (entries.size() < 1000 || !g_ThreadPool) {
-			BuildSerial(entries);
-			return;
+		std::vector<uint32_t> heads;
+		for (const Slot& s : m_Names.slots) {
+			if (s.id != NPOS) heads.push_back(s.id);
+		}
+		std::sort(heads.begin(), heads.end());
+
+		size_t chunks = heads.size() >= 1000 && g_ThreadPool ? std::max<size_t>(1, std::thread::hardware_concurrency()) : 1;
+		size_t chunkSize = (heads.size() + chunks - 1) / std::max<size_t>(1, chunks);
+		std::vector<std::vector<uint64_t>> parts(chunks);
+
+		ParallelFor(chunks, chunks > 1, [&](size_t c) {
+			auto& out = parts[c];
+			size_t end = std::min(heads.size(), (c + 1) * chunkSize);
+			for (size_t k = c * chunkSize; k < end; ++k) {
+				std::string_view name = NameOf(heads[k]);
+				for (size_t i = 0; i + 3 <= name.size(); ++i) {
+					out.push_back(((uint64_t)Trigram(name, i) << 32) | heads[k]);
+				}
+			}
+			std::sort(out.begin(), out.end());
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+		});
+
+		std::vector<uint64_t> pairs;
+		for (auto& part : parts) {
+			size_t mid = pairs.size();
+			pairs.insert(pairs.end(), part.begin(), part.end());
+			std::inplace_merge(pairs.begin(), pairs.begin() + mid, pairs.end());
+			std::vector<uint64_t>().swap(part);
+		}
+		pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+		g->postings.reserve(pairs.size());
+		for (uint64_t pr : pairs) {
+			uint32_t key = (uint32_t)(pr >> 32);
+			if (g->keys.empty() || g->keys.back() != key) {
+				g->keys.push_back(key);
+				g->starts.push_back((uint32_t)g->postings.size());
+			}
+			g->postings.push_back((uint32_t)pr);
 		}
+		g->starts.push_back((uint32_t)g->postings.size());
 
-		size_t numEntries = entries.size();
-		size_t numThreads = std::thread::hardware_concurrency();
-		if (numThreads == 0) numThreads = 2;
-		size_t chunkSize = (numEntries + numThreads - 1) / numThreads;
+		for (uint32_t id = 0; id < (uint32_t)m_Refs.size(); ++id) {
+			if (m_Refs[id].offset != NPOS) g->sortedPaths.push_back(id);
+		}
+		std::sort(g->sortedPaths.begin(), g->sortedPaths.end(), [this](uint32_t a, uint32_t b) { return PathOf(a) < PathOf(b); });
 
-		using PartialResult = std::pair<std::unordered_map<std::string, int>, std::unordered_map<std::string, std::vector<int>>>;
-		std::vector<std::future<PartialResult>> futures;
+		LogInfo("[PakIndex] Name trigram index: " + std::to_string(g->keys.size()) + " grams, " +
+				std::to_string(g->postings.size()) + " postings");
+		return g;
+	}
 
-		for (size_t i = 0; i < numThreads; ++i) {
-			size_t start = i * chunkSize;
-			size_t end = std::min(start + chunkSize, numEntries);
-			if (start >= numEntries) break;
+	// Readers only take the mutex until the postings exist; afterwards the
+	// published pointer is never replaced for the lifetime of the index. The
+	// builder runs nothing but its own chunks while it holds the mutex, so
+	// readers blocked on it always see it finish.
+	const NameGrams& Grams() const {
+		if (auto g = m_Grams.load(std::memory_order_acquire)) return *g;
+		std::lock_guard<std::mutex> lock(m_GramsMutex);
+		if (!m_Grams.load()) {
+			auto built = BuildGrams();
+			std::shared_ptr<const NameGrams> expected;
+			m_Grams.compare_exchange_strong(expected, built);
+		}
+		return *m_Grams.load();
+	}
 
-			futures.push_back(g_ThreadPool->enqueue([this, &entries, start, end]() {
-				PartialResult res;
-				for (size_t j = start; j < end; ++j) {
-					if (!entries[j] || entries[j]->isDirectory) continue;
+	// Bit-parallel (Myers/Hyyrö) edit distance against one name stem of up to
+	// 64 bytes: one pass of a few word operations per candidate character.
+	struct EditPattern {
+		uint64_t peq[256] = {};
+		uint64_t last = 0;
+		int length = 0;
 
-					std::string normPath = Normalize(entries[j]->name);
-					std::string fName = GetFileName(normPath);
+		explicit EditPattern(std::string_view pattern) : length((int)pattern.size()) {
+			for (size_t i = 0; i < pattern.size(); ++i) peq[(unsigned char)pattern[i]] |= 1ull << i;
+			last = length ? 1ull << (length - 1) : 0;
+		}
 
-					auto it = res.first.find(normPath);
-					if (it != res.first.end()) {
-						if (GetPriority(entries[j]->name) < GetPriority(entries[it->second]->name)) {
-							res.first[normPath] = (int)j;
-						}
-					} else {
-						res.first[normPath] = (int)j;
+		int Distance(std::string_view text) const {
+			if (length == 0) return (int)text.size();
+			uint64_t pv = ~0ull, mv = 0;
+			int score = length;
+			for (char c : text) {
+				uint64_t eq = peq[(unsigned char)c];
+				uint64_t xv = eq | mv;
+				uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+				uint64_t ph = mv | ~(xh | pv);
+				uint64_t mh = pv & xh;
+				if (ph & last) score++;
+				else if (mh & last) score--;
+				ph = (ph << 1) | 1;
+				mh <<= 1;
+				pv = mh | ~(xv | ph);
+				mv = ph & xv;
+			}
+			return score;
+		}
+	};
+
+	// Folders present in only one of the two directory parts.
+	static int FolderDistance(std::string_view a, std::string_view b) {
+		auto missing = [](std::string_view from, std::string_view in) {
+			int count = 0;
+			size_t pos = 0;
+			while (pos < from.size()) {
+				size_t end = from.find('\\', pos);
+				if (end == std::string_view::npos) end = from.size();
+				std::string_view segment = from.substr(pos, end - pos);
+				if (!segment.empty()) {
+					std::string_view rest = in;
+					bool found = false;
+					while (!found && !rest.empty()) {
+						size_t cut = rest.find('\\');
+						found = rest.substr(0, cut) == segment;
+						rest = cut == std::string_view::npos ? std::string_view() : rest.substr(cut + 1);
 					}
-					res.second[fName].push_back((int)j);
+					count += !found;
 				}
-				return res;
-			}));
+				pos = end + 1;
+			}
+			return count;
+		};
+		return std::min(63, missing(a, b) + missing(b, a));
+	}
+
+	void AppendChain(uint32_t head, std::vector<int>& out) const {
+		for (uint32_t idx = head; idx != NPOS; idx = m_NextSameName[idx]) out.push_back((int)idx);
+	}
+
+	void Build(const std::vector<std::shared_ptr<PakEntry>>& entries) {
+		auto t0 = std::chrono::steady_clock::now();
+		if (entries.empty()) return;
+
+		const size_t n = entries.size();
+		const bool parallel = n >= 1000 && g_ThreadPool;
+
+		// Arena layout is a serial prefix sum over name lengths; the folding
+		// and hashing that fills it is embarrassingly parallel.
+		m_Refs.resize(n);
+		m_NextSameName.assign(n, NPOS);
+		uint64_t arenaSize = 0;
+		for (size_t i = 0; i < n; ++i) {
+			const PakEntry* e = entries[i].get();
+			if (!e || e->name.empty() || e->name.size() > 0xFFFF) {
+				m_Refs[i] = { NPOS, 0, 0 };
+				continue;
+			}
+			std::string_view name(e->name);
+			m_Refs[i] = { (uint32_t)arenaSize, (uint16_t)name.size(), (uint16_t)(name.size() - FileNamePart(name).size()) };
+			arenaSize += name.size();
 		}
+		m_Arena.resize((size_t)arenaSize);
 
-		for (auto& f : futures) {
-			PartialResult part = f.get();
-			for (auto const& [path, idx] : part.first) {
-				auto it = m_PathToIndex.find(path);
-				if (it != m_PathToIndex.end()) {
-					if (GetPriority(entries[idx]->name) < GetPriority(entries[it->second]->name)) {
-						m_PathToIndex[path] = idx;
-					}
-				} else {
-					m_PathToIndex[path] = idx;
+		m_PathHashes.assign(n, 0);
+		std::vector<uint64_t> nameHashes(n, 0);
+		std::vector<uint8_t> usePath(n, 0), useName(n, 0);
+
+		size_t chunks = parallel ? std::max<size_t>(1, std::thread::hardware_concurrency()) : 1;
+		size_t chunkSize = (n + chunks - 1) / chunks;
+
+		ParallelFor(chunks, parallel, [&](size_t c) {
+			size_t end = std::min(n, (c + 1) * chunkSize);
+			for (size_t i = c * chunkSize; i < end; ++i) {
+				const EntryRef& r = m_Refs[i];
+				if (r.offset == NPOS) continue;
+				const std::string& src = entries[i]->name;
+				char* dst = m_Arena.data() + r.offset;
+				for (size_t j = 0; j < src.size(); ++j) dst[j] = (char)FoldChar((unsigned char)src[j]);
+
+				m_PathHashes[i] = HashFolded(PathOf((uint32_t)i));
+				usePath[i] = 1;
+				if (!entries[i]->isDirectory) {
+					nameHashes[i] = HashFolded(NameOf((uint32_t)i));
+					useName[i] = 1;
 				}
 			}
-			for (auto& [name, indices] : part.second) {
-				auto& masterIndices = m_FileNameToIndex[name];
-				masterIndices.insert(masterIndices.end(), indices.begin(), indices.end());
+		});
+
+		uint32_t partitionBits = parallel ? 4 : 0;
+		SizeTable(m_Paths, m_PathHashes, usePath, partitionBits);
+		SizeTable(m_Names, nameHashes, useName, partitionBits);
+
+		ParallelFor((size_t)1 << partitionBits, parallel, [&](size_t p) {
+			FillPartition((uint32_t)p, entries, nameHashes);
+		});
+
+		for (uint8_t u : usePath) m_PathCount += u;
+
+		m_Bloom.Reset(m_PathCount);
+		for (size_t i = 0; i < n; ++i) {
+			if (usePath[i]) m_Bloom.Add(m_PathHashes[i]);
+		}
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+		LogInfo("[PakIndex] Indexed " + std::to_string(m_PathCount) + " paths in " + std::to_string(ms) +
+				" ms, " + std::to_string(MemoryUsage() / 1024) + " KB");
+	}
+
+public:
+	// An index is immutable once constructed: it is built off to the side and
+	// published as a shared_ptr<const PakIndex>, so lookups take no locks.
+	explicit PakIndex(const std::vector<std::shared_ptr<PakEntry>>& entries) {
+		Build(entries);
+	}
+
+	PakIndex(const PakIndex&) = delete;
+	PakIndex& operator=(const PakIndex&) = delete;
+
+	size_t MemoryUsage() const {
+		return m_Arena.capacity() + m_Refs.capacity() * sizeof(EntryRef) +
+			   m_NextSameName.capacity() * sizeof(uint32_t) + m_PathHashes.capacity() * sizeof(uint64_t) +
+			   (m_Paths.slots.capacity() + m_Names.slots.capacity()) * sizeof(Slot) + m_Bloom.MemoryUsage();
+	}
+
+	// False means prefix + path is definitely not indexed.
+	bool MayContain(std::string_view path, std::string_view prefix = {}) const {
+		return m_Bloom.MayContain(HashFolded(path, HashFolded(prefix)));
+	}
+
+	// Folded path and its precomputed hash, for callers merging several indexes.
+	std::string_view PathAt(uint32_t id) const { return PathOf(id); }
+	uint64_t PathHashAt(uint32_t id) const { return m_PathHashes[id]; }
+
+	// Visits every distinct indexed path once, with the entry id that won it.
+	template <typename Fn>
+	void ForEachPath(Fn fn) const {
+		for (const Slot& s : m_Paths.slots) {
+			if (s.id != NPOS) fn(s.id, m_PathHashes[s.id]);
+		}
+	}
+
+	// Exact, case- and slash-insensitive lookup of prefix + path. Returns -1 when absent.
+	int FindPath(std::string_view path, std::string_view prefix = {}) const {
+		uint64_t h = HashFolded(path, HashFolded(prefix));
+		if (!m_Bloom.MayContain(h)) return -1;
+		uint32_t id = Probe(m_Paths, h, prefix, path, [this](uint32_t i) { return PathOf(i); });
+		return id == NPOS ? -1 : (int)id;
+	}
+
+	int FindBestMatch(std::string_view fileName) const {
+		if (m_PathCount == 0) return -1;
+
+		uint64_t h = HashFolded(fileName);
+		if (m_Bloom.MayContain(h)) {
+			uint32_t id = Probe(m_Paths, h, {}, fileName, [this](uint32_t i) { return PathOf(i); });
+			if (id != NPOS) return (int)id;
+		}
+
+		std::string_view justFileName = FileNamePart(fileName);
+		uint32_t head = Probe(m_Names, HashFolded(justFileName), {}, justFileName, [this](uint32_t i) { return NameOf(i); });
+
+		int bestIdx = -1;
+		int bestScore = 101;
+		for (uint32_t idx = head; idx != NPOS; idx = m_NextSameName[idx]) {
+			int score = GetPriority(PathOf(idx));
+			if (score < bestScore) {
+				bestScore = score;
+				bestIdx = (int)idx;
 			}
 		}
+		return bestIdx;
 	}
 
-	int FindBestMatch(const std::string& fileName, const std::vector<std::shared_ptr<PakEntry>>& entries) const {
-		std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
-		if (m_PathToIndex.empty()) return -1;
+	struct Near {
+		int index = -1;
+		int score = INT_MAX;
+	};
+
+	// Closest file entry to a path that is not indexed, for dependencies that
+	// a mod repackaged under other folders or a slightly different name. The
+	// name stem (at most 64 bytes) may be up to two edits away (the extension must match) and
+	// ties go to the entry sharing the most folders. Candidates come from the
+	// trigram postings: k edits break at most k of k + 1 disjoint trigrams of
+	// the stem, so only the k + 1 rarest ones of a tiling are looked up.
+	Near FindNearest(std::string_view path) const {
+		Near best;
+		if (m_Names.slots.empty()) return best;
+
+		std::string query(path);
+		std::transform(query.begin(), query.end(), query.begin(), [](char c) { return (char)FoldChar((unsigned char)c); });
+		std::string_view name = FileNamePart(query);
+		std::string_view dir = std::string_view(query).substr(0, query.size() - name.size());
+
+		size_t dot = name.find_last_of('.');
+		if (dot == std::string_view::npos || dot > 64) return best;
+		std::string_view stem = name.substr(0, dot), ext = name.substr(dot);
+
+		int maxEdits = std::min<int>(2, (int)stem.size() / 3 - 1);
+		if (maxEdits < 0) return best;
 
-		std::string searchName = Normalize(fileName);
+		const NameGrams& g = Grams();
+		auto postingsOf = [&g](uint32_t gram) -> std::pair<uint32_t, uint32_t> {
+			auto it = std::lower_bound(g.keys.begin(), g.keys.end(), gram);
+			if (it == g.keys.end() || *it != gram) return { 0, 0 };
+			size_t k = it - g.keys.begin();
+			return { g.starts[k], g.starts[k + 1] };
+		};
 
-		auto itPath = m_PathToIndex.find(searchName);
-		if (itPath != m_PathToIndex.end()) return itPath->second;
+		std::vector<std::pair<uint32_t, uint32_t>> chosen;
+		size_t chosenCost = SIZE_MAX;
+		for (size_t start = 0; start < 3; ++start) {
+			std::vector<std::pair<uint32_t, uint32_t>> ranges;
+			for (size_t i = start; i + 3 <= stem.size(); i += 3) ranges.push_back(postingsOf(Trigram(stem, i)));
+			if (ranges.size() < (size_t)maxEdits + 1) continue;
 
-		std::string justFileName = GetFileName(searchName);
-		auto itFile = m_FileNameToIndex.find(justFileName);
+			std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+			ranges.resize(maxEdits + 1);
+			size_t cost = 0;
+			for (const auto& r : ranges) cost += r.second - r.first;
+			if (cost < chosenCost) {
+				chosenCost = cost;
+				chosen = std::move(ranges);
+			}
+		}
+
+		// A name sharing several of the chosen grams is simply scored again;
+		// that is cheaper than merging the postings.
+		EditPattern pattern(stem);
+		for (const auto& r : chosen) {
+			for (uint32_t k = r.first; k < r.second; ++k) {
+				uint32_t head = g.postings[k];
+
+				// Lengths live in the refs, so most candidates are rejected without touching the arena.
+				int lengthDelta = (int)(m_Refs[head].length - m_Refs[head].nameStart) - (int)name.size();
+				if (lengthDelta < -maxEdits || lengthDelta > maxEdits) continue;
+
+				std::string_view candidate = NameOf(head);
+				if (candidate.size() <= ext.size() || candidate.substr(candidate.size() - ext.size()) != ext) continue;
 
-		if (itFile != m_FileNameToIndex.end()) {
-			int bestIdx = -1;
-			int bestScore = 101;
-			for (int idx : itFile->second) {
-				int score = GetPriority(entries[idx]->name);
-				if (score < bestScore) {
-					bestScore = score;
-					bestIdx = idx;
+				int edits = pattern.Distance(candidate.substr(0, candidate.size() - ext.size()));
+				if (edits > maxEdits) continue;
+
+				for (uint32_t id = head; id != NPOS; id = m_NextSameName[id]) {
+					int score = edits * 64 + FolderDistance(dir, PathOf(id).substr(0, m_Refs[id].nameStart));
+					if (score < best.score) {
+						best.score = score;
+						best.index = (int)id;
+					}
 				}
 			}
-			return bestIdx;
 		}
-		return -1;
+		return best;
 	}
 
-	std::vector<int> GetRelatedEntries(const std::string& baseName) const {
-		std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
-		std::string cleanName = baseName;
-		size_t dotPos = cleanName.find_last_of('.');
-		if (dotPos != std::string::npos) cleanName = cleanName.substr(0, dotPos);
+	// Every file entry whose file name contains the given text (case- and
+	// slash-insensitive). Uses trigram postings, so the cost follows the
+	// rarest trigram of the needle rather than the total name length.
+	std::vector<int> FindNamesContaining(std::string_view needle) const {
+		std::vector<int> result;
+		if (m_Names.slots.empty()) return result;
 
-		std::string normBase = Normalize(cleanName);
-		std::vector<int> related;
+		std::string folded(needle);
+		std::transform(folded.begin(), folded.end(), folded.begin(), [](char c) { return (char)FoldChar((unsigned char)c); });
 
-		for (auto const& [fName, indices] : m_FileNameToIndex) {
-			if (fName.find(normBase) != std::string::npos) {
-				for (int idx : indices) {
-					related.push_back(idx);
-				}
+		if (folded.size() < 3) {
+			for (const Slot& s : m_Names.slots) {
+				if (s.id != NPOS && NameOf(s.id).find(folded) != std::string_view::npos) AppendChain(s.id, result);
 			}
+			std::sort(result.begin(), result.end());
+			return result;
+		}
+
+		const NameGrams& g = Grams();
+
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+			auto it = std::lower_bound(g.keys.begin(), g.keys.end(), Trigram(folded, i));
+			if (it == g.keys.end() || *it != Trigram(folded, i)) return result;
+			size_t k = it - g.keys.begin();
+			ranges.push_back({ g.starts[k], g.starts[k + 1] });
+		}
+		std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+		ranges.erase(std::unique(ranges.begin(), ranges.end()), ranges.end());
+
+		std::vector<uint32_t> candidates(g.postings.begin() + ranges[0].first, g.postings.begin() + ranges[0].second);
+		for (size_t r = 1; r < ranges.size() && !candidates.empty(); ++r) {
+			auto first = g.postings.begin() + ranges[r].first, last = g.postings.begin() + ranges[r].second;
+			candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+				[&](uint32_t id) { return !std::binary_search(first, last, id); }), candidates.end());
+		}
+
+		for (uint32_t head : candidates) {
+			if (NameOf(head).find(folded) != std::string_view::npos) AppendChain(head, result);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	// All entries (files and directories) below the given directory.
+	std::vector<int> GetEntriesUnder(std::string_view directory) const {
+		std::vector<int> result;
+		if (m_Refs.empty()) return result;
+
+		std::string prefix(directory);
+		std::transform(prefix.begin(), prefix.end(), prefix.begin(), [](char c) { return (char)FoldChar((unsigned char)c); });
+		while (!prefix.empty() && prefix.back() == '\\') prefix.pop_back();
+		if (!prefix.empty()) prefix += '\\';
+
+		const NameGrams& g = Grams();
+		auto it = std::lower_bound(g.sortedPaths.begin(), g.sortedPaths.end(), std::string_view(prefix),
+			[this](uint32_t id, std::string_view p) { return PathOf(id) < p; });
+		for (; it != g.sortedPaths.end() && PathOf(*it).substr(0, prefix.size()) == prefix; ++it) {
+			result.push_back((int)*it);
 		}
-		return related;
+		return result;
+	}
+
+	std::vector<int> GetRelatedEntries(const std::string& baseName) const {
+		std::string_view cleanName(baseName);
+		size_t dotPos = cleanName.find_last_of('.');
+		if (dotPos != std::string_view::npos) cleanName = cleanName.substr(0, dotPos);
+
+		return FindNamesContaining(cleanName);
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,26 +1,26 @@
-#ifndef IDC_STATIC
-#define IDC_STATIC (-1)
-#endif
-
-#define IDD_ARMAPAK_SETTINGS            101
-#define IDD_ABOUTBOX                    102
-#define IDD_EXTRACT_OPTIONS             103
-
-#define IDB_LOGO                        104
-
-#define IDC_LOGO                        1002
-#define IDC_ABOUT_BUTTON                1003
-#define IDC_ENABLE_LOG_INFO             1004
-#define IDC_ENABLE_SMART_EXTRACT        1005
-#define IDC_KEEP_STRUCT                 1006
-#define IDC_SHOW_EXTRACT_PROMPT         1007
-
-#define IDC_TARGET_FORMAT               1201
-
-#define IDC_ABOUT_LOGO                  1100
-#define IDC_ABOUT_VERSION_TEXT          1101
-#define IDC_ABOUT_AUTHOR_TEXT          1102
-#define IDC_ABOUT_SUPPORT_TEXT          1103
-#define IDC_CONV_WARNING                1020
-
-#define IDC_OPEN_WORKBENCH              1200
+#ifndef IDC_STATIC
+#define IDC_STATIC (-1)
+#endif
+
+#define IDD_ARMAPAK_SETTINGS            101
+#define IDD_ABOUTBOX                    102
+#define IDD_EXTRACT_OPTIONS             103
+
+#define IDB_LOGO                        104
+
+#define IDC_LOGO                        1002
+#define IDC_ABOUT_BUTTON                1003
+#define IDC_ENABLE_LOG_INFO             1004
+#define IDC_ENABLE_SMART_EXTRACT        1005
+#define IDC_KEEP_STRUCT                 1006
+#define IDC_SHOW_EXTRACT_PROMPT         1007
+
+#define IDC_TARGET_FORMAT               1201
+
+#define IDC_ABOUT_LOGO                  1100
+#define IDC_ABOUT_VERSION_TEXT          1101
+#define IDC_ABOUT_AUTHOR_TEXT          1102
+#define IDC_ABOUT_SUPPORT_TEXT          1103
+#define IDC_CONV_WARNING                1020
+
+#define IDC_OPEN_WORKBENCH              1200
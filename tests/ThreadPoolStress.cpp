@@ -0,0 +1,194 @@
+// Nested parallel regions on small pools. Every scenario has to finish; a
+// watchdog fails the run if one deadlocks. A pool of one worker is the
+// hardest case: every wait has to make progress by helping, or, for
+// parallel_for_isolated, by doing all of the work on the caller.
+#include "ThreadPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <condition_variable>
+
+static int g_Failures = 0;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_Failures++;                                                            \
+        }                                                                            \
+    } while (0)
+
+// Fails the whole run if the scenarios do not finish in time.
+class Watchdog {
+public:
+    explicit Watchdog(std::chrono::seconds limit) : thread([this, limit] {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!finished.wait_for(lock, limit, [this] { return done; })) {
+            fprintf(stderr, "deadlock: still running after %lld s in \"%s\"\n", (long long)limit.count(), scenario.load());
+            std::_Exit(2);
+        }
+    }) {}
+
+    ~Watchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        finished.notify_one();
+        thread.join();
+    }
+
+    void Enter(const char* name) { scenario.store(name); }
+
+private:
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::atomic<const char*> scenario{ "" };
+    std::thread thread;
+};
+
+// parallel_for three levels deep; every leaf is counted exactly once.
+static void NestedParallelFor(ThreadPool& pool) {
+    std::atomic<size_t> leaves{ 0 };
+    pool.parallel_for(8, [&](size_t) {
+        pool.parallel_for(8, [&](size_t) {
+            pool.parallel_for(8, [&](size_t) { leaves++; });
+        });
+    });
+    CHECK(leaves.load() == 8 * 8 * 8);
+}
+
+// A tree of TaskGroups: every node opens a group for its children and waits.
+static void Spawn(ThreadPool& pool, int depth, std::atomic<size_t>& nodes) {
+    nodes++;
+    if (depth == 0) return;
+    ThreadPool::TaskGroup group(&pool);
+    for (int i = 0; i < 4; ++i) group.run([&pool, depth, &nodes] { Spawn(pool, depth - 1, nodes); });
+    group.wait();
+}
+
+static void NestedTaskGroups(ThreadPool& pool) {
+    std::atomic<size_t> nodes{ 0 };
+    ThreadPool::TaskGroup root(&pool);
+    root.run([&] { Spawn(pool, 5, nodes); });
+    root.wait();
+    CHECK(nodes.load() == 1 + 4 + 16 + 64 + 256 + 1024);
+}
+
+// Pool tasks that hold a lock across parallel_for_isolated, while other
+// queued tasks wait for the same lock. A helping wait could pick up one of
+// those and block on the lock its own thread holds.
+static void IsolatedUnderLock(ThreadPool& pool) {
+    std::mutex lock;
+    std::atomic<size_t> work{ 0 }, contenders{ 0 };
+    ThreadPool::TaskGroup group(&pool);
+    for (int i = 0; i < 16; ++i) {
+        group.run([&] {
+            std::lock_guard<std::mutex> held(lock);
+            pool.parallel_for_isolated(64, [&](size_t) { work++; });
+        });
+        group.run([&] {
+            std::lock_guard<std::mutex> held(lock);
+            contenders++;
+        });
+    }
+    group.wait();
+    CHECK(work.load() == 16 * 64);
+    CHECK(contenders.load() == 16);
+}
+
+// Every worker blocked on a lock the caller holds: the caller does all the work.
+static void IsolatedWithBlockedWorkers(ThreadPool& pool) {
+    std::mutex lock;
+    std::atomic<size_t> sum{ 0 };
+    {
+        std::lock_guard<std::mutex> held(lock);
+        for (size_t i = 0; i < pool.size() * 2; ++i) pool.submit([&lock] { std::lock_guard<std::mutex> l(lock); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pool.parallel_for_isolated(1000, [&](size_t i) { sum += i; });
+    }
+    CHECK(sum.load() == 999 * 1000 / 2);
+}
+
+// Isolated regions inside plain ones and the other way round.
+static void MixedNesting(ThreadPool& pool) {
+    std::atomic<size_t> count{ 0 };
+    pool.parallel_for(16, [&](size_t) {
+        pool.parallel_for_isolated(16, [&](size_t) {
+            pool.parallel_for(4, [&](size_t) { count++; });
+        });
+    });
+    CHECK(count.load() == 16 * 16 * 4);
+}
+
+// The first exception of a nested region reaches the outermost waiter.
+static void NestedExceptions(ThreadPool& pool) {
+    bool caught = false;
+    try {
+        pool.parallel_for(8, [&](size_t i) {
+            pool.parallel_for_isolated(8, [&](size_t j) {
+                if (i == 3 && j == 5) throw std::runtime_error("inner");
+            });
+        });
+    } catch (const std::runtime_error& ex) {
+        caught = std::string(ex.what()) == "inner";
+    }
+    CHECK(caught);
+}
+
+// A High group opened from Normal work only helps with High tasks, and
+// still finishes while Normal tasks are queued behind it.
+static void HighInsideNormal(ThreadPool& pool) {
+    std::atomic<size_t> high{ 0 }, normal{ 0 };
+    ThreadPool::TaskGroup background(&pool, ThreadPool::Priority::Normal);
+    for (int i = 0; i < 32; ++i) {
+        background.run([&] {
+            ThreadPool::TaskGroup urgent(&pool, ThreadPool::Priority::High);
+            for (int k = 0; k < 4; ++k) urgent.run([&] { high++; });
+            urgent.wait();
+            normal++;
+        });
+    }
+    background.wait();
+    CHECK(high.load() == 32 * 4);
+    CHECK(normal.load() == 32);
+}
+
+int main() {
+    Watchdog watchdog(std::chrono::seconds(90));
+
+    for (size_t workers : { 1, 2, 4 }) {
+        ThreadPool pool(workers, std::chrono::milliseconds(50));
+        for (int round = 0; round < 20; ++round) {
+            watchdog.Enter("nested parallel_for");
+            NestedParallelFor(pool);
+            watchdog.Enter("nested TaskGroups");
+            NestedTaskGroups(pool);
+            watchdog.Enter("parallel_for_isolated under a lock");
+            IsolatedUnderLock(pool);
+            watchdog.Enter("mixed nesting");
+            MixedNesting(pool);
+            watchdog.Enter("nested exceptions");
+            NestedExceptions(pool);
+            watchdog.Enter("High group inside Normal work");
+            HighInsideNormal(pool);
+        }
+        watchdog.Enter("parallel_for_isolated with blocked workers");
+        IsolatedWithBlockedWorkers(pool);
+        printf("%zu worker(s): ok\n", workers);
+    }
+
+    if (g_Failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_Failures);
+        return 1;
+    }
+    return 0;
+}